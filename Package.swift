@@ -24,6 +24,36 @@ let package = Package(
             exclude: [
                 "Services/SCPSession.cpp",
                 "Services/SCPSession.h",
+                "Services/SessionPool.cpp",
+                "Services/SessionPool.h",
+                "Services/SessionReactor.cpp",
+                "Services/SessionReactor.h",
+                "Services/TarStream.cpp",
+                "Services/TarStream.h",
+                "Services/DeltaSync.cpp",
+                "Services/DeltaSync.h",
+                "Services/TransferJournal.cpp",
+                "Services/TransferJournal.h",
+                "Services/LocalFileReader.cpp",
+                "Services/LocalFileReader.h",
+                "Services/LocalFileWriter.cpp",
+                "Services/LocalFileWriter.h",
+                "Services/BufferPool.cpp",
+                "Services/BufferPool.h",
+                "Services/TransferScheduler.cpp",
+                "Services/TransferScheduler.h",
+                "Services/ProgressTracker.cpp",
+                "Services/ProgressTracker.h",
+                "Services/SegmentHasher.cpp",
+                "Services/SegmentHasher.h",
+                "Services/RemoteListing.cpp",
+                "Services/RemoteListing.h",
+                "Services/DirectoryCache.cpp",
+                "Services/DirectoryCache.h",
+                "Services/DirectoryListing.cpp",
+                "Services/DirectoryListing.h",
+                "Services/DirectoryPrefetcher.cpp",
+                "Services/DirectoryPrefetcher.h",
                 "Services/SCPSessionBridge.mm",
                 "Services/SCPSessionBridge.h"
             ],
@@ -37,7 +67,7 @@ let package = Package(
             name: "SCPClientBridge",
             dependencies: [],
             path: "SCPClient/Sources/Services",
-            sources: ["SCPSessionBridge.mm", "SCPSession.cpp"],
+            sources: ["SCPSessionBridge.mm", "SCPSession.cpp", "SessionPool.cpp", "SessionReactor.cpp", "TarStream.cpp", "DeltaSync.cpp", "TransferJournal.cpp", "LocalFileReader.cpp", "LocalFileWriter.cpp", "BufferPool.cpp", "TransferScheduler.cpp", "ProgressTracker.cpp", "SegmentHasher.cpp", "RemoteListing.cpp", "DirectoryCache.cpp", "DirectoryListing.cpp", "DirectoryPrefetcher.cpp"],
             publicHeadersPath: ".",
             cxxSettings: [
                 .headerSearchPath("."),
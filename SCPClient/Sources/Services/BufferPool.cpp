@@ -0,0 +1,107 @@
+//
+//  BufferPool.cpp
+//  SCP Client for macOS
+//
+//  Implémentation du pool de tampons
+//
+
+#include "BufferPool.h"
+#include <unistd.h>
+#include <cstdlib>
+#include <new>
+
+namespace SCPClient {
+
+// MARK: - Buffer
+
+BufferPool::Buffer::Buffer(Buffer&& other) noexcept
+    : pool(other.pool), bytes(other.bytes), capacity(other.capacity), length(other.length) {
+    other.bytes = nullptr;
+}
+
+BufferPool::Buffer& BufferPool::Buffer::operator=(Buffer&& other) noexcept {
+    if (this != &other) {
+        if (bytes) pool->release(bytes, capacity);
+        pool = other.pool;
+        bytes = other.bytes;
+        capacity = other.capacity;
+        length = other.length;
+        other.bytes = nullptr;
+    }
+    return *this;
+}
+
+BufferPool::Buffer::~Buffer() {
+    if (bytes) pool->release(bytes, capacity);
+}
+
+// MARK: - BufferPool
+
+BufferPool& BufferPool::shared() {
+    // Jamais détruit : des sessions du pool, elles aussi jamais détruites,
+    // peuvent encore tenir des tampons à la sortie
+    static BufferPool* pool = new BufferPool();
+    return *pool;
+}
+
+BufferPool::Buffer BufferPool::acquire(size_t size) {
+    static const size_t page = (size_t)sysconf(_SC_PAGESIZE);
+    size_t capacity = page;
+    while (capacity < size) capacity *= 2;
+
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        auto found = idle.find(capacity);
+        if (found != idle.end() && !found->second.empty()) {
+            char* bytes = found->second.back();
+            found->second.pop_back();
+            idleTotal -= capacity;
+            return Buffer(this, bytes, capacity, size);
+        }
+    }
+
+    void* bytes = nullptr;
+    if (posix_memalign(&bytes, page, capacity) != 0) throw std::bad_alloc();
+    return Buffer(this, (char*)bytes, capacity, size);
+}
+
+void BufferPool::release(char* bytes, size_t capacity) {
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        if (idleTotal + capacity <= idleLimit) {
+            idle[capacity].push_back(bytes);
+            idleTotal += capacity;
+            return;
+        }
+    }
+    free(bytes);
+}
+
+void BufferPool::setIdleLimit(size_t bytes) {
+    std::lock_guard<std::mutex> lock(mutex);
+    idleLimit = bytes;
+    shrink(idleLimit);
+}
+
+size_t BufferPool::idleBytes() const {
+    std::lock_guard<std::mutex> lock(mutex);
+    return idleTotal;
+}
+
+void BufferPool::trim() {
+    std::lock_guard<std::mutex> lock(mutex);
+    shrink(0);
+}
+
+void BufferPool::shrink(size_t target) {
+    // Les plus grands tampons d'abord
+    for (auto it = idle.rbegin(); it != idle.rend() && idleTotal > target; ++it) {
+        while (!it->second.empty() && idleTotal > target) {
+            free(it->second.back());
+            it->second.pop_back();
+            idleTotal -= it->first;
+        }
+    }
+}
+
+} // namespace SCPClient
@@ -0,0 +1,79 @@
+//
+//  BufferPool.h
+//  SCP Client for macOS
+//
+//  Tampons d'E/S alignés sur la page, recyclés entre transferts
+//
+
+#ifndef BufferPool_h
+#define BufferPool_h
+
+#include <cstddef>
+#include <map>
+#include <mutex>
+#include <vector>
+
+namespace SCPClient {
+
+// Les capacités sont arrondies à une puissance de deux (une page au moins) :
+// un tampon rendu resservira au prochain transfert de même taille de bloc,
+// sans allocation. Au-delà de la limite de mémoire au repos, les tampons
+// rendus sont libérés.
+class BufferPool {
+public:
+    // Un paquet de canal SSH : sortie des commandes, petits fichiers
+    static const size_t packetSize = 32 * 1024;
+
+    // Tampon emprunté, rendu au pool à sa destruction
+    class Buffer {
+    public:
+        Buffer() = default;
+        Buffer(Buffer&& other) noexcept;
+        Buffer& operator=(Buffer&& other) noexcept;
+        ~Buffer();
+
+        Buffer(const Buffer&) = delete;
+        Buffer& operator=(const Buffer&) = delete;
+
+        char* data() const { return bytes; }
+        // Taille demandée (la capacité réelle peut être supérieure)
+        size_t size() const { return length; }
+        explicit operator bool() const { return bytes != nullptr; }
+
+    private:
+        friend class BufferPool;
+        Buffer(BufferPool* pool, char* bytes, size_t capacity, size_t length)
+            : pool(pool), bytes(bytes), capacity(capacity), length(length) {}
+
+        BufferPool* pool = nullptr;
+        char* bytes = nullptr;
+        size_t capacity = 0;
+        size_t length = 0;
+    };
+
+    static BufferPool& shared();
+
+    // Tampon d'au moins `size` octets (au moins un octet), aligné sur la page
+    Buffer acquire(size_t size);
+
+    // Mémoire gardée au repos (64 Mo par défaut, 0 : aucun recyclage)
+    void setIdleLimit(size_t bytes);
+    size_t idleBytes() const;
+    // Libère les tampons au repos
+    void trim();
+
+private:
+    BufferPool() = default;
+    void release(char* bytes, size_t capacity);
+    // Libère des tampons au repos jusqu'à `target` octets (verrou tenu)
+    void shrink(size_t target);
+
+    mutable std::mutex mutex;
+    std::map<size_t, std::vector<char*>> idle;   // par capacité
+    size_t idleTotal = 0;
+    size_t idleLimit = 64 * 1024 * 1024;
+};
+
+} // namespace SCPClient
+
+#endif /* BufferPool_h */
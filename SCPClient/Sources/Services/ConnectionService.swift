@@ -19,6 +19,23 @@ class ConnectionService: ObservableObject {
     @Published var transferTasks: [TransferTask] = []
     @Published var errorMessage: String?
 
+    // Shell du terminal : il appartient à la connexion et survit aux
+    // changements de vue, comme sa sortie
+    @Published var shellTranscript = TerminalTranscript()
+    @Published var isShellOpen = false
+    private var shellOpening = false
+
+    // Contrôle d'intégrité des transferts : seuls les segments différents
+    // sont renvoyés
+    var verifyTransfers = false {
+        didSet { bridge.setVerifyTransfers(verifyTransfers) }
+    }
+
+    // Préchargement en arrière-plan des sous-répertoires les plus probables
+    var prefetchDirectories = false {
+        didSet { bridge.setPrefetchDirectories(prefetchDirectories) }
+    }
+
     private var cancellables = Set<AnyCancellable>()
 
     // Connexion avec password
@@ -77,6 +94,8 @@ class ConnectionService: ObservableObject {
         currentConnection = nil
         currentDirectory = "/"
         remoteFiles = []
+        isShellOpen = false
+        shellTranscript = TerminalTranscript()
     }
 
     // Charger le contenu d'un répertoire
@@ -236,6 +255,68 @@ class ConnectionService: ObservableObject {
         try await loadDirectory(currentDirectory)
     }
     
+    // Supprimer un dossier et tout son contenu, sur le serveur
+    func removeTree(at path: String) async throws {
+        do {
+            try bridge.removeTree(atPath: path)
+        } catch {
+            throw NSError(domain: "ConnectionError", code: -1,
+                                  userInfo: [NSLocalizedDescriptionKey: error.localizedDescription])
+        }
+
+        try await loadDirectory(currentDirectory)
+    }
+
+    // Copier un élément sur le serveur, sans transfert
+    func copyItem(at path: String, to destination: String) async throws {
+        do {
+            try bridge.copyItem(atPath: path, toPath: destination)
+        } catch {
+            throw NSError(domain: "ConnectionError", code: -1,
+                                  userInfo: [NSLocalizedDescriptionKey: error.localizedDescription])
+        }
+
+        try await loadDirectory(currentDirectory)
+    }
+
+    // Déplacer ou renommer un élément sur le serveur
+    func moveItem(at path: String, to destination: String) async throws {
+        do {
+            try bridge.moveItem(atPath: path, toPath: destination)
+        } catch {
+            throw NSError(domain: "ConnectionError", code: -1,
+                                  userInfo: [NSLocalizedDescriptionKey: error.localizedDescription])
+        }
+
+        try await loadDirectory(currentDirectory)
+    }
+
+    // Supprimer plusieurs éléments en deux lots, fichiers puis dossiers ;
+    // retourne les chemins en échec avec leur erreur
+    @discardableResult
+    func deleteItems(_ files: [RemoteFile]) async throws -> [String: String] {
+        let filePaths = files.filter { !$0.isDirectory }.map(\.path)
+        // Les plus profonds d'abord
+        let directoryPaths = files.filter(\.isDirectory).map(\.path)
+            .sorted { $0.count > $1.count }
+
+        let failures = await withCheckedContinuation { continuation in
+            DispatchQueue.global(qos: .userInitiated).async {
+                var failures: [String: String] = [:]
+                if !filePaths.isEmpty {
+                    failures.merge(self.bridge.deleteFiles(atPaths: filePaths)) { first, _ in first }
+                }
+                if !directoryPaths.isEmpty {
+                    failures.merge(self.bridge.deleteDirectories(atPaths: directoryPaths)) { first, _ in first }
+                }
+                continuation.resume(returning: failures)
+            }
+        }
+
+        try await loadDirectory(currentDirectory)
+        return failures
+    }
+
     // Exécuter une commande SSH sur le serveur distant
     func executeCommand(_ command: String) async throws -> String {
         guard isConnected else {
@@ -250,4 +331,125 @@ class ConnectionService: ObservableObject {
             }
         }
     }
+
+    // Shell persistant du terminal (sans écho ni séquences de contrôle),
+    // ouvert hors du fil principal : l'ouverture attend le serveur. Sa sortie
+    // et sa fin vont dans shellTranscript, sur le fil principal.
+    @MainActor
+    func openShell(columns: Int, rows: Int) async {
+        guard isConnected, !isShellOpen, !shellOpening else { return }
+        shellOpening = true
+        defer { shellOpening = false }
+
+        let relay = CommandOutputRelay { [weak self] text, _ in
+            self?.shellTranscript.append(text)
+        }
+        do {
+            try await withCheckedThrowingContinuation { (continuation: CheckedContinuation<Void, Error>) in
+                DispatchQueue.global(qos: .userInitiated).async {
+                    do {
+                        try self.bridge.openShell(withTerminal: "dumb", columns: columns, rows: rows,
+                                                  echo: false,
+                                                  output: { text in
+                                                      relay.append(text, isError: false)
+                                                  },
+                                                  closed: { [weak self] status in
+                                                      DispatchQueue.main.async {
+                                                          self?.shellTranscript.append("\n(shell terminé, code de retour \(status))\n")
+                                                          self?.isShellOpen = false
+                                                      }
+                                                  })
+                        continuation.resume()
+                    } catch {
+                        continuation.resume(throwing: error)
+                    }
+                }
+            }
+            // Le shell a pu se terminer entre-temps
+            isShellOpen = bridge.isShellOpen()
+        } catch {
+            shellTranscript.append("Erreur: \(error.localizedDescription)\n")
+        }
+    }
+
+    @discardableResult
+    func sendToShell(_ input: String) -> Bool {
+        bridge.writeShell(input)
+    }
+
+    func resizeShell(columns: Int, rows: Int) {
+        bridge.resizeShell(columns: columns, rows: rows)
+    }
+
+    // Fermeture hors du fil principal : elle attend la fin du canal
+    @MainActor
+    func closeShell() async {
+        await withCheckedContinuation { continuation in
+            DispatchQueue.global(qos: .userInitiated).async {
+                self.bridge.closeShell()
+                continuation.resume()
+            }
+        }
+        isShellOpen = false
+    }
+}
+
+// Sortie d'une commande en attente d'affichage : un seul passage sur le fil
+// principal à la fois pour tout ce qui est arrivé entre-temps, et au plus
+// `limit` caractères gardés si l'interface ne suit pas (les plus anciens
+// sont abandonnés)
+private final class CommandOutputRelay {
+    private let lock = NSLock()
+    private let limit: Int
+    private let deliver: (String, Bool) -> Void
+    private var pending: [(text: String, isError: Bool)] = []
+    private var pendingCount = 0
+    private var scheduled = false
+
+    init(limit: Int = 256 * 1024, deliver: @escaping (String, Bool) -> Void) {
+        self.limit = limit
+        self.deliver = deliver
+    }
+
+    func append(_ text: String, isError: Bool) {
+        lock.lock()
+        defer { lock.unlock() }
+
+        if let last = pending.last, last.isError == isError {
+            pending[pending.count - 1].text += text
+        } else {
+            pending.append((text, isError))
+        }
+        pendingCount += text.count
+
+        while pendingCount > limit, let first = pending.first {
+            let excess = pendingCount - limit
+            let firstCount = first.text.count
+            if firstCount <= excess {
+                pending.removeFirst()
+                pendingCount -= firstCount
+            } else {
+                pending[0].text = String(first.text.dropFirst(excess))
+                pendingCount -= excess
+            }
+        }
+
+        if !scheduled {
+            scheduled = true
+            DispatchQueue.main.async { self.drain() }
+        }
+    }
+
+    private func drain() {
+        lock.lock()
+        let chunks = pending
+        pending = []
+        pendingCount = 0
+        scheduled = false
+        lock.unlock()
+
+        for chunk in chunks {
+            deliver(chunk.text, chunk.isError)
+        }
+    }
 }
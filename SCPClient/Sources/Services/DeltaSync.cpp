@@ -0,0 +1,426 @@
+//
+//  DeltaSync.cpp
+//  SCP Client for macOS
+//
+//  Implémentation de la synchronisation différentielle
+//
+
+#include "DeltaSync.h"
+#include <openssl/evp.h>
+#include <unistd.h>
+#include <algorithm>
+#include <cerrno>
+#include <cmath>
+#include <cstring>
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#elif defined(__aarch64__)
+#include <arm_neon.h>
+#endif
+
+namespace SCPClient {
+
+const char* const deltaSignatureScript =
+    "import sys, os, zlib, hashlib\n"
+    "path, size = sys.argv[1], int(sys.argv[2])\n"
+    "out = sys.stdout\n"
+    "try:\n"
+    "    f = open(path, 'rb')\n"
+    "except OSError:\n"
+    "    out.write('none\\n')\n"
+    "    sys.exit(0)\n"
+    "with f:\n"
+    "    out.write('sig %d\\n' % os.fstat(f.fileno()).st_size)\n"
+    "    while True:\n"
+    "        block = f.read(size)\n"
+    "        if not block:\n"
+    "            break\n"
+    "        out.write('%08x %s\\n' % (zlib.adler32(block), hashlib.sha256(block).hexdigest()[:32]))\n";
+
+const char* const deltaPatchScript =
+    "import sys, os, struct\n"
+    "path = sys.argv[1]\n"
+    "tmp = '%s.%d.delta' % (path, os.getpid())\n"
+    "inp = sys.stdin.buffer\n"
+    "def take(n):\n"
+    "    data = inp.read(n)\n"
+    "    if len(data) != n:\n"
+    "        raise EOFError('truncated delta stream')\n"
+    "    return data\n"
+    "try:\n"
+    "    with open(path, 'rb') as src, open(tmp, 'wb') as dst:\n"
+    "        while True:\n"
+    "            op = take(1)\n"
+    "            if op == b'C':\n"
+    "                offset, length = struct.unpack('>QI', take(12))\n"
+    "                src.seek(offset)\n"
+    "                while length:\n"
+    "                    data = src.read(min(length, 1 << 20))\n"
+    "                    if not data:\n"
+    "                        raise EOFError('copy past end of file')\n"
+    "                    dst.write(data)\n"
+    "                    length -= len(data)\n"
+    "            elif op == b'D':\n"
+    "                dst.write(take(struct.unpack('>I', take(4))[0]))\n"
+    "            elif op == b'E':\n"
+    "                break\n"
+    "            else:\n"
+    "                raise ValueError('bad delta opcode')\n"
+    "    os.chmod(tmp, os.stat(path).st_mode & 0o7777)\n"
+    "    os.replace(tmp, path)\n"
+    "except Exception as e:\n"
+    "    try:\n"
+    "        os.unlink(tmp)\n"
+    "    except OSError:\n"
+    "        pass\n"
+    "    sys.stderr.write('%s\\n' % e)\n"
+    "    sys.exit(1)\n";
+
+static const uint32_t adlerMod = 65521;
+
+// Plus grand segment dont la somme pondérée tient sur 32 bits (NMAX de zlib)
+static const size_t adlerSegment = 5552;
+
+size_t deltaBlockSize(uint64_t fileSize) {
+    size_t target = (size_t)std::sqrt((double)fileSize);
+    size_t blockSize = 2048;
+    while (blockSize < target && blockSize < 128 * 1024) {
+        blockSize <<= 1;
+    }
+    return blockSize;
+}
+
+// Somme des octets et somme des préfixes d'un segment multiple de 16 octets
+static void adlerSegmentSums(const unsigned char* data, size_t length,
+                             uint64_t& sum, uint64_t& prefixSum) {
+#if defined(__SSE2__)
+    const __m128i zero = _mm_setzero_si128();
+    const __m128i weightsLow = _mm_set_epi16(9, 10, 11, 12, 13, 14, 15, 16);
+    const __m128i weightsHigh = _mm_set_epi16(1, 2, 3, 4, 5, 6, 7, 8);
+    __m128i vA = zero, vP = zero, vT = zero;
+
+    for (size_t i = 0; i < length; i += 16) {
+        __m128i x = _mm_loadu_si128((const __m128i*)(data + i));
+        vP = _mm_add_epi32(vP, vA);
+        vA = _mm_add_epi32(vA, _mm_sad_epu8(x, zero));
+        __m128i low = _mm_madd_epi16(_mm_unpacklo_epi8(x, zero), weightsLow);
+        __m128i high = _mm_madd_epi16(_mm_unpackhi_epi8(x, zero), weightsHigh);
+        vT = _mm_add_epi32(vT, _mm_add_epi32(low, high));
+    }
+
+    uint32_t lanes[4];
+    uint64_t a = 0, p = 0, t = 0;
+    _mm_storeu_si128((__m128i*)lanes, vA);
+    for (uint32_t lane : lanes) a += lane;
+    _mm_storeu_si128((__m128i*)lanes, vP);
+    for (uint32_t lane : lanes) p += lane;
+    _mm_storeu_si128((__m128i*)lanes, vT);
+    for (uint32_t lane : lanes) t += lane;
+    sum = a;
+    prefixSum = 16 * p + t;
+#elif defined(__aarch64__)
+    static const uint8_t low[8] = {16, 15, 14, 13, 12, 11, 10, 9};
+    static const uint8_t high[8] = {8, 7, 6, 5, 4, 3, 2, 1};
+    const uint8x8_t weightsLow = vld1_u8(low);
+    const uint8x8_t weightsHigh = vld1_u8(high);
+    uint32x4_t vA = vdupq_n_u32(0), vP = vdupq_n_u32(0), vT = vdupq_n_u32(0);
+
+    for (size_t i = 0; i < length; i += 16) {
+        uint8x16_t x = vld1q_u8(data + i);
+        vP = vaddq_u32(vP, vA);
+        vA = vpadalq_u16(vA, vpaddlq_u8(x));
+        vT = vpadalq_u16(vT, vmull_u8(vget_low_u8(x), weightsLow));
+        vT = vpadalq_u16(vT, vmull_u8(vget_high_u8(x), weightsHigh));
+    }
+
+    sum = vaddvq_u32(vA);
+    prefixSum = 16 * (uint64_t)vaddvq_u32(vP) + vaddvq_u32(vT);
+#else
+    uint64_t a = 0, p = 0;
+    for (size_t i = 0; i < length; ++i) {
+        a += data[i];
+        p += a;
+    }
+    sum = a;
+    prefixSum = p;
+#endif
+}
+
+uint32_t adler32(const unsigned char* data, size_t length) {
+    uint64_t a = 1, b = 0;
+
+    while (length >= 16) {
+        size_t n = std::min(length, adlerSegment) & ~(size_t)15;
+        uint64_t sum, prefixSum;
+        adlerSegmentSums(data, n, sum, prefixSum);
+        b = (b + a * n + prefixSum) % adlerMod;
+        a = (a + sum) % adlerMod;
+        data += n;
+        length -= n;
+    }
+    for (size_t i = 0; i < length; ++i) {
+        a += data[i];
+        b += a;
+    }
+    return (uint32_t)(((b % adlerMod) << 16) | (a % adlerMod));
+}
+
+void strongChecksum(const unsigned char* data, size_t length, unsigned char out[16]) {
+    unsigned char digest[EVP_MAX_MD_SIZE];
+    unsigned int digestLength = 0;
+    EVP_Digest(data, length, digest, &digestLength, EVP_sha256(), nullptr);
+    memcpy(out, digest, 16);
+}
+
+// MARK: - SignatureParser
+
+static int hexValue(char c) {
+    if (c >= '0' && c <= '9') return c - '0';
+    if (c >= 'a' && c <= 'f') return c - 'a' + 10;
+    if (c >= 'A' && c <= 'F') return c - 'A' + 10;
+    return -1;
+}
+
+bool SignatureParser::feed(const char* data, size_t length) {
+    const char* end = data + length;
+    while (data < end && !invalid) {
+        const char* newline = (const char*)memchr(data, '\n', end - data);
+        if (!newline) {
+            partial.append(data, end - data);
+            break;
+        }
+        partial.append(data, newline - data);
+        if (!parseLine(partial)) invalid = true;
+        partial.clear();
+        data = newline + 1;
+    }
+    return !invalid;
+}
+
+bool SignatureParser::complete(size_t blockSize) const {
+    if (invalid || !headerSeen || !partial.empty()) return false;
+    return !exists || blocks.size() == (remoteSize + blockSize - 1) / blockSize;
+}
+
+bool SignatureParser::parseLine(const std::string& line) {
+    if (!headerSeen) {
+        headerSeen = true;
+        if (line == "none") return true;
+        if (line.compare(0, 4, "sig ") != 0) return false;
+        exists = true;
+        remoteSize = strtoull(line.c_str() + 4, nullptr, 10);
+        return true;
+    }
+
+    // "xxxxxxxx " + 32 chiffres hexadécimaux
+    if (!exists || line.size() != 8 + 1 + 32 || line[8] != ' ') return false;
+    BlockSignature block;
+    block.weak = 0;
+    for (size_t i = 0; i < 8; ++i) {
+        int v = hexValue(line[i]);
+        if (v < 0) return false;
+        block.weak = (block.weak << 4) | (uint32_t)v;
+    }
+    for (size_t i = 0; i < 16; ++i) {
+        int high = hexValue(line[9 + 2 * i]);
+        int low = hexValue(line[10 + 2 * i]);
+        if (high < 0 || low < 0) return false;
+        block.strong[i] = (unsigned char)((high << 4) | low);
+    }
+    blocks.push_back(block);
+    return true;
+}
+
+// MARK: - DeltaEncoder
+
+static uint32_t bucketOf(uint32_t weak) {
+    return (weak ^ (weak >> 16)) & 0xffff;
+}
+
+static void putBigEndian(std::string& out, uint64_t value, int bytes) {
+    for (int i = bytes - 1; i >= 0; --i) {
+        out += (char)((value >> (8 * i)) & 0xff);
+    }
+}
+
+DeltaEncoder::DeltaEncoder(int fd, uint64_t size, size_t blockSize,
+                           const std::vector<BlockSignature>& blocks, uint64_t remoteSize)
+    : fd(fd), size(size), blockSize(blockSize), blocks(blocks), remoteSize(remoteSize),
+      bucketStart(65537, 0), window(std::max<size_t>(4 * 1024 * 1024, 4 * blockSize)) {
+    // Tri par seau (comptage)
+    for (const BlockSignature& block : blocks) {
+        ++bucketStart[bucketOf(block.weak) + 1];
+    }
+    for (size_t i = 1; i < bucketStart.size(); ++i) {
+        bucketStart[i] += bucketStart[i - 1];
+    }
+    bucketBlocks.resize(blocks.size());
+    std::vector<uint32_t> next(bucketStart.begin(), bucketStart.end() - 1);
+    for (uint32_t i = 0; i < blocks.size(); ++i) {
+        bucketBlocks[next[bucketOf(blocks[i].weak)]++] = i;
+    }
+
+    for (uint32_t x = 0; x < 256; ++x) {
+        rollOut[x] = (uint32_t)((uint64_t)blockSize * x % adlerMod);
+    }
+}
+
+// Bloc distant de même contenu, en privilégiant la suite du dernier trouvé
+long DeltaEncoder::lookup(uint32_t weak, const unsigned char* data, size_t length) {
+    uint32_t bucket = bucketOf(weak);
+    uint32_t begin = bucketStart[bucket], end = bucketStart[bucket + 1];
+    if (begin == end) return -1;
+
+    bool hashed = false;
+    unsigned char strong[16];
+    long found = -1;
+    for (uint32_t i = begin; i < end; ++i) {
+        uint32_t index = bucketBlocks[i];
+        const BlockSignature& block = blocks[index];
+        uint64_t blockLength = std::min<uint64_t>(blockSize, remoteSize - (uint64_t)index * blockSize);
+        if (block.weak != weak || blockLength != length) continue;
+        if (!hashed) {
+            strongChecksum(data, length, strong);
+            hashed = true;
+        }
+        if (memcmp(block.strong, strong, 16) != 0) continue;
+        if ((long)index == expected) return index;
+        if (found < 0) found = index;
+    }
+    return found;
+}
+
+// Recharge la fenêtre ; les données littérales en attente sont émises avant
+// d'être décalées
+bool DeltaEncoder::fill(std::string& out) {
+    if (localEof) return true;
+    if (pos > 0) {
+        flushLiteral(out);
+        memmove(window.data(), window.data() + pos, filled - pos);
+        windowOffset += pos;
+        filled -= pos;
+        literalStart = 0;
+        pos = 0;
+    }
+    while (filled < window.size()) {
+        ssize_t nread = read(fd, window.data() + filled, window.size() - filled);
+        if (nread < 0) {
+            if (errno == EINTR) continue;
+            error = "Read error on local file at offset " + std::to_string(windowOffset + filled);
+            return false;
+        }
+        if (nread == 0) {
+            localEof = true;
+            break;
+        }
+        filled += nread;
+    }
+    return true;
+}
+
+void DeltaEncoder::flushCopy(std::string& out) {
+    if (copyLength == 0) return;
+    out += 'C';
+    putBigEndian(out, copyOffset, 8);
+    putBigEndian(out, copyLength, 4);
+    copyLength = 0;
+}
+
+void DeltaEncoder::flushLiteral(std::string& out) {
+    if (pos == literalStart) return;
+    flushCopy(out);
+    const size_t maxChunk = 1024 * 1024;
+    while (literalStart < pos) {
+        size_t length = std::min(pos - literalStart, maxChunk);
+        out += 'D';
+        putBigEndian(out, length, 4);
+        out.append((const char*)window.data() + literalStart, length);
+        literalStart += length;
+        literalBytes += length;
+    }
+}
+
+void DeltaEncoder::addCopy(uint64_t offset, uint32_t length, std::string& out) {
+    if (copyLength > 0 && copyOffset + copyLength == offset && copyLength + length < (1u << 30)) {
+        copyLength += length;
+    } else {
+        flushCopy(out);
+        copyOffset = offset;
+        copyLength = length;
+    }
+    matchedBytes += length;
+}
+
+bool DeltaEncoder::produce(std::string& out, size_t target, bool& eof) {
+    while (out.size() < target) {
+        if (filled - pos <= blockSize && !localEof) {
+            if (!fill(out)) return false;
+        }
+
+        size_t available = filled - pos;
+        if (available < blockSize) {
+            // Fin du fichier : seul le dernier bloc distant (plus court) peut
+            // encore correspondre
+            if (available > 0) {
+                long index = lookup(adler32(window.data() + pos, available), window.data() + pos, available);
+                if (index >= 0) {
+                    flushLiteral(out);
+                    addCopy((uint64_t)index * blockSize, (uint32_t)available, out);
+                    pos += available;
+                    literalStart = pos;
+                }
+            }
+            pos = filled;
+            flushLiteral(out);
+            flushCopy(out);
+            out += 'E';
+            eof = true;
+            return true;
+        }
+
+        if (!rolling) {
+            uint32_t weak = adler32(window.data() + pos, blockSize);
+            a = weak & 0xffff;
+            b = weak >> 16;
+            rolling = true;
+        }
+
+        long index = lookup((b << 16) | a, window.data() + pos, blockSize);
+        if (index >= 0) {
+            flushLiteral(out);
+            addCopy((uint64_t)index * blockSize, (uint32_t)blockSize, out);
+            expected = index + 1;
+            pos += blockSize;
+            literalStart = pos;
+            rolling = false;
+            continue;
+        }
+
+        // Fenêtre suivante : un octet sort, un octet entre
+        if (available == blockSize) {
+            ++pos;
+            rolling = false;
+            continue;
+        }
+        uint32_t out8 = window[pos];
+        uint32_t in8 = window[pos + blockSize];
+        int32_t na = (int32_t)a - (int32_t)out8 + (int32_t)in8;
+        if (na < 0) na += adlerMod;
+        else if (na >= (int32_t)adlerMod) na -= adlerMod;
+        int64_t nb = (int64_t)b - rollOut[out8] + na - 1;
+        while (nb < 0) nb += adlerMod;
+        while (nb >= (int64_t)adlerMod) nb -= adlerMod;
+        a = (uint32_t)na;
+        b = (uint32_t)nb;
+        ++pos;
+
+        // Borne la mémoire des littéraux en attente
+        if (pos - literalStart >= 1024 * 1024) {
+            flushLiteral(out);
+        }
+    }
+    return true;
+}
+
+} // namespace SCPClient
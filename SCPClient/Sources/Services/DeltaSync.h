@@ -0,0 +1,113 @@
+//
+//  DeltaSync.h
+//  SCP Client for macOS
+//
+//  Synchronisation différentielle type rsync : signatures de blocs
+//  (Adler-32 roulant + SHA-256 tronqué), recherche des blocs déjà présents
+//  côté serveur et flux d'instructions copie/données pour l'assistant distant
+//
+
+#ifndef DeltaSync_h
+#define DeltaSync_h
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace SCPClient {
+
+// Scripts python3 exécutés côté serveur (argv : chemin [taille de bloc])
+extern const char* const deltaSignatureScript;
+extern const char* const deltaPatchScript;
+
+// Taille de bloc : environ la racine de la taille du fichier, puissance de 2
+// entre 2 Ko et 128 Ko
+size_t deltaBlockSize(uint64_t fileSize);
+
+// Adler-32, identique à zlib.adler32 ; noyau SSE2 ou NEON selon la cible
+uint32_t adler32(const unsigned char* data, size_t length);
+
+// SHA-256 tronqué à 16 octets (libcrypto, accéléré matériellement)
+void strongChecksum(const unsigned char* data, size_t length, unsigned char out[16]);
+
+struct BlockSignature {
+    uint32_t weak;
+    unsigned char strong[16];
+};
+
+// Sortie de l'assistant de signatures, lue au fil de l'eau :
+// "none" si le fichier n'existe pas, sinon "sig <taille>" puis une ligne
+// "<adler32 hex> <sha256 tronqué hex>" par bloc
+class SignatureParser {
+public:
+    bool feed(const char* data, size_t length);
+    bool complete(size_t blockSize) const;
+
+    bool exists = false;
+    uint64_t remoteSize = 0;
+    std::vector<BlockSignature> blocks;
+
+private:
+    bool parseLine(const std::string& line);
+
+    std::string partial;
+    bool headerSeen = false;
+    bool invalid = false;
+};
+
+// Parcourt le fichier local avec une somme roulante et produit les
+// instructions : 'C' <offset u64> <longueur u32> copie depuis l'ancien
+// fichier, 'D' <longueur u32> <octets> données, 'E' fin (big-endian)
+class DeltaEncoder {
+public:
+    DeltaEncoder(int fd, uint64_t size, size_t blockSize,
+                 const std::vector<BlockSignature>& blocks, uint64_t remoteSize);
+
+    // Ajoute des instructions à `out` jusqu'à environ `target` octets ;
+    // eof une fois l'instruction de fin écrite
+    bool produce(std::string& out, size_t target, bool& eof);
+
+    uint64_t processed() const { return windowOffset + pos; }
+    uint64_t literalBytes = 0;
+    uint64_t matchedBytes = 0;
+    std::string error;
+
+private:
+    bool fill(std::string& out);
+    long lookup(uint32_t weak, const unsigned char* data, size_t length);
+    void flushLiteral(std::string& out);
+    void flushCopy(std::string& out);
+    void addCopy(uint64_t offset, uint32_t length, std::string& out);
+
+    int fd;
+    uint64_t size;
+    size_t blockSize;
+    const std::vector<BlockSignature>& blocks;
+    uint64_t remoteSize;
+
+    // Blocs groupés par 16 bits de somme faible
+    std::vector<uint32_t> bucketStart;
+    std::vector<uint32_t> bucketBlocks;
+    uint32_t rollOut[256];   // (blockSize * x) mod 65521
+    long expected = -1;      // bloc suivant le dernier trouvé
+
+    // Fenêtre glissante sur le fichier local
+    std::vector<unsigned char> window;
+    uint64_t windowOffset = 0;
+    size_t filled = 0;
+    size_t pos = 0;
+    size_t literalStart = 0;
+    bool localEof = false;
+
+    uint32_t a = 0;
+    uint32_t b = 0;
+    bool rolling = false;
+
+    uint64_t copyOffset = 0;
+    uint64_t copyLength = 0;
+};
+
+} // namespace SCPClient
+
+#endif /* DeltaSync_h */
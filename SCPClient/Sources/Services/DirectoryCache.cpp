@@ -0,0 +1,140 @@
+//
+//  DirectoryCache.cpp
+//  SCP Client for macOS
+//
+//  Implémentation du cache des listages
+//
+
+#include "DirectoryCache.h"
+#include <ctime>
+
+namespace SCPClient {
+
+void DirectoryCache::configure(std::chrono::seconds newTtl, size_t newMaxDirectories,
+                               size_t newMaxEntries) {
+    std::lock_guard<std::mutex> lock(mutex);
+    ttl = newTtl;
+    maxDirectories = newMaxDirectories;
+    maxEntries = newMaxEntries;
+    if (ttl.count() <= 0) {
+        entries.clear();
+        index.clear();
+        totalFiles = 0;
+    } else {
+        evict();
+    }
+}
+
+bool DirectoryCache::enabled() const {
+    std::lock_guard<std::mutex> lock(mutex);
+    return ttl.count() > 0;
+}
+
+std::string DirectoryCache::normalize(const std::string& path) {
+    std::string result = path;
+    while (result.size() > 1 && result.back() == '/') result.pop_back();
+    return result;
+}
+
+DirectoryCache::Lookup DirectoryCache::lookup(const std::string& path,
+                                              DirectoryListing& listing, int64_t& mtime) {
+    std::lock_guard<std::mutex> lock(mutex);
+    auto found = index.find(normalize(path));
+    if (found == index.end()) return Lookup::Miss;
+
+    // Accès récent : en tête de liste
+    entries.splice(entries.begin(), entries, found->second);
+    const Entry& entry = *found->second;
+    listing = entry.listing;
+    mtime = entry.mtime;
+    return Clock::now() < entry.expires ? Lookup::Fresh : Lookup::Expired;
+}
+
+bool DirectoryCache::revalidate(const std::string& path, int64_t mtime) {
+    std::lock_guard<std::mutex> lock(mutex);
+    auto found = index.find(normalize(path));
+    if (found == index.end()) return false;
+
+    Entry& entry = *found->second;
+    if (entry.mtime < 0 || mtime != entry.mtime || mtime >= entry.listedAt) return false;
+    entry.expires = Clock::now() + ttl;
+    return true;
+}
+
+uint64_t DirectoryCache::generation() const {
+    std::lock_guard<std::mutex> lock(mutex);
+    return invalidations;
+}
+
+void DirectoryCache::store(const std::string& path, const DirectoryListing& listing,
+                           int64_t mtime, uint64_t listedGeneration) {
+    std::lock_guard<std::mutex> lock(mutex);
+    if (ttl.count() <= 0 || listing.size() > maxEntries || listedGeneration != invalidations) return;
+
+    std::string key = normalize(path);
+    auto found = index.find(key);
+    if (found != index.end()) {
+        totalFiles -= found->second->listing.size();
+        entries.erase(found->second);
+        index.erase(found);
+    }
+
+    entries.push_front({key, listing, mtime, (int64_t)time(nullptr), Clock::now() + ttl});
+    index[key] = entries.begin();
+    totalFiles += listing.size();
+    evict();
+}
+
+void DirectoryCache::invalidate(const std::string& path) {
+    std::lock_guard<std::mutex> lock(mutex);
+    ++invalidations;
+    auto found = index.find(normalize(path));
+    if (found == index.end()) return;
+    totalFiles -= found->second->listing.size();
+    entries.erase(found->second);
+    index.erase(found);
+}
+
+void DirectoryCache::invalidateParent(const std::string& path) {
+    std::string key = normalize(path);
+    size_t slash = key.rfind('/');
+    if (slash == std::string::npos) {
+        invalidate(".");
+    } else {
+        invalidate(slash == 0 ? "/" : key.substr(0, slash));
+    }
+}
+
+void DirectoryCache::invalidateTree(const std::string& path) {
+    std::lock_guard<std::mutex> lock(mutex);
+    ++invalidations;
+    std::string key = normalize(path);
+    std::string prefix = key == "/" ? key : key + "/";
+    for (auto it = entries.begin(); it != entries.end();) {
+        if (it->path == key || it->path.compare(0, prefix.size(), prefix) == 0) {
+            totalFiles -= it->listing.size();
+            index.erase(it->path);
+            it = entries.erase(it);
+        } else {
+            ++it;
+        }
+    }
+}
+
+void DirectoryCache::clear() {
+    std::lock_guard<std::mutex> lock(mutex);
+    ++invalidations;
+    entries.clear();
+    index.clear();
+    totalFiles = 0;
+}
+
+void DirectoryCache::evict() {
+    while (!entries.empty() && (entries.size() > maxDirectories || totalFiles > maxEntries)) {
+        totalFiles -= entries.back().listing.size();
+        index.erase(entries.back().path);
+        entries.pop_back();
+    }
+}
+
+} // namespace SCPClient
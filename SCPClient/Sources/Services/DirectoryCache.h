@@ -0,0 +1,78 @@
+//
+//  DirectoryCache.h
+//  SCP Client for macOS
+//
+//  Cache des listages de répertoires d'une session : durée de validité,
+//  limites de taille (LRU) et invalidation par chemin
+//
+
+#ifndef DirectoryCache_h
+#define DirectoryCache_h
+
+#include "DirectoryListing.h"
+#include <chrono>
+#include <list>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+
+namespace SCPClient {
+
+class DirectoryCache {
+public:
+    using Clock = std::chrono::steady_clock;
+
+    // ttl nul : cache désactivé
+    void configure(std::chrono::seconds ttl, size_t maxDirectories, size_t maxEntries);
+    bool enabled() const;
+
+    enum class Lookup { Miss, Fresh, Expired };
+
+    // Expired : `listing` est rempli mais doit être revalidé ; `mtime` est
+    // alors la date du répertoire au moment du listage (-1 si inconnue)
+    Lookup lookup(const std::string& path, DirectoryListing& listing, int64_t& mtime);
+
+    // Revalidation : le répertoire n'a pas changé depuis le listage si sa
+    // date est identique et antérieure au listage (résolution d'une seconde)
+    bool revalidate(const std::string& path, int64_t mtime);
+
+    // Compteur d'invalidations : un listage commencé avant une invalidation
+    // n'est pas stocké (il peut précéder la modification)
+    uint64_t generation() const;
+    void store(const std::string& path, const DirectoryListing& listing, int64_t mtime,
+               uint64_t listedGeneration);
+
+    void invalidate(const std::string& path);
+    // Le répertoire contenant `path`
+    void invalidateParent(const std::string& path);
+    // `path` et tous ses sous-répertoires
+    void invalidateTree(const std::string& path);
+    void clear();
+
+    static std::string normalize(const std::string& path);
+
+private:
+    struct Entry {
+        std::string path;
+        DirectoryListing listing;
+        int64_t mtime;
+        int64_t listedAt;          // heure murale, comparée à mtime
+        Clock::time_point expires;
+    };
+
+    void evict();
+
+    mutable std::mutex mutex;
+    std::chrono::seconds ttl{0};
+    size_t maxDirectories = 256;
+    size_t maxEntries = 200000;
+
+    std::list<Entry> entries;      // du plus récent au plus ancien
+    std::unordered_map<std::string, std::list<Entry>::iterator> index;
+    size_t totalFiles = 0;
+    uint64_t invalidations = 0;
+};
+
+} // namespace SCPClient
+
+#endif /* DirectoryCache_h */
@@ -0,0 +1,144 @@
+//
+//  DirectoryListing.cpp
+//  SCP Client for macOS
+//
+//  Implémentation du listage compact
+//
+
+#include "DirectoryListing.h"
+#include <algorithm>
+#include <numeric>
+
+namespace SCPClient {
+
+DirectoryListing::DirectoryListing(const std::string& parentPath) {
+    reset(parentPath);
+}
+
+void DirectoryListing::reset(const std::string& parentPath) {
+    parent = parentPath;
+    prefix = parent.empty() || parent.back() == '/' ? parent : parent + "/";
+    names.clear();
+    nameOffsets.clear();
+    nameLengths.clear();
+    sizes.clear();
+    modes.clear();
+    mtimes.clear();
+    directories.clear();
+}
+
+void DirectoryListing::reserve(size_t entries, size_t nameBytes) {
+    names.reserve(nameBytes);
+    nameOffsets.reserve(entries);
+    nameLengths.reserve(entries);
+    sizes.reserve(entries);
+    modes.reserve(entries);
+    mtimes.reserve(entries);
+    directories.reserve(entries);
+}
+
+void DirectoryListing::append(const RemoteFile& file) {
+    append(file.name, file.size, file.permissions, file.isDirectory, file.modificationTime);
+}
+
+void DirectoryListing::append(std::string_view name, uint64_t size, uint32_t permissions,
+                              bool isDirectory, int64_t modificationTime) {
+    nameOffsets.push_back((uint32_t)names.size());
+    nameLengths.push_back((uint32_t)name.size());
+    names.append(name.data(), name.size());
+    sizes.push_back(size);
+    modes.push_back(permissions);
+    mtimes.push_back(modificationTime);
+    directories.push_back(isDirectory ? 1 : 0);
+}
+
+std::string DirectoryListing::path(size_t index) const {
+    std::string_view entryName = name(index);
+    std::string result;
+    result.reserve(prefix.size() + entryName.size());
+    result.append(prefix).append(entryName.data(), entryName.size());
+    return result;
+}
+
+void DirectoryListing::entry(size_t index, RemoteFile& file) const {
+    std::string_view entryName = name(index);
+    file.name.assign(entryName.data(), entryName.size());
+    file.path.assign(prefix).append(entryName.data(), entryName.size());
+    file.size = sizes[index];
+    file.permissions = modes[index];
+    file.isDirectory = directories[index] != 0;
+    file.modificationTime = mtimes[index];
+}
+
+std::vector<RemoteFile> DirectoryListing::toFiles() const {
+    std::vector<RemoteFile> files(size());
+    for (size_t i = 0; i < files.size(); ++i) {
+        entry(i, files[i]);
+    }
+    return files;
+}
+
+void DirectoryListing::sort(SortKey key, bool descending, bool directoriesFirst) {
+    std::vector<uint32_t> order(size());
+    std::iota(order.begin(), order.end(), 0);
+
+    auto compare = [&](uint32_t a, uint32_t b) {
+        if (directoriesFirst && directories[a] != directories[b]) {
+            return directories[a] > directories[b];
+        }
+        switch (key) {
+        case SortKey::Name:
+            return descending ? name(b) < name(a) : name(a) < name(b);
+        case SortKey::Size:
+            return descending ? sizes[b] < sizes[a] : sizes[a] < sizes[b];
+        case SortKey::ModificationTime:
+            return descending ? mtimes[b] < mtimes[a] : mtimes[a] < mtimes[b];
+        }
+        return false;
+    };
+    std::stable_sort(order.begin(), order.end(), compare);
+    gather(order);
+}
+
+void DirectoryListing::filter(const std::function<bool(const DirectoryListing& listing, size_t index)>& keep) {
+    std::vector<uint32_t> kept;
+    kept.reserve(size());
+    for (size_t i = 0; i < size(); ++i) {
+        if (keep(*this, i)) kept.push_back((uint32_t)i);
+    }
+    if (kept.size() != size()) gather(kept);
+}
+
+void DirectoryListing::gather(const std::vector<uint32_t>& order) {
+    std::string compactNames;
+    size_t nameBytes = 0;
+    for (uint32_t i : order) nameBytes += nameLengths[i];
+    compactNames.reserve(nameBytes);
+
+    std::vector<uint32_t> offsets(order.size());
+    std::vector<uint32_t> lengths(order.size());
+    std::vector<uint64_t> newSizes(order.size());
+    std::vector<uint32_t> newModes(order.size());
+    std::vector<int64_t> newMtimes(order.size());
+    std::vector<uint8_t> newDirectories(order.size());
+    for (size_t i = 0; i < order.size(); ++i) {
+        uint32_t from = order[i];
+        offsets[i] = (uint32_t)compactNames.size();
+        lengths[i] = nameLengths[from];
+        compactNames.append(names, nameOffsets[from], nameLengths[from]);
+        newSizes[i] = sizes[from];
+        newModes[i] = modes[from];
+        newMtimes[i] = mtimes[from];
+        newDirectories[i] = directories[from];
+    }
+
+    names.swap(compactNames);
+    nameOffsets.swap(offsets);
+    nameLengths.swap(lengths);
+    sizes.swap(newSizes);
+    modes.swap(newModes);
+    mtimes.swap(newMtimes);
+    directories.swap(newDirectories);
+}
+
+} // namespace SCPClient
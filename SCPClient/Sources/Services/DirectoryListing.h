@@ -0,0 +1,81 @@
+//
+//  DirectoryListing.h
+//  SCP Client for macOS
+//
+//  Listage compact d'un répertoire : noms dans une seule zone mémoire,
+//  chemin parent stocké une fois, attributs en colonnes
+//
+
+#ifndef DirectoryListing_h
+#define DirectoryListing_h
+
+#include "SCPSession.h"
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace SCPClient {
+
+// Une entrée coûte ~30 octets plus son nom, contre deux chaînes allouées
+// (nom et chemin complet) pour un RemoteFile. Les chemins complets sont
+// construits à la demande. Tri et filtre ne lisent que les colonnes utiles.
+class DirectoryListing {
+public:
+    enum class SortKey { Name, Size, ModificationTime };
+
+    DirectoryListing() = default;
+    explicit DirectoryListing(const std::string& parentPath);
+
+    // Vide le listage et change de répertoire parent
+    void reset(const std::string& parentPath);
+    void reserve(size_t entries, size_t nameBytes = 0);
+
+    void append(const RemoteFile& file);
+    void append(std::string_view name, uint64_t size, uint32_t permissions,
+                bool isDirectory, int64_t modificationTime);
+
+    size_t size() const { return sizes.size(); }
+    bool empty() const { return sizes.empty(); }
+    const std::string& parentPath() const { return parent; }
+
+    // Valide jusqu'à la prochaine modification du listage
+    std::string_view name(size_t index) const {
+        return std::string_view(names.data() + nameOffsets[index], nameLengths[index]);
+    }
+    uint64_t fileSize(size_t index) const { return sizes[index]; }
+    uint32_t permissions(size_t index) const { return modes[index]; }
+    bool isDirectory(size_t index) const { return directories[index] != 0; }
+    int64_t modificationTime(size_t index) const { return mtimes[index]; }
+
+    std::string path(size_t index) const;
+
+    // Remplit `file` en réutilisant ses chaînes
+    void entry(size_t index, RemoteFile& file) const;
+    std::vector<RemoteFile> toFiles() const;
+
+    // Tri stable ; répertoires en tête si demandé
+    void sort(SortKey key, bool descending = false, bool directoriesFirst = false);
+    // Garde les entrées pour lesquelles `keep` retourne true
+    void filter(const std::function<bool(const DirectoryListing& listing, size_t index)>& keep);
+
+private:
+    // Réordonne toutes les colonnes et recompacte les noms
+    void gather(const std::vector<uint32_t>& order);
+
+    std::string parent;
+    std::string prefix;                  // parent + '/'
+
+    std::string names;                   // noms bout à bout
+    std::vector<uint32_t> nameOffsets;
+    std::vector<uint32_t> nameLengths;
+    std::vector<uint64_t> sizes;
+    std::vector<uint32_t> modes;
+    std::vector<int64_t> mtimes;
+    std::vector<uint8_t> directories;
+};
+
+} // namespace SCPClient
+
+#endif /* DirectoryListing_h */
@@ -0,0 +1,128 @@
+//
+//  DirectoryPrefetcher.cpp
+//  SCP Client for macOS
+//
+//  Implémentation du préchargement des listages
+//
+
+#include "DirectoryPrefetcher.h"
+#include "DirectoryCache.h"
+#include <algorithm>
+
+namespace SCPClient {
+
+// Au-delà, les répertoires visités une seule fois sont oubliés
+static const size_t maxTrackedVisits = 4096;
+
+DirectoryPrefetcher::DirectoryPrefetcher(Lister lister) : lister(std::move(lister)) {
+}
+
+DirectoryPrefetcher::~DirectoryPrefetcher() {
+    stop();
+}
+
+void DirectoryPrefetcher::setPolicy(const PrefetchPolicy& newPolicy) {
+    std::lock_guard<std::mutex> lock(mutex);
+    policy = newPolicy;
+    wake.notify_all();
+}
+
+void DirectoryPrefetcher::recordVisit(const std::string& path) {
+    std::lock_guard<std::mutex> lock(mutex);
+    ++visits[DirectoryCache::normalize(path)];
+    if (visits.size() > maxTrackedVisits) {
+        for (auto it = visits.begin(); it != visits.end();) {
+            it = it->second <= 1 ? visits.erase(it) : std::next(it);
+        }
+        if (visits.size() > maxTrackedVisits) visits.clear();
+    }
+}
+
+void DirectoryPrefetcher::schedule(const DirectoryListing& listing) {
+    std::lock_guard<std::mutex> lock(mutex);
+    if (stopping || policy.maxChildren == 0) return;
+
+    struct Candidate {
+        std::string path;
+        int64_t modificationTime;
+        unsigned visits;
+    };
+    std::vector<Candidate> candidates;
+    for (size_t i = 0; i < listing.size(); ++i) {
+        if (!listing.isDirectory(i)) continue;
+        std::string path = listing.path(i);
+        auto found = visits.find(DirectoryCache::normalize(path));
+        candidates.push_back({std::move(path), listing.modificationTime(i),
+                              found == visits.end() ? 0 : found->second});
+    }
+
+    size_t count = std::min<size_t>(policy.maxChildren, candidates.size());
+    std::partial_sort(candidates.begin(), candidates.begin() + count, candidates.end(),
+                      [](const Candidate& a, const Candidate& b) {
+        if (a.visits != b.visits) return a.visits > b.visits;
+        return a.modificationTime > b.modificationTime;
+    });
+
+    // Les demandes du répertoire précédent ne sont plus les plus probables
+    queue.clear();
+    for (size_t i = 0; i < count; ++i) {
+        queue.push_back(std::move(candidates[i].path));
+    }
+
+    if (!worker.joinable()) {
+        worker = std::thread(&DirectoryPrefetcher::run, this);
+    }
+    wake.notify_all();
+}
+
+void DirectoryPrefetcher::stop() {
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        stopping = true;
+        queue.clear();
+        wake.notify_all();
+    }
+    if (worker.joinable()) worker.join();
+
+    // Relancé à la prochaine demande
+    std::lock_guard<std::mutex> lock(mutex);
+    stopping = false;
+}
+
+void DirectoryPrefetcher::run() {
+    const auto window = std::chrono::minutes(1);
+    std::unique_lock<std::mutex> lock(mutex);
+
+    while (!stopping) {
+        if (queue.empty()) {
+            wake.wait(lock);
+            continue;
+        }
+
+        // Budget glissant sur la dernière minute
+        Clock::time_point now = Clock::now();
+        while (!spent.empty() && now - spent.front().first >= window) spent.pop_front();
+        uint64_t bytes = 0;
+        for (const auto& request : spent) bytes += request.second;
+        if (spent.size() >= policy.maxRequestsPerMinute || bytes >= policy.maxBytesPerMinute) {
+            if (spent.empty()) {
+                queue.clear();   // budget nul
+            } else {
+                wake.wait_until(lock, spent.front().first + window);
+            }
+            continue;
+        }
+
+        std::string path = queue.front();
+        queue.pop_front();
+
+        lock.unlock();
+        uint64_t used = 0;
+        bool requested = lister(path, used);
+        lock.lock();
+
+        if (requested) spent.push_back({Clock::now(), used});
+    }
+}
+
+} // namespace SCPClient
@@ -0,0 +1,69 @@
+//
+//  DirectoryPrefetcher.h
+//  SCP Client for macOS
+//
+//  Préchargement spéculatif des sous-répertoires : après un listage, les
+//  sous-répertoires les plus probables sont listés en arrière-plan, dans un
+//  budget de requêtes et d'octets par minute
+//
+
+#ifndef DirectoryPrefetcher_h
+#define DirectoryPrefetcher_h
+
+#include "DirectoryListing.h"
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+namespace SCPClient {
+
+class DirectoryPrefetcher {
+public:
+    // Liste `path` et met le résultat en cache ; retourne false si aucune
+    // requête n'a été faite (déjà en cache, pas de session libre). `bytes` :
+    // volume estimé de la réponse.
+    using Lister = std::function<bool(const std::string& path, uint64_t& bytes)>;
+
+    explicit DirectoryPrefetcher(Lister lister);
+    ~DirectoryPrefetcher();
+
+    void setPolicy(const PrefetchPolicy& policy);
+
+    // Modèle de fréquence : répertoires ouverts par l'utilisateur
+    void recordVisit(const std::string& path);
+
+    // Remplace la file par les sous-répertoires de `listing` les plus
+    // visités, puis les plus récents
+    void schedule(const DirectoryListing& listing);
+
+    // Vide la file et attend la fin de la requête en cours
+    void stop();
+
+private:
+    using Clock = std::chrono::steady_clock;
+
+    void run();
+
+    Lister lister;
+    PrefetchPolicy policy;
+
+    std::mutex mutex;
+    std::condition_variable wake;
+    std::thread worker;
+    bool stopping = false;
+
+    std::deque<std::string> queue;
+    std::unordered_map<std::string, unsigned> visits;
+    // Requêtes de la dernière minute : instant et octets estimés
+    std::deque<std::pair<Clock::time_point, uint64_t>> spent;
+};
+
+} // namespace SCPClient
+
+#endif /* DirectoryPrefetcher_h */
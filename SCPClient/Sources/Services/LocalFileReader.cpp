@@ -0,0 +1,124 @@
+//
+//  LocalFileReader.cpp
+//  SCP Client for macOS
+//
+//  Implémentation de la lecture des fichiers locaux
+//
+
+#include "LocalFileReader.h"
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <algorithm>
+#include <cerrno>
+
+namespace SCPClient {
+
+// Pages rendues par lots, lecture anticipée par fenêtres
+static const uint64_t releaseStep = 8ull * 1024 * 1024;
+static const uint64_t readAheadWindow = 4ull * 1024 * 1024;
+
+LocalFileReader::LocalFileReader(int fd) : fd(fd) {
+    struct stat info;
+    if (fstat(fd, &info) != 0) return;
+    fileSize = (uint64_t)info.st_size;
+
+    if (S_ISREG(info.st_mode) && fileSize >= mapThreshold) {
+        void* mapped = mmap(nullptr, (size_t)fileSize, PROT_READ, MAP_SHARED, fd, 0);
+        if (mapped != MAP_FAILED) {
+            mapping = (char*)mapped;
+            madvise(mapping, (size_t)fileSize, MADV_SEQUENTIAL);
+            return;
+        }
+    }
+
+#ifdef __APPLE__
+    fcntl(fd, F_RDAHEAD, 1);
+#else
+    posix_fadvise(fd, 0, 0, POSIX_FADV_SEQUENTIAL);
+#endif
+}
+
+LocalFileReader::~LocalFileReader() {
+    if (mapping) munmap(mapping, (size_t)fileSize);
+}
+
+// Le fichier va-t-il toujours au moins jusqu'à `end` ?
+bool LocalFileReader::stillCovers(uint64_t end) {
+    if (shrunk) return false;
+    struct stat info;
+    if (fstat(fd, &info) != 0 || (uint64_t)info.st_size < end) shrunk = true;
+    return !shrunk;
+}
+
+const char* LocalFileReader::view(uint64_t offset, size_t& length) {
+    if (!mapping || offset >= fileSize) {
+        length = 0;
+        return nullptr;
+    }
+    length = (size_t)std::min<uint64_t>(length, fileSize - offset);
+    if (!stillCovers(offset + length)) {
+        length = 0;
+        return nullptr;
+    }
+    return mapping + offset;
+}
+
+void LocalFileReader::release(uint64_t upTo) {
+    if (!mapping) return;
+    uint64_t page = (uint64_t)sysconf(_SC_PAGESIZE);
+    uint64_t end = std::min(upTo, fileSize) / page * page;
+    if (end < released + releaseStep) return;
+    madvise(mapping + released, (size_t)(end - released), MADV_DONTNEED);
+    released = end;
+}
+
+void LocalFileReader::readAhead(uint64_t offset) {
+    if (offset + readAheadWindow / 2 < advised || offset >= fileSize) return;
+    uint64_t start = std::max(offset, advised);
+    uint64_t length = std::min(readAheadWindow, fileSize - start);
+#ifdef __APPLE__
+    struct radvisory advice;
+    advice.ra_offset = (off_t)start;
+    advice.ra_count = (int)length;
+    fcntl(fd, F_RDADVISE, &advice);
+#else
+    posix_fadvise(fd, (off_t)start, (off_t)length, POSIX_FADV_WILLNEED);
+#endif
+    advised = start + length;
+}
+
+ssize_t LocalFileReader::read(uint64_t offset, char* out, size_t length) {
+    readAhead(offset + length);
+    while (true) {
+        ssize_t nread = pread(fd, out, length, (off_t)offset);
+        if (nread < 0 && errno == EINTR) continue;
+        return nread;
+    }
+}
+
+ssize_t LocalFileReader::slice(uint64_t offset, size_t maxLength, const char*& out) {
+    if (mapping) {
+        if (offset >= fileSize) return 0;
+        size_t length = maxLength;
+        out = view(offset, length);
+        return out ? (ssize_t)length : -1;
+    }
+
+    // Reste d'un bloc déjà lu (écriture partielle de l'appelant)
+    if (offset >= bufferStart && offset < bufferStart + bufferLength) {
+        out = buffer.data() + (offset - bufferStart);
+        return (ssize_t)std::min<uint64_t>(maxLength, bufferStart + bufferLength - offset);
+    }
+
+    if (buffer.size() < maxLength) buffer = BufferPool::shared().acquire(maxLength);
+    ssize_t nread = read(offset, buffer.data(), maxLength);
+    if (nread <= 0) return nread;
+    bufferStart = offset;
+    bufferLength = (size_t)nread;
+    out = buffer.data();
+    return nread;
+}
+
+} // namespace SCPClient
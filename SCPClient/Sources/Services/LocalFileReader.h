@@ -0,0 +1,72 @@
+//
+//  LocalFileReader.h
+//  SCP Client for macOS
+//
+//  Lecture des fichiers locaux à envoyer : projection en mémoire des gros
+//  fichiers, lue directement par libssh2 ; pread avec lecture anticipée
+//  pour les autres
+//
+
+#ifndef LocalFileReader_h
+#define LocalFileReader_h
+
+#include "BufferPool.h"
+#include <sys/types.h>
+#include <cstdint>
+
+namespace SCPClient {
+
+// Au-delà de mapThreshold, un fichier régulier est projeté (MADV_SEQUENTIAL)
+// et ses octets passés à libssh2 sans copie ; les pages déjà acquittées sont
+// rendues au fil de l'envoi. En dessous, ou si la projection échoue, lecture
+// par pread, le noyau étant prévenu de la lecture séquentielle.
+// Lire une projection au-delà de la fin d'un fichier tronqué par un autre
+// processus provoque SIGBUS : la taille est revérifiée avant chaque bloc
+// rendu par view() ou slice(), et un fichier raccourci arrête la lecture.
+// Ne reste que l'intervalle entre ce contrôle et la lecture du bloc.
+class LocalFileReader {
+public:
+    static const uint64_t mapThreshold = 16ull * 1024 * 1024;
+
+    // `fd` reste à l'appelant
+    explicit LocalFileReader(int fd);
+    ~LocalFileReader();
+
+    LocalFileReader(const LocalFileReader&) = delete;
+    LocalFileReader& operator=(const LocalFileReader&) = delete;
+
+    bool isMapped() const { return mapping != nullptr; }
+    uint64_t size() const { return fileSize; }
+
+    // Projection : au plus `length` octets à partir de `offset`, après
+    // contrôle de la taille ; nullptr si le fichier ne les contient plus
+    const char* view(uint64_t offset, size_t& length);
+    // Projection : les pages avant `upTo` ne seront plus lues
+    void release(uint64_t upTo);
+
+    // Hors projection : pread, en demandant la suite au noyau
+    ssize_t read(uint64_t offset, char* buffer, size_t length);
+
+    // Bloc d'au plus maxLength octets à `offset`, dans la projection ou lu
+    // dans un tampon interne ; 0 en fin de fichier, -1 en erreur
+    ssize_t slice(uint64_t offset, size_t maxLength, const char*& out);
+
+private:
+    void readAhead(uint64_t offset);
+    bool stillCovers(uint64_t end);
+
+    int fd;
+    uint64_t fileSize = 0;
+    char* mapping = nullptr;
+    uint64_t released = 0;
+    uint64_t advised = 0;              // lecture anticipée demandée jusque-là
+    bool shrunk = false;               // projection plus lue
+
+    BufferPool::Buffer buffer;         // slice() hors projection
+    uint64_t bufferStart = 0;
+    size_t bufferLength = 0;
+};
+
+} // namespace SCPClient
+
+#endif /* LocalFileReader_h */
@@ -0,0 +1,170 @@
+//
+//  LocalFileWriter.cpp
+//  SCP Client for macOS
+//
+//  Implémentation de l'écriture des fichiers téléchargés
+//
+
+#include "LocalFileWriter.h"
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+
+namespace SCPClient {
+
+static bool isZero(const char* data, size_t length) {
+    return data[0] == 0 && memcmp(data, data + 1, length - 1) == 0;
+}
+
+void LocalFileWriter::prepare(int fd, uint64_t size, bool uncached) {
+    if (size == 0) return;
+#ifdef __APPLE__
+    fstore_t store = {F_ALLOCATECONTIG | F_ALLOCATEALL, F_PEOFPOSMODE, 0, (off_t)size, 0};
+    if (fcntl(fd, F_PREALLOCATE, &store) == -1) {
+        store.fst_flags = F_ALLOCATEALL;
+        fcntl(fd, F_PREALLOCATE, &store);
+    }
+    if (uncached && size >= uncachedThreshold) fcntl(fd, F_NOCACHE, 1);
+#else
+    // fallocate plutôt que posix_fallocate : pas d'émulation par écriture
+    // de zéros sur les systèmes de fichiers qui ne savent pas réserver
+    fallocate(fd, FALLOC_FL_KEEP_SIZE, 0, (off_t)size);
+    if (uncached && size >= uncachedThreshold) {
+        int flags = fcntl(fd, F_GETFL);
+        if (flags != -1) fcntl(fd, F_SETFL, flags | O_DIRECT);
+    }
+#endif
+}
+
+LocalFileWriter::LocalFileWriter(int fd, size_t count, FlushCallback onFlushed)
+    : fd(fd), streams(std::max<size_t>(1, count)), onFlushed(std::move(onFlushed)) {}
+
+bool LocalFileWriter::write(uint64_t offset, const char* data, size_t length) {
+    while (length > 0) {
+        // Suite d'un flux, sinon un flux libre ou le moins récemment utilisé
+        Stream* target = nullptr;
+        for (Stream& stream : streams) {
+            if (stream.length > 0 && stream.start + stream.length == offset) {
+                target = &stream;
+                break;
+            }
+        }
+        if (!target) {
+            target = &*std::min_element(streams.begin(), streams.end(),
+                                        [](const Stream& a, const Stream& b) {
+                if ((a.length == 0) != (b.length == 0)) return a.length == 0;
+                return a.lastUse < b.lastUse;
+            });
+            if (target->length > 0 && !flush(*target)) return false;
+            if (!target->buffer) target->buffer = BufferPool::shared().acquire(blockSize);
+            target->start = offset;
+        }
+        target->lastUse = ++uses;
+
+        // Le tampon s'arrête au prochain multiple de blockSize
+        uint64_t pos = target->start + target->length;
+        size_t amount = std::min(length, blockSize - (size_t)(pos % blockSize));
+        memcpy(target->buffer.data() + target->length, data, amount);
+        target->length += amount;
+        data += amount;
+        offset += amount;
+        length -= amount;
+        if ((pos + amount) % blockSize == 0 && !flush(*target)) return false;
+    }
+    return true;
+}
+
+bool LocalFileWriter::finish() {
+    for (Stream& stream : streams) {
+        if (stream.length > 0 && !flush(stream)) return false;
+    }
+    // Trou en fin de fichier : un octet nul écrit en dernier fixe la taille
+    struct stat info;
+    if (holeEnd > dataEnd && fstat(fd, &info) == 0 && (uint64_t)info.st_size < holeEnd) {
+        char zero = 0;
+        if (!writeRun(&zero, 1, holeEnd - 1)) return false;
+        dataEnd = holeEnd;
+    }
+    return true;
+}
+
+bool LocalFileWriter::flush(Stream& stream) {
+    uint64_t end = stream.start + stream.length;
+    auto emit = [&](uint64_t from, uint64_t to, bool hole) {
+        if (hole && punchHole(from, to - from)) {
+            holeEnd = std::max(holeEnd, to);
+            return true;
+        }
+        if (!writeRun(stream.buffer.data() + (from - stream.start), (size_t)(to - from), from)) {
+            return false;
+        }
+        dataEnd = std::max(dataEnd, to);
+        return true;
+    };
+
+    // Séries de tranches alignées de même nature (données / nulles)
+    uint64_t runStart = stream.start;
+    bool runHole = false;
+    for (uint64_t pos = stream.start; pos < end;) {
+        uint64_t next = std::min(end, (pos / holeSize + 1) * holeSize);
+        bool hole = canPunch && next - pos == holeSize &&
+                    isZero(stream.buffer.data() + (pos - stream.start), holeSize);
+        if (pos > runStart && hole != runHole) {
+            if (!emit(runStart, pos, runHole)) return false;
+            runStart = pos;
+        }
+        runHole = hole;
+        pos = next;
+    }
+    if (!emit(runStart, end, runHole)) return false;
+
+    if (onFlushed) onFlushed(stream.start, stream.length);
+    stream.length = 0;
+    return true;
+}
+
+bool LocalFileWriter::writeRun(const char* data, size_t length, uint64_t offset) {
+    while (length > 0) {
+        ssize_t written = pwrite(fd, data, length, (off_t)offset);
+        if (written < 0) {
+            if (errno == EINTR) continue;
+#ifdef O_DIRECT
+            // Écriture non alignée (début de reprise, fin de fichier) :
+            // retour définitif au cache de pages
+            if (errno == EINVAL) {
+                int flags = fcntl(fd, F_GETFL);
+                if (flags != -1 && (flags & O_DIRECT) &&
+                    fcntl(fd, F_SETFL, flags & ~O_DIRECT) == 0) {
+                    continue;
+                }
+                errno = EINVAL;
+            }
+#endif
+            return false;
+        }
+        data += written;
+        length -= written;
+        offset += written;
+    }
+    return true;
+}
+
+bool LocalFileWriter::punchHole(uint64_t offset, uint64_t length) {
+    if (!canPunch) return false;
+#ifdef __APPLE__
+    struct fpunchhole args = {0, 0, (off_t)offset, (off_t)length};
+    canPunch = fcntl(fd, F_PUNCHHOLE, &args) == 0;
+#else
+    // Un trou au-delà de la fin est ignoré : la taille est d'abord étendue
+    // (sans jamais réduire, sûr entre bandes), sur un espace déjà réservé
+    canPunch = fallocate(fd, 0, (off_t)offset, (off_t)length) == 0 &&
+               fallocate(fd, FALLOC_FL_PUNCH_HOLE | FALLOC_FL_KEEP_SIZE,
+                         (off_t)offset, (off_t)length) == 0;
+#endif
+    return canPunch;
+}
+
+} // namespace SCPClient
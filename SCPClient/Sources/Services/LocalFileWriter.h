@@ -0,0 +1,76 @@
+//
+//  LocalFileWriter.h
+//  SCP Client for macOS
+//
+//  Écriture des fichiers téléchargés : espace préalloué, écritures
+//  regroupées en blocs alignés, blocs nuls laissés en trous
+//
+
+#ifndef LocalFileWriter_h
+#define LocalFileWriter_h
+
+#include "BufferPool.h"
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <vector>
+
+namespace SCPClient {
+
+// Les données reçues sont accumulées par flux contigu (une voie SFTP, une
+// bande...) dans des tampons de blockSize octets pris au BufferPool (alignés
+// sur la page), vidés à des offsets multiples de blockSize. Au vidage,
+// chaque tranche de holeSize octets entièrement nulle n'est pas écrite : son
+// emplacement est libéré (trou), si bien qu'une image disque creuse le reste
+// une fois téléchargée.
+class LocalFileWriter {
+public:
+    static const size_t blockSize = 1024 * 1024;
+    static const size_t holeSize = 64 * 1024;
+    // En dessous, jamais d'écriture hors cache
+    static const uint64_t uncachedThreshold = 1024ull * 1024 * 1024;
+
+    // Plage effectivement écrite (ou laissée en trou)
+    using FlushCallback = std::function<void(uint64_t offset, uint64_t length)>;
+
+    // Fichier de `size` octets tout juste ouvert : espace réservé d'un bloc
+    // (fallocate / F_PREALLOCATE, taille apparente inchangée) et, si
+    // `uncached` et au-delà de uncachedThreshold, écritures hors cache de
+    // pages (O_DIRECT / F_NOCACHE). Sans effet si le système refuse.
+    static void prepare(int fd, uint64_t size, bool uncached);
+
+    // `fd` reste à l'appelant ; `streams` : flux contigus entrelacés au plus
+    explicit LocalFileWriter(int fd, size_t streams = 1, FlushCallback onFlushed = nullptr);
+
+    LocalFileWriter(const LocalFileWriter&) = delete;
+    LocalFileWriter& operator=(const LocalFileWriter&) = delete;
+
+    // Octets à `offset` ; false en erreur d'écriture (errno conservé)
+    bool write(uint64_t offset, const char* data, size_t length);
+    // Vide tous les tampons et étend le fichier sur un trou final
+    bool finish();
+
+private:
+    struct Stream {
+        BufferPool::Buffer buffer;
+        uint64_t start = 0;
+        size_t length = 0;
+        uint64_t lastUse = 0;
+    };
+
+    bool flush(Stream& stream);
+    bool writeRun(const char* data, size_t length, uint64_t offset);
+    bool punchHole(uint64_t offset, uint64_t length);
+
+    int fd;
+    std::vector<Stream> streams;
+    FlushCallback onFlushed;
+    uint64_t uses = 0;
+    uint64_t dataEnd = 0;    // fin de la dernière écriture
+    uint64_t holeEnd = 0;    // fin du dernier trou
+    bool canPunch = true;
+};
+
+} // namespace SCPClient
+
+#endif /* LocalFileWriter_h */
@@ -0,0 +1,155 @@
+//
+//  ProgressTracker.cpp
+//  SCP Client for macOS
+//
+//  Implémentation du suivi des transferts
+//
+
+#include "ProgressTracker.h"
+#include <algorithm>
+#include <cmath>
+
+namespace SCPClient {
+
+// Constante de temps de la moyenne glissante, et écart minimal entre deux
+// échantillons (en deçà, le débit instantané est trop bruité)
+static const double rateWindowSeconds = 3.0;
+static const double minSampleSeconds = 0.2;
+
+// MARK: - ProgressTracker
+
+ProgressTracker& ProgressTracker::shared() {
+    static ProgressTracker* tracker = new ProgressTracker();
+    return *tracker;
+}
+
+void ProgressTracker::setPublishRate(std::chrono::milliseconds interval, uint64_t bytes) {
+    intervalNanos.store(std::chrono::duration_cast<std::chrono::nanoseconds>(interval).count());
+    minBytes.store(bytes);
+}
+
+std::shared_ptr<ProgressTracker::Transfer> ProgressTracker::begin(const std::string& host,
+                                                                  const std::string& path,
+                                                                  bool upload) {
+    std::lock_guard<std::mutex> lock(mutex);
+    auto transfer = std::make_shared<Transfer>(*this, nextId++, host, path, upload);
+    active.push_back(transfer);
+    return transfer;
+}
+
+void ProgressTracker::end(const std::shared_ptr<Transfer>& transfer) {
+    std::lock_guard<std::mutex> lock(mutex);
+    active.erase(std::remove(active.begin(), active.end(), transfer), active.end());
+}
+
+std::vector<TransferSnapshot> ProgressTracker::snapshot() {
+    std::vector<std::shared_ptr<Transfer>> transfers;
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        transfers = active;
+    }
+    std::vector<TransferSnapshot> snapshots;
+    snapshots.reserve(transfers.size());
+    for (const auto& transfer : transfers) {
+        snapshots.push_back(transfer->snapshot());
+    }
+    return snapshots;
+}
+
+// MARK: - Transfer
+
+ProgressTracker::Transfer::Transfer(ProgressTracker& tracker, uint64_t id, const std::string& host,
+                                    const std::string& path, bool upload)
+    : tracker(tracker), id(id), host(host), path(path), upload(upload), started(Clock::now()) {}
+
+ProgressCallback ProgressTracker::Transfer::wrap(ProgressCallback inner) {
+    return [this, inner](uint64_t done, uint64_t size) {
+        transferred.store(done, std::memory_order_relaxed);
+        total.store(size, std::memory_order_relaxed);
+        if (shouldPublish(done, size) && inner) {
+            inner(done, size);
+        }
+    };
+}
+
+void ProgressTracker::Transfer::flush(const ProgressCallback& inner) {
+    uint64_t done = transferred.load();
+    if (published.load() && publishedBytes.load() == done) return;
+    publishedBytes.store(done);
+    published.store(true);
+    if (inner) inner(done, total.load());
+}
+
+bool ProgressTracker::Transfer::shouldPublish(uint64_t done, uint64_t size) {
+    // Fin du transfert : toujours, une seule fois
+    if (size > 0 && done >= size) {
+        published.store(true);
+        return publishedBytes.exchange(done) != done;
+    }
+
+    Clock::time_point now = Clock::now();
+    int64_t elapsed = std::chrono::duration_cast<std::chrono::nanoseconds>(now - started).count();
+    int64_t last = lastPublish.load(std::memory_order_relaxed);
+    if (published.load(std::memory_order_relaxed)) {
+        if (elapsed - last < tracker.intervalNanos.load(std::memory_order_relaxed)) return false;
+        if (done < publishedBytes.load(std::memory_order_relaxed) +
+                   tracker.minBytes.load(std::memory_order_relaxed)) {
+            return false;
+        }
+    }
+    // Un seul des threads d'un transfert réparti publie
+    if (!lastPublish.compare_exchange_strong(last, elapsed)) return false;
+    publishedBytes.store(done);
+    published.store(true);
+
+    std::lock_guard<std::mutex> lock(sampleMutex);
+    sample(now);
+    return true;
+}
+
+void ProgressTracker::Transfer::sample(Clock::time_point now) {
+    uint64_t bytes = transferred.load();
+    // Premier point : base de mesure (une reprise ne part pas de zéro)
+    if (!sampled) {
+        sampleTime = now;
+        sampleBytes = bytes;
+        sampled = true;
+        return;
+    }
+    double seconds = std::chrono::duration<double>(now - sampleTime).count();
+    if (seconds < minSampleSeconds) return;
+    double instant = bytes >= sampleBytes ? (bytes - sampleBytes) / seconds : 0;
+    if (!rated) {
+        rate = instant;
+        rated = true;
+    } else {
+        rate += (1 - std::exp(-seconds / rateWindowSeconds)) * (instant - rate);
+    }
+    sampleTime = now;
+    sampleBytes = bytes;
+}
+
+TransferSnapshot ProgressTracker::Transfer::snapshot() {
+    TransferSnapshot result;
+    result.id = id;
+    result.host = host;
+    result.path = path;
+    result.upload = upload;
+    result.transferred = transferred.load();
+    result.total = total.load();
+
+    Clock::time_point now = Clock::now();
+    result.elapsedSeconds = std::chrono::duration<double>(now - started).count();
+    {
+        std::lock_guard<std::mutex> lock(sampleMutex);
+        sample(now);
+        result.bytesPerSecond = rate;
+    }
+    if (result.total > 0 && result.bytesPerSecond > 0) {
+        uint64_t left = result.total > result.transferred ? result.total - result.transferred : 0;
+        result.secondsRemaining = left / result.bytesPerSecond;
+    }
+    return result;
+}
+
+} // namespace SCPClient
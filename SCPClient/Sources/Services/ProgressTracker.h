@@ -0,0 +1,107 @@
+//
+//  ProgressTracker.h
+//  SCP Client for macOS
+//
+//  Suivi des transferts en cours : compteurs atomiques, publication de la
+//  progression à cadence limitée, débit lissé et temps restant
+//
+
+#ifndef ProgressTracker_h
+#define ProgressTracker_h
+
+#include "SCPSession.h"
+#include <atomic>
+#include <chrono>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+namespace SCPClient {
+
+// État d'un transfert au moment de la lecture
+struct TransferSnapshot {
+    uint64_t id = 0;
+    std::string host;
+    std::string path;              // chemin distant (destination d'un upload)
+    bool upload = false;
+    uint64_t transferred = 0;
+    uint64_t total = 0;            // 0 : inconnu
+    double bytesPerSecond = 0;     // moyenne glissante (~3 s)
+    double secondsRemaining = -1;  // -1 : inconnu
+    double elapsedSeconds = 0;
+};
+
+// Chaque bloc transféré ne fait que mettre à jour deux compteurs atomiques.
+// Le callback de progression de l'appelant n'est appelé qu'au plus une fois
+// par intervalle, et seulement si au moins `minBytes` octets sont passés
+// depuis le précédent appel ; la fin d'un transfert est toujours publiée.
+// L'interface peut aussi ignorer les callbacks et lire snapshot().
+class ProgressTracker {
+public:
+    class Transfer;
+    using Clock = std::chrono::steady_clock;
+
+    static ProgressTracker& shared();
+
+    // Cadence des publications (100 ms et 64 Ko par défaut)
+    void setPublishRate(std::chrono::milliseconds interval, uint64_t minBytes);
+
+    std::shared_ptr<Transfer> begin(const std::string& host, const std::string& path, bool upload);
+    void end(const std::shared_ptr<Transfer>& transfer);
+
+    // Transferts actifs, dans l'ordre de leur début
+    std::vector<TransferSnapshot> snapshot();
+
+private:
+    ProgressTracker() = default;
+
+    std::mutex mutex;
+    std::vector<std::shared_ptr<Transfer>> active;
+    uint64_t nextId = 1;
+    std::atomic<int64_t> intervalNanos{100 * 1000 * 1000};
+    std::atomic<uint64_t> minBytes{64 * 1024};
+};
+
+class ProgressTracker::Transfer {
+public:
+    Transfer(ProgressTracker& tracker, uint64_t id, const std::string& host,
+             const std::string& path, bool upload);
+
+    // Callback qui met à jour les compteurs et n'appelle `inner` qu'aux
+    // publications ; à ne pas utiliser au-delà de la vie du transfert
+    ProgressCallback wrap(ProgressCallback inner);
+    // Dernière valeur, si elle n'a pas encore été publiée
+    void flush(const ProgressCallback& inner);
+
+    TransferSnapshot snapshot();
+
+private:
+    bool shouldPublish(uint64_t done, uint64_t total);
+    // Moyenne glissante du débit (sous sampleMutex)
+    void sample(Clock::time_point now);
+
+    ProgressTracker& tracker;
+    const uint64_t id;
+    const std::string host;
+    const std::string path;
+    const bool upload;
+    const Clock::time_point started;
+
+    std::atomic<uint64_t> transferred{0};
+    std::atomic<uint64_t> total{0};
+    std::atomic<int64_t> lastPublish{0};       // ns depuis started
+    std::atomic<uint64_t> publishedBytes{0};
+    std::atomic<bool> published{false};
+
+    std::mutex sampleMutex;
+    Clock::time_point sampleTime;
+    uint64_t sampleBytes = 0;
+    double rate = 0;
+    bool sampled = false;
+    bool rated = false;
+};
+
+} // namespace SCPClient
+
+#endif /* ProgressTracker_h */
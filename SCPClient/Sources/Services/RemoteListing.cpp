@@ -0,0 +1,251 @@
+//
+//  RemoteListing.cpp
+//  SCP Client for macOS
+//
+//  Implémentation de l'analyse du listage SCP
+//
+
+#include "RemoteListing.h"
+#include <sys/stat.h>
+#include <cstdlib>
+#include <cstring>
+#include <ctime>
+
+namespace SCPClient {
+
+// Type `find %y` ou premier caractère de `ls -l` -> bits de type st_mode
+static uint32_t typeBits(char type) {
+    switch (type) {
+    case 'd': return S_IFDIR;
+    case 'l': return S_IFLNK;
+    case 'p': return S_IFIFO;
+    case 's': return S_IFSOCK;
+    case 'c': return S_IFCHR;
+    case 'b': return S_IFBLK;
+    default:  return S_IFREG;
+    }
+}
+
+// "rwxr-sr-t" -> bits de permission, setuid/setgid/sticky compris
+static uint32_t permissionBits(const char* text, size_t length) {
+    static const uint32_t bits[9] = { 0400, 0200, 0100, 040, 020, 010, 04, 02, 01 };
+    static const uint32_t special[3] = { S_ISUID, S_ISGID, S_ISVTX };
+    uint32_t mode = 0;
+    for (size_t i = 0; i < 9 && i < length; ++i) {
+        char c = text[i];
+        if (c == 'r' || c == 'w' || c == 'x') {
+            mode |= bits[i];
+        } else if (i % 3 == 2 && (c == 's' || c == 't')) {
+            mode |= bits[i] | special[i / 3];
+        } else if (i % 3 == 2 && (c == 'S' || c == 'T')) {
+            mode |= special[i / 3];
+        }
+    }
+    return mode;
+}
+
+// Date `ls -l` en locale C : "<mois> <jour> <HH:MM>" (moins de six mois,
+// année en cours ou précédente) ou "<mois> <jour> <année>". Heure du serveur
+// lue dans le fuseau local ; -1 si illisible.
+static int64_t lsDate(const char* month, const char* day, size_t dayLength,
+                      const char* clock, size_t clockLength) {
+    static const char months[] = "JanFebMarAprMayJunJulAugSepOctNovDec";
+    const char* found = nullptr;
+    for (const char* m = months; *m; m += 3) {
+        if (strncmp(m, month, 3) == 0) found = m;
+    }
+    if (!found) return -1;
+
+    struct tm date = {};
+    date.tm_mon = (int)((found - months) / 3);
+    date.tm_isdst = -1;
+    for (size_t i = 0; i < dayLength; ++i) {
+        if (day[i] < '0' || day[i] > '9') return -1;
+        date.tm_mday = date.tm_mday * 10 + (day[i] - '0');
+    }
+
+    time_t now = time(nullptr);
+    struct tm today;
+    localtime_r(&now, &today);
+    const char* colon = (const char*)memchr(clock, ':', clockLength);
+    if (colon) {
+        date.tm_hour = atoi(clock);
+        date.tm_min = atoi(colon + 1);
+        date.tm_year = today.tm_year;
+    } else {
+        date.tm_year = atoi(clock) - 1900;
+    }
+    time_t result = mktime(&date);
+    // "HH:MM" d'une date postérieure à aujourd'hui : l'an dernier
+    if (colon && result > now + 86400) {
+        date.tm_year -= 1;
+        date.tm_isdst = -1;
+        result = mktime(&date);
+    }
+    return (int64_t)result;
+}
+
+ListingParser::ListingParser(const std::string& basePath, Visitor visitor)
+    : basePath(basePath), visitor(std::move(visitor)) {
+    if (this->basePath.empty() || this->basePath.back() != '/') this->basePath += '/';
+}
+
+void ListingParser::feed(const char* data, size_t length) {
+    const char* p = data;
+    const char* end = data + length;
+
+    if (mode == Mode::Detect && p < end) {
+        // La sortie de repli commence par une ligne vide
+        if (*p == '\n') {
+            mode = Mode::Lines;
+            ++p;
+        } else {
+            mode = Mode::Fields;
+        }
+    }
+
+    if (mode == Mode::Lines) {
+        while (p < end) {
+            const char* newline = (const char*)memchr(p, '\n', end - p);
+            if (!newline) {
+                line.append(p, end - p);
+                break;
+            }
+            line.append(p, newline - p);
+            parseLine();
+            line.clear();
+            p = newline + 1;
+        }
+        return;
+    }
+
+    while (p < end) {
+        if (field == Name) {
+            const char* nul = (const char*)memchr(p, '\0', end - p);
+            if (!nul) {
+                current.name.append(p, end - p);
+                break;
+            }
+            current.name.append(p, nul - p);
+            p = nul + 1;
+            emit();
+            continue;
+        }
+
+        char c = *p++;
+        if (c == '\0') {
+            ++field;
+            continue;
+        }
+        switch (field) {
+        case Type:
+            type = c;
+            break;
+        case Permissions:
+            permissions = permissions * 8 + (uint32_t)(c - '0');
+            break;
+        case Size:
+            size = size * 10 + (uint64_t)(c - '0');
+            break;
+        case Mtime:
+            // "%T@" : secondes avec partie fractionnaire
+            if (c == '-') {
+                mtimeNegative = true;
+            } else if (c == '.') {
+                mtimeFraction = true;
+            } else if (!mtimeFraction) {
+                mtime = mtime * 10 + (c - '0');
+            }
+            break;
+        }
+    }
+}
+
+void ListingParser::finish() {
+    if (mode == Mode::Lines && !line.empty()) {
+        parseLine();
+        line.clear();
+    }
+}
+
+void ListingParser::emit() {
+    if (current.name != "." && current.name != "..") {
+        current.path.assign(basePath).append(current.name);
+        current.size = size;
+        current.permissions = typeBits(type) | permissions;
+        current.isDirectory = type == 'd';
+        current.modificationTime = mtimeNegative ? -mtime : mtime;
+        ++entries;
+        visitor(current);
+    }
+
+    field = Type;
+    type = 0;
+    permissions = 0;
+    size = 0;
+    mtime = 0;
+    mtimeNegative = false;
+    mtimeFraction = false;
+    current.name.clear();
+}
+
+// Repli `ls -la` : "<mode> <liens> <propriétaire> <groupe> <taille> <date>
+// <nom>", la date en secondes après une ligne "@s" (`--time-style=+%s` GNU,
+// `-D %s` BSD), sinon "<mois> <jour> <heure|année>" en locale C
+void ListingParser::parseLine() {
+    if (line == "@s") {
+        epochDates = true;
+        return;
+    }
+
+    const char* p = line.data();
+    const char* end = p + line.size();
+    const int count = epochDates ? 6 : 8;
+    const char* tokens[8];
+    size_t lengths[8];
+
+    for (int i = 0; i < count; ++i) {
+        while (p < end && *p == ' ') ++p;
+        tokens[i] = p;
+        while (p < end && *p != ' ') ++p;
+        lengths[i] = p - tokens[i];
+        if (lengths[i] == 0) return;   // "total N" ou ligne incomplète
+        // Périphériques : "majeur, mineur" à la place de la taille
+        if (i == 4 && tokens[i][lengths[i] - 1] == ',') --i;
+    }
+    while (p < end && *p == ' ') ++p;
+    if (p == end || lengths[0] < 10) return;
+
+    char kind = tokens[0][0] == '-' ? 'f' : tokens[0][0];
+    size_t nameLength = end - p;
+    if (kind == 'l') {
+        const char* arrow = strstr(p, " -> ");
+        if (arrow && arrow < end) nameLength = arrow - p;
+    }
+    current.name.assign(p, nameLength);
+    if (current.name == "." || current.name == "..") {
+        current.name.clear();
+        return;
+    }
+
+    uint64_t fileSize = 0;
+    for (size_t i = 0; i < lengths[4] && tokens[4][i] >= '0' && tokens[4][i] <= '9'; ++i) {
+        fileSize = fileSize * 10 + (uint64_t)(tokens[4][i] - '0');
+    }
+
+    current.path.assign(basePath).append(current.name);
+    current.size = fileSize;
+    current.permissions = typeBits(kind) | permissionBits(tokens[0] + 1, lengths[0] - 1);
+    current.isDirectory = kind == 'd';
+    if (epochDates) {
+        current.modificationTime = strtoll(tokens[5], nullptr, 10);
+    } else {
+        int64_t date = lsDate(tokens[5], tokens[6], lengths[6], tokens[7], lengths[7]);
+        current.modificationTime = date < 0 ? 0 : date;
+    }
+    ++entries;
+    visitor(current);
+    current.name.clear();
+}
+
+} // namespace SCPClient
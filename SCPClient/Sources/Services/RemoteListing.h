@@ -0,0 +1,66 @@
+//
+//  RemoteListing.h
+//  SCP Client for macOS
+//
+//  Listage de répertoire en mode SCP : `find -printf` distant en champs
+//  séparés par NUL, analysé au fil de l'eau
+//
+
+#ifndef RemoteListing_h
+#define RemoteListing_h
+
+#include "SCPSession.h"
+#include <functional>
+#include <string>
+
+namespace SCPClient {
+
+// Sortie attendue : avec GNU find, chaque entrée est
+// "<type>\0<mode octal>\0<taille>\0<mtime>\0<nom>\0" ; sans -printf (BSD,
+// busybox), une ligne vide puis la sortie de `ls -la`, précédée de "@s" si
+// ses dates sont en secondes depuis l'epoch.
+//
+// Analyse en une passe : chaque entrée est passée au visiteur dès que son
+// dernier champ arrive. Les champs sont décodés octet par octet, sans copie
+// ni découpage du bloc ; l'entrée passée au visiteur est réutilisée.
+class ListingParser {
+public:
+    using Visitor = std::function<void(const RemoteFile& file)>;
+
+    ListingParser(const std::string& basePath, Visitor visitor);
+
+    void feed(const char* data, size_t length);
+    // Dernière ligne `ls -la` sans retour à la ligne
+    void finish();
+
+    uint64_t count() const { return entries; }
+
+private:
+    enum class Mode { Detect, Fields, Lines };
+    enum Field { Type, Permissions, Size, Mtime, Name };
+
+    void emit();
+    void parseLine();
+
+    std::string basePath;
+    Visitor visitor;
+    Mode mode = Mode::Detect;
+
+    // Entrée en cours
+    int field = Type;
+    char type = 0;
+    uint32_t permissions = 0;
+    uint64_t size = 0;
+    int64_t mtime = 0;
+    bool mtimeNegative = false;
+    bool mtimeFraction = false;
+    RemoteFile current;
+
+    std::string line;   // mode `ls -la`
+    bool epochDates = false;
+    uint64_t entries = 0;
+};
+
+} // namespace SCPClient
+
+#endif /* RemoteListing_h */
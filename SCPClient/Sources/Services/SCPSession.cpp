@@ -6,20 +6,104 @@
 //
 
 #include "SCPSession.h"
+#include "SessionPool.h"
+#include "SessionReactor.h"
+#include "TarStream.h"
+#include "DeltaSync.h"
+#include "TransferJournal.h"
+#include "LocalFileReader.h"
+#include "LocalFileWriter.h"
+#include "BufferPool.h"
+#include "RemoteListing.h"
+#include "DirectoryCache.h"
+#include "DirectoryListing.h"
+#include "DirectoryPrefetcher.h"
+#include "TransferScheduler.h"
+#include "ProgressTracker.h"
+#include "SegmentHasher.h"
 #include <libssh2.h>
 #include <libssh2_sftp.h>
+#include <openssl/crypto.h>
 #include <sys/socket.h>
 #include <netinet/in.h>
+#include <netinet/tcp.h>
 #include <arpa/inet.h>
 #include <netdb.h>
 #include <unistd.h>
 #include <fcntl.h>
 #include <sys/stat.h>
+#include <sys/time.h>
+#include <poll.h>
+#include <dirent.h>
+#include <fnmatch.h>
 #include <cstring>
-#include <sstream>
+#include <cerrno>
+#include <algorithm>
+#include <vector>
+#include <thread>
+#include <mutex>
+#include <atomic>
+#include <condition_variable>
+#include <deque>
 
 namespace SCPClient {
 
+bool executeSSHCommand(LIBSSH2_SESSION* session, const std::string& command, std::string& lastError);
+
+// Argument shell entre apostrophes, sûr quel que soit le nom
+static std::string shellQuote(const std::string& arg) {
+    std::string quoted = "'";
+    for (char c : arg) {
+        if (c == '\'') quoted += "'\\''";
+        else quoted += c;
+    }
+    return quoted + "'";
+}
+
+// Attend que le socket soit prêt dans les directions attendues par libssh2
+static void waitSocket(int sock, LIBSSH2_SESSION* session, int timeoutMs = 1000) {
+    struct pollfd pfd;
+    pfd.fd = sock;
+    pfd.events = 0;
+    pfd.revents = 0;
+    int directions = libssh2_session_block_directions(session);
+    if (directions & LIBSSH2_SESSION_BLOCK_INBOUND) pfd.events |= POLLIN;
+    if (directions & LIBSSH2_SESSION_BLOCK_OUTBOUND) pfd.events |= POLLOUT;
+    if (!pfd.events) pfd.events = POLLIN;
+    poll(&pfd, 1, timeoutMs);
+}
+
+// mkdir -p local
+static bool makeLocalDirectories(const std::string& path) {
+    for (size_t pos = path.find('/', 1); ; pos = path.find('/', pos + 1)) {
+        std::string prefix = path.substr(0, pos);
+        if (!prefix.empty() && mkdir(prefix.c_str(), 0755) != 0 && errno != EEXIST) {
+            return false;
+        }
+        if (pos == std::string::npos) return true;
+    }
+}
+
+// Chemin relatif sans composant ".." : une archive distante ne doit pas
+// écrire hors du répertoire de destination
+static bool isSafeRelativePath(const std::string& path) {
+    if (path.empty() || path[0] == '/') return false;
+    size_t start = 0;
+    while (start <= path.size()) {
+        size_t end = path.find('/', start);
+        if (end == std::string::npos) end = path.size();
+        if (path.compare(start, end - start, "..") == 0) return false;
+        start = end + 1;
+    }
+    return true;
+}
+
+static std::string joinPath(const std::string& base, const std::string& name) {
+    if (name.empty()) return base;
+    if (base.empty()) return name;
+    return base + (base.back() == '/' ? "" : "/") + name;
+}
+
 class SCPSession::Impl {
 public:
     LIBSSH2_SESSION* session = nullptr;
@@ -29,12 +113,259 @@ public:
     std::string currentDir = "/";
     bool connected = false;
     ProtocolType protocol = ProtocolType::SCP;
+    // Gardés pour ouvrir des sessions annexes, effacés à la déconnexion ; une
+    // session de travail du pool n'en ouvre pas et ne les garde pas
+    SessionCredentials credentials;
+    bool credentialsForgotten = false;
+    unsigned transferWindow = 8;
+    size_t chunkSize = 64 * 1024;
+    bool nonBlocking = false;
+    bool resume = false;
+    bool resumeVerify = false;
+    bool verifyTransfers = false;
+    unsigned hashThreads = 0;
+    IntegrityReport integrity;   // sous errorMutex
+    bool uncachedDownloads = false;
+    TransferPriority priority = TransferPriority::Normal;
+    uint64_t rateLimit = 0;
+    // Transfert en cours auprès de l'ordonnanceur, partagé par ses bandes
+    std::shared_ptr<TransferScheduler::Transfer> throttle;
+    // Transfert en cours auprès du ProgressTracker, partagé de même
+    std::shared_ptr<ProgressTracker::Transfer> progress;
+    DirectoryCache cache;
+    std::unique_ptr<DirectoryPrefetcher> prefetcher;
+    // Cible du préchargement, copiée sous prefetchMutex : son thread ne lit
+    // pas les réglages de la session. Il liste sur sa propre connexion, hors
+    // du pool, et ne prend jamais la place d'un transfert.
+    std::mutex prefetchMutex;
+    SessionCredentials prefetchCredentials;
+    ProtocolType prefetchProtocol = ProtocolType::SCP;
+    std::unique_ptr<SCPSession> prefetchSession;   // thread du préchargement seul
+    SessionKey prefetchKey;
+    // Réacteur du mode non bloquant (sous reactorMutex, lu par currentReactor)
+    std::shared_ptr<SessionReactor> reactor;
+    std::mutex reactorMutex;
+    std::condition_variable directCallsDone;
+    unsigned directCalls = 0;   // portées BlockingScope ouvertes
+    // Shell interactif et réacteur qui le pilote (sous shellMutex), ou
+    // session annexe du pool qui le porte
+    std::shared_ptr<ShellOperation> shell;
+    std::shared_ptr<SessionReactor> shellReactor;
+    SessionPool::Lease shellSession;
+    std::mutex shellMutex;
+    std::mutex errorMutex;   // lastError, écrit depuis plusieurs threads en mode non bloquant
 
     ~Impl() {
         cleanup();
     }
 
+    // Appels libssh2 directs : le réacteur est suspendu le temps de la
+    // portée. Sans réacteur, la portée est comptée : un réacteur démarré
+    // entre-temps attend qu'elle se termine.
+    struct BlockingScope {
+        Impl& impl;
+        std::shared_ptr<SessionReactor> reactor;
+
+        explicit BlockingScope(Impl& impl) : impl(impl) {
+            {
+                std::lock_guard<std::mutex> lock(impl.reactorMutex);
+                ++impl.directCalls;
+                reactor = impl.reactor;
+            }
+            if (reactor) reactor->pause();
+        }
+        ~BlockingScope() {
+            if (reactor) reactor->resume();
+            std::lock_guard<std::mutex> lock(impl.reactorMutex);
+            if (--impl.directCalls == 0) impl.directCallsDone.notify_all();
+        }
+    };
+
+    void setError(const std::string& error) {
+        std::lock_guard<std::mutex> lock(errorMutex);
+        lastError = error;
+    }
+
+    std::string errorText() {
+        std::lock_guard<std::mutex> lock(errorMutex);
+        return lastError;
+    }
+
+    std::shared_ptr<SessionReactor> currentReactor() {
+        std::lock_guard<std::mutex> lock(reactorMutex);
+        return reactor;
+    }
+
+    // Attend la fin des appels directs en cours (transfert bloquant) : la
+    // session n'est jamais utilisée à la fois par eux et par le réacteur
+    void startReactor() {
+        std::unique_lock<std::mutex> lock(reactorMutex);
+        directCallsDone.wait(lock, [&]() { return directCalls == 0; });
+        if (!reactor && session && sock >= 0) {
+            reactor = std::make_shared<SessionReactor>(session, sock);
+        }
+    }
+
+    // Arrêt sous verrou : aucune portée ne passe en appels directs avant que
+    // le thread du réacteur ait rendu la session
+    void stopReactor() {
+        std::lock_guard<std::mutex> lock(reactorMutex);
+        if (reactor) {
+            reactor->stop();
+            reactor.reset();
+        }
+    }
+
+    // Opération pilotée par le réacteur ; l'erreur est reportée dans lastError
+    bool runOnReactor(const std::shared_ptr<SessionReactor>& running, ReactorOperation& op) {
+        if (!running->run(op)) {
+            setError(op.error);
+            return false;
+        }
+        return true;
+    }
+
+    std::shared_ptr<ShellOperation> currentShell() {
+        std::lock_guard<std::mutex> lock(shellMutex);
+        if (shellSession) return shellSession->pImpl->currentShell();
+        return shell;
+    }
+
+    // Le shell prend sa propre session dans le pool : un transfert bloquant
+    // sur celle-ci suspendrait son réacteur, et la session partagée ne change
+    // pas de mode. Elle ne le porte que si un réacteur la pilote déjà.
+    bool openShell(const ShellOptions& options, ShellOutputCallback onOutput,
+                   ShellClosedCallback onClosed) {
+        std::shared_ptr<ShellOperation> previous = currentShell();
+        if (previous && previous->isOpen()) {
+            setError("Shell already open");
+            return false;
+        }
+        closeShell();   // shell terminé côté serveur
+        if (!connected) {
+            setError("Not connected");
+            return false;
+        }
+
+        if (nonBlocking) return openShellHere(options, std::move(onOutput), std::move(onClosed));
+        std::string error;
+        SessionPool::Lease lease = acquireLease(ProtocolType::SCP, error);
+        if (!lease) {
+            setError("No session available for the shell: " + error);
+            return false;
+        }
+
+        if (!lease->pImpl->openShellHere(options, std::move(onOutput), std::move(onClosed))) {
+            setError(lease->getLastError());
+            return false;
+        }
+        std::lock_guard<std::mutex> lock(shellMutex);
+        shellSession = lease;
+        return true;
+    }
+
+    // Pseudo-terminal et shell demandés en mode bloquant, puis canal confié
+    // au réacteur, démarré au besoin pour la durée du shell
+    bool openShellHere(const ShellOptions& options, ShellOutputCallback onOutput,
+                       ShellClosedCallback onClosed) {
+        startReactor();
+        std::shared_ptr<SessionReactor> running = currentReactor();
+        LIBSSH2_CHANNEL* channel = nullptr;
+        {
+            BlockingScope blocking(*this);
+            channel = libssh2_channel_open_session(session);
+            if (!channel) {
+                char* errMsg;
+                libssh2_session_last_error(session, &errMsg, nullptr, 0);
+                setError("Failed to open SSH channel: " + std::string(errMsg));
+            } else {
+                // Modes du terminal : ECHO 0, puis TTY_OP_END
+                static const char noEcho[] = {53, 0, 0, 0, 0, 0};
+                int rc = libssh2_channel_request_pty_ex(
+                    channel, options.term.c_str(), options.term.size(),
+                    options.echo ? nullptr : noEcho, options.echo ? 0 : sizeof(noEcho),
+                    options.columns, options.rows, 0, 0);
+                if (rc != 0) {
+                    setError("Failed to request pseudo-terminal");
+                } else if (libssh2_channel_shell(channel) != 0) {
+                    setError("Failed to start shell");
+                    rc = -1;
+                }
+                if (rc != 0) {
+                    libssh2_channel_free(channel);
+                    channel = nullptr;
+                }
+            }
+        }
+        if (!channel) {
+            if (!nonBlocking) stopReactor();
+            return false;
+        }
+
+        auto operation = std::make_shared<ShellOperation>(*running, channel, std::move(onOutput),
+                                                          std::move(onClosed));
+        running->start(*operation);
+        std::lock_guard<std::mutex> lock(shellMutex);
+        shell = operation;
+        shellReactor = running;
+        return true;
+    }
+
+    void closeShell() {
+        std::shared_ptr<ShellOperation> closing;
+        std::shared_ptr<SessionReactor> running;
+        SessionPool::Lease leased;
+        {
+            std::lock_guard<std::mutex> lock(shellMutex);
+            closing.swap(shell);
+            running.swap(shellReactor);
+            leased.swap(shellSession);
+        }
+        // Rendue au pool une fois son shell fermé
+        if (leased) leased->pImpl->closeShell();
+        if (!closing) return;
+        closing->close();
+        running->wait(*closing);
+        // Réacteur démarré pour le seul shell
+        if (!nonBlocking && currentReactor() == running) stopReactor();
+    }
+
+    // Commande dont seul le code de retour compte
+    bool runCommand(const std::string& command) {
+        std::shared_ptr<SessionReactor> running = currentReactor();
+        if (!running) {
+            BlockingScope blocking(*this);
+            std::string error;
+            if (executeSSHCommand(session, command, error)) return true;
+            setError(error);
+            return false;
+        }
+
+        ExecOperation op(command);
+        if (!runOnReactor(running, op)) return false;
+        if (op.exitStatus != 0) {
+            setError("Command failed with exit code " + std::to_string(op.exitStatus));
+            return false;
+        }
+        return true;
+    }
+
     void cleanup() {
+        // Le préchargement utilise les identifiants et le cache de la session
+        if (prefetcher) prefetcher->stop();
+        prefetchSession.reset();
+        // Le réacteur rend la session en mode bloquant avant sa fermeture
+        stopReactor();
+        // Arrêté avec le réacteur ; son canal est libéré avec la session
+        SessionPool::Lease leased;
+        {
+            std::lock_guard<std::mutex> lock(shellMutex);
+            shell.reset();
+            shellReactor.reset();
+            leased.swap(shellSession);
+        }
+        if (leased) leased->pImpl->closeShell();
+        leased.reset();
         if (sftp) {
             libssh2_sftp_shutdown(sftp);
             sftp = nullptr;
@@ -49,12 +380,15 @@ public:
             sock = -1;
         }
         connected = false;
+        forgetCredentials();
+        std::lock_guard<std::mutex> lock(pagingMutex);
+        paging = PageSnapshot();
     }
 
     bool initializeSSH() {
         int rc = libssh2_init(0);
         if (rc != 0) {
-            lastError = "Failed to initialize libssh2";
+            setError("Failed to initialize libssh2");
             return false;
         }
         return true;
@@ -69,19 +403,19 @@ public:
         std::string portStr = std::to_string(port);
         int rc = getaddrinfo(host.c_str(), portStr.c_str(), &hints, &result);
         if (rc != 0) {
-            lastError = "Failed to resolve hostname: " + std::string(gai_strerror(rc));
+            setError("Failed to resolve hostname: " + std::string(gai_strerror(rc)));
             return false;
         }
 
         sock = socket(result->ai_family, result->ai_socktype, result->ai_protocol);
         if (sock < 0) {
-            lastError = "Failed to create socket";
+            setError("Failed to create socket");
             freeaddrinfo(result);
             return false;
         }
 
         if (::connect(sock, result->ai_addr, result->ai_addrlen) != 0) {
-            lastError = "Failed to connect to " + host + ":" + std::to_string(port);
+            setError("Failed to connect to " + host + ":" + std::to_string(port));
             close(sock);
             sock = -1;
             freeaddrinfo(result);
@@ -89,13 +423,17 @@ public:
         }
 
         freeaddrinfo(result);
+
+        // Frappes du terminal et petites requêtes : pas d'attente de Nagle
+        int noDelay = 1;
+        setsockopt(sock, IPPROTO_TCP, TCP_NODELAY, &noDelay, sizeof(noDelay));
         return true;
     }
 
     bool startSession() {
         session = libssh2_session_init();
         if (!session) {
-            lastError = "Failed to create SSH session";
+            setError("Failed to create SSH session");
             return false;
         }
 
@@ -105,7 +443,7 @@ public:
         if (rc) {
             char* errMsg;
             libssh2_session_last_error(session, &errMsg, nullptr, 0);
-            lastError = "SSH handshake failed: " + std::string(errMsg);
+            setError("SSH handshake failed: " + std::string(errMsg));
             return false;
         }
 
@@ -117,7 +455,7 @@ public:
         if (rc) {
             char* errMsg;
             libssh2_session_last_error(session, &errMsg, nullptr, 0);
-            lastError = "Authentication failed: " + std::string(errMsg);
+            setError("Authentication failed: " + std::string(errMsg));
             return false;
         }
         return true;
@@ -131,7 +469,7 @@ public:
         if (rc) {
             char* errMsg;
             libssh2_session_last_error(session, &errMsg, nullptr, 0);
-            lastError = "Key authentication failed: " + std::string(errMsg);
+            setError("Key authentication failed: " + std::string(errMsg));
             return false;
         }
         return true;
@@ -142,446 +480,3312 @@ public:
         if (!sftp) {
             char* errMsg;
             libssh2_session_last_error(session, &errMsg, nullptr, 0);
-            lastError = "Failed to initialize SFTP: " + std::string(errMsg);
+            setError("Failed to initialize SFTP: " + std::string(errMsg));
             return false;
         }
         return true;
     }
-};
 
-// Constructeur/Destructeur
-SCPSession::SCPSession() : pImpl(new Impl()) {
-    pImpl->initializeSSH();
-}
+    // Écrit tout le bloc à l'offset donné (pwrite peut être partiel)
+    static bool pwriteAll(int fd, const char* data, size_t len, uint64_t offset) {
+        while (len > 0) {
+            ssize_t written = pwrite(fd, data, len, (off_t)offset);
+            if (written < 0) {
+                if (errno == EINTR) continue;
+                return false;
+            }
+            data += written;
+            len -= written;
+            offset += written;
+        }
+        return true;
+    }
 
-SCPSession::~SCPSession() {
-    disconnect();
-}
+    // Compteur de progression d'une plage : reçoit les octets ajoutés,
+    // retourne false pour interrompre le transfert
+    using ByteCounter = std::function<bool(uint64_t bytes)>;
+    // Plage écrite à son offset (journal de reprise)
+    using RangeCounter = std::function<void(uint64_t offset, uint64_t bytes)>;
 
-void SCPSession::setProtocol(ProtocolType protocol) {
-    pImpl->protocol = protocol;
-}
+    // Téléchargement SFTP pipeliné de [start, end).
+    // libssh2 n'expose pas les identifiants des requêtes READ : la fenêtre est
+    // donc répartie en "voies", chacune étant un handle ouvert sur sa propre
+    // plage du fichier. libssh2_sftp_read y garde plusieurs READ en vol
+    // (lecture anticipée), et en faisant tourner les voies les réponses de
+    // toutes les plages arrivent pendant qu'on attend l'une d'elles. Les blocs
+    // reçus sont regroupés par voie (LocalFileWriter) puis écrits à leur
+    // offset ; onRange n'annonce que les plages effectivement écrites.
+    // end == UINT64_MAX : taille inconnue, une seule voie lue jusqu'à EOF.
+    bool downloadSFTPRange(const std::string& remotePath, int fd,
+                           uint64_t start, uint64_t end, const ByteCounter& onBytes,
+                           const RangeCounter& onRange = nullptr) {
+        struct Lane {
+            LIBSSH2_SFTP_HANDLE* handle = nullptr;
+            uint64_t pos = 0;
+            uint64_t end = 0;
+        };
 
-// Connexion avec password
-bool SCPSession::connect(const std::string& host, int port,
-                        const std::string& username, const std::string& password) {
-    disconnect();
+        bool sizeKnown = end != UINT64_MAX;
+        uint64_t length = sizeKnown ? end - start : 0;
 
-    if (!pImpl->createSocket(host, port)) return false;
-    if (!pImpl->startSession()) return false;
-    if (!pImpl->authenticate(username, password)) return false;
+        // Une voie supplémentaire coûte un OPEN : pas en dessous de 4 blocs
+        uint64_t laneMin = (uint64_t)chunkSize * 4;
+        uint64_t laneCount = 1;
+        if (sizeKnown && length > laneMin) {
+            laneCount = std::min<uint64_t>(std::max(1u, transferWindow), length / laneMin);
+        }
+        uint64_t span = sizeKnown ? (length + laneCount - 1) / laneCount : UINT64_MAX;
+        if (sizeKnown) span = (span + chunkSize - 1) / chunkSize * chunkSize;
 
-    // Initialiser SFTP seulement si protocol = SFTP
-    if (pImpl->protocol == ProtocolType::SFTP) {
-        if (!pImpl->initSFTP()) return false;
-    }
+        std::vector<Lane> lanes(laneCount);
+        bool ok = true;
+        for (uint64_t i = 0; i < laneCount; ++i) {
+            Lane& lane = lanes[i];
+            lane.pos = start + i * span;
+            lane.end = sizeKnown ? std::min(end, lane.pos + span) : UINT64_MAX;
+            lane.handle = libssh2_sftp_open(sftp, remotePath.c_str(), LIBSSH2_FXF_READ, 0);
+            if (!lane.handle) {
+                setError("Cannot open remote file: " + remotePath);
+                ok = false;
+                break;
+            }
+            libssh2_sftp_seek64(lane.handle, lane.pos);
+        }
 
-    pImpl->connected = true;
-    return true;
-}
+        BufferPool::Buffer buffer = BufferPool::shared().acquire(chunkSize);
+        LocalFileWriter writer(fd, laneCount, onRange);
+        size_t active = std::count_if(lanes.begin(), lanes.end(),
+                                      [](const Lane& lane) { return lane.pos < lane.end; });
 
-// Connexion avec clé SSH
-bool SCPSession::connectWithKey(const std::string& host, int port,
-                               const std::string& username, const std::string& privateKeyPath,
-                               const std::string& passphrase) {
-    disconnect();
+        while (ok && active > 0) {
+            for (Lane& lane : lanes) {
+                if (lane.pos >= lane.end) continue;
 
-    if (!pImpl->createSocket(host, port)) return false;
-    if (!pImpl->startSession()) return false;
-    if (!pImpl->authenticateWithKey(username, privateKeyPath, passphrase)) return false;
+                size_t amount = (size_t)std::min<uint64_t>(chunkSize, lane.end - lane.pos);
+                ssize_t nread = libssh2_sftp_read(lane.handle, buffer.data(), amount);
+                if (nread < 0) {
+                    setError("Read error during download at offset " + std::to_string(lane.pos));
+                    ok = false;
+                    break;
+                }
+                if (nread == 0) {
+                    // EOF avant la fin de la plage : le fichier a rétréci
+                    lane.end = lane.pos;
+                    --active;
+                    continue;
+                }
+                if (!writer.write(lane.pos, buffer.data(), nread)) {
+                    setError("Write error during download");
+                    ok = false;
+                    break;
+                }
+                lane.pos += nread;
+                if (lane.pos >= lane.end) --active;
+                throttleBytes(nread);
+                if (onBytes && !onBytes(nread)) {
+                    setError("Transfer cancelled");
+                    ok = false;
+                    break;
+                }
+            }
+        }
 
-    // Initialiser SFTP seulement si protocol = SFTP
-    if (pImpl->protocol == ProtocolType::SFTP) {
-        if (!pImpl->initSFTP()) return false;
+        // Même après une erreur : ce qui a été reçu reste acquis pour la reprise
+        if (!writer.finish() && ok) {
+            setError("Write error during download");
+            ok = false;
+        }
+        for (Lane& lane : lanes) {
+            if (lane.handle) libssh2_sftp_close(lane.handle);
+        }
+        return ok;
     }
 
-    pImpl->connected = true;
-    return true;
-}
+    // Upload SFTP pipeliné de [offset, offset + length) avec écriture différée.
+    // libssh2_sftp_write envoie en WRITE tout ce qui n'a pas encore été envoyé
+    // et ne rend que les octets acquittés : les données passées doivent donc
+    // toujours commencer au premier octet non acquitté, le reste reste en vol.
+    // Gros fichier projeté : cette fenêtre glisse sur la projection. Sinon le
+    // fichier est lu en avance dans un tampon de transferWindow blocs.
+    // Une erreur est rapportée avec l'offset du premier octet non confirmé.
+    // length == UINT64_MAX : jusqu'à la fin du fichier local.
+    bool uploadSFTPRange(LIBSSH2_SFTP_HANDLE* handle, int fd,
+                         uint64_t offset, uint64_t length, const ByteCounter& onBytes) {
+        size_t capacity = transferBufferSize();
+        uint64_t acked = offset;
+        uint64_t end = (length == UINT64_MAX) ? UINT64_MAX : offset + length;
 
-void SCPSession::disconnect() {
-    pImpl->cleanup();
-}
+        libssh2_sftp_seek64(handle, offset);
 
-bool SCPSession::isConnected() const {
-    return pImpl->connected;
-}
+        LocalFileReader reader(fd);
+        if (reader.isMapped()) {
+            uint64_t stop = std::min(end, reader.size());
+            while (acked < stop) {
+                size_t window = (size_t)std::min<uint64_t>(capacity, stop - acked);
+                const char* data = reader.view(acked, window);
+                if (!data) {
+                    setError("Local file shrank during upload at offset " + std::to_string(acked));
+                    return false;
+                }
+                ssize_t written = libssh2_sftp_write(handle, data, window);
+                if (written < 0) {
+                    setError("Write error during upload at offset " + std::to_string(acked) +
+                             " (SFTP status " + std::to_string(libssh2_sftp_last_error(sftp)) + ")");
+                    return false;
+                }
+                acked += written;
+                reader.release(acked);
+                throttleBytes(written);
+                if (onBytes && !onBytes(written)) {
+                    setError("Transfer cancelled");
+                    return false;
+                }
+            }
+            return true;
+        }
 
-// Helper pour parser une ligne ls -la
-RemoteFile parseLsLine(const std::string& line, const std::string& basePath) {
-    RemoteFile file;
-    std::istringstream iss(line);
-    std::string perms, links, owner, group, sizeStr, month, day, timeOrYear, name;
+        BufferPool::Buffer buffer = BufferPool::shared().acquire(capacity);
+        size_t head = 0;   // premier octet non acquitté
+        size_t tail = 0;   // fin des données lues
+        uint64_t readPos = offset;
+        bool eof = false;
 
-    iss >> perms >> links >> owner >> group >> sizeStr;
-    iss >> month >> day >> timeOrYear;
+        while (true) {
+            // Compacter une fois la moitié du tampon acquittée
+            if (!eof && head >= capacity / 2) {
+                memmove(buffer.data(), buffer.data() + head, tail - head);
+                tail -= head;
+                head = 0;
+            }
 
-    // Le reste est le nom du fichier
-    std::getline(iss >> std::ws, name);
+            // Lecture anticipée
+            while (!eof && capacity - tail >= chunkSize) {
+                size_t want = (size_t)std::min<uint64_t>(capacity - tail, end - readPos);
+                ssize_t nread = want ? reader.read(readPos, buffer.data() + tail, want) : 0;
+                if (nread < 0) {
+                    setError("Read error on local file at offset " + std::to_string(readPos));
+                    return false;
+                }
+                if (nread == 0) {
+                    eof = true;
+                    break;
+                }
+                tail += nread;
+                readPos += nread;
+            }
 
-    file.name = name;
-    file.path = basePath + (basePath.back() == '/' ? "" : "/") + name;
-    file.size = std::stoull(sizeStr);
-    file.isDirectory = (perms[0] == 'd');
-    file.permissions = 0755; // Valeur par défaut
-    file.modificationTime = time(nullptr); // Approximation
+            if (head == tail) break;
 
-    return file;
-}
+            ssize_t written = libssh2_sftp_write(handle, buffer.data() + head, tail - head);
+            if (written < 0) {
+                setError("Write error during upload at offset " + std::to_string(acked) +
+                         " (SFTP status " + std::to_string(libssh2_sftp_last_error(sftp)) + ")");
+                return false;
+            }
+            head += written;
+            acked += written;
+            throttleBytes(written);
+            if (onBytes && !onBytes(written)) {
+                setError("Transfer cancelled");
+                return false;
+            }
+        }
 
-// Liste les fichiers d'un répertoire
-std::vector<RemoteFile> SCPSession::listDirectory(const std::string& path) {
-    std::vector<RemoteFile> files;
+        return true;
+    }
 
-    if (!pImpl->session) {
-        pImpl->lastError = "Not connected";
-        return files;
+    // Transfert réparti : chaque bande déplace [start, end) sur sa propre session
+    using StripeTransfer = std::function<bool(SCPSession& stripe, uint64_t start, uint64_t end,
+                                              const ByteCounter& onBytes)>;
+
+    // Nombre de bandes : au plus `streams`, pas moins de 8 Mo par bande, et
+    // une place laissée à la session principale dans la limite du pool
+    static unsigned stripeCount(unsigned streams, uint64_t totalSize) {
+        const uint64_t minStripe = 8ull * 1024 * 1024;
+        uint64_t bySize = std::max<uint64_t>(1, totalSize / minStripe);
+        unsigned byPool = std::max(1u, SessionPool::shared().getMaxSessionsPerHost() - 1);
+        return (unsigned)std::min<uint64_t>(std::max(1u, std::min(streams, byPool)), bySize);
     }
 
-    if (pImpl->protocol == ProtocolType::SCP) {
-        // Mode SCP - utiliser commande SSH ls
-        LIBSSH2_CHANNEL* channel = libssh2_channel_open_session(pImpl->session);
-        if (!channel) {
-            pImpl->lastError = "Failed to open SSH channel";
-            return files;
+    // Emprunte au pool une session annexe réglée comme celle-ci
+    SessionPool::Lease acquireLease(ProtocolType leaseProtocol, std::string& error,
+                                    bool wait = true) const {
+        if (credentialsForgotten) {
+            error = "Credentials no longer available";
+            return nullptr;
         }
-
-        std::string command = "ls -la \"" + path + "\" 2>/dev/null";
-        int rc = libssh2_channel_exec(channel, command.c_str());
-        if (rc != 0) {
-            pImpl->lastError = "Failed to execute ls command";
-            libssh2_channel_free(channel);
-            return files;
+        SessionPool::Lease lease = SessionPool::shared().acquire(credentials, leaseProtocol, &error, wait);
+        if (lease) {
+            lease->setTransferWindow(transferWindow);
+            lease->setChunkSize(chunkSize);
+            lease->setTransferPriority(priority);
+            lease->setTransferRateLimit(rateLimit);
+            lease->setUncachedDownloads(uncachedDownloads);
+            lease->setVerifyTransfers(verifyTransfers, hashThreads);
         }
+        return lease;
+    }
 
-        // Lire la sortie
-        std::string output;
-        char buffer[1024];
-        ssize_t nread;
-
-        while ((nread = libssh2_channel_read(channel, buffer, sizeof(buffer))) > 0) {
-            output.append(buffer, nread);
-        }
+    // Tampon des transferts en bloc : toute la fenêtre du pipeline
+    size_t transferBufferSize() const {
+        return chunkSize * std::max(1u, transferWindow);
+    }
 
-        libssh2_channel_close(channel);
-        libssh2_channel_free(channel);
+    SessionPool::Lease acquireStripe(std::string& error) const {
+        return acquireLease(ProtocolType::SFTP, error);
+    }
 
-        // Parser la sortie ligne par ligne
-        std::istringstream stream(output);
-        std::string line;
+    // Lance une bande par thread ; stripes[0] est déjà empruntée, les autres
+    // le sont dans leur thread pour paralléliser d'éventuels handshakes.
+    // La progression de toutes les bandes est cumulée dans un seul callback,
+    // appelé hors verrou : enveloppé par ProgressScope, il n'est publié que
+    // par une bande à la fois.
+    bool runStripes(SessionPool::Lease first, unsigned count, uint64_t totalSize,
+                    ProgressCallback callback, const StripeTransfer& transfer) {
+        std::vector<SessionPool::Lease> stripes(count);
+        stripes[0] = std::move(first);
+        uint64_t span = (totalSize + count - 1) / count;
+        span = (span + chunkSize - 1) / chunkSize * chunkSize;
 
-        while (std::getline(stream, line)) {
-            if (line.empty() || line.find("total ") == 0) continue;
+        std::atomic<uint64_t> transferred(0);
+        std::atomic<bool> failed(false);
+        std::mutex mutex;
+        std::string firstError;
 
-            // Parser les informations du fichier
-            std::istringstream iss(line);
-            std::string perms, links, owner, group, sizeStr, month, day, timeOrYear, name;
+        auto fail = [&](const std::string& error) {
+            std::lock_guard<std::mutex> lock(mutex);
+            if (!failed.exchange(true)) firstError = error;
+        };
 
-            if (!(iss >> perms >> links >> owner >> group >> sizeStr >> month >> day >> timeOrYear)) {
-                continue;
-            }
+        auto onBytes = [&](uint64_t bytes) {
+            uint64_t done = transferred.fetch_add(bytes) + bytes;
+            if (callback) callback(done, totalSize);
+            return !failed.load();
+        };
 
-            // Le reste est le nom du fichier
-            std::getline(iss >> std::ws, name);
+        std::vector<std::thread> threads;
+        for (unsigned i = 0; i < count; ++i) {
+            threads.emplace_back([&, i]() {
+                if (!stripes[i]) {
+                    std::string error;
+                    stripes[i] = acquireStripe(error);
+                    if (!stripes[i]) {
+                        fail("Stripe connection failed: " + error);
+                        return;
+                    }
+                }
+                SCPSession& stripe = *stripes[i];
+                uint64_t start = std::min<uint64_t>(totalSize, i * span);
+                uint64_t end = std::min<uint64_t>(totalSize, start + span);
+                // Les bandes comptent comme un seul transfert
+                stripe.pImpl->throttle = throttle;
+                if (start < end && !transfer(stripe, start, end, onBytes) && !failed.load()) {
+                    fail(stripe.getLastError());
+                }
+                stripe.pImpl->throttle.reset();
+            });
+        }
+        for (std::thread& thread : threads) {
+            thread.join();
+        }
 
-            if (name == "." || name == "..") continue;
+        if (failed.load()) {
+            setError(firstError);
+            return false;
+        }
+        return true;
+    }
 
-            RemoteFile file;
-            file.name = name;
-            file.path = path + (path.back() == '/' ? "" : "/") + name;
+    using WorkerJob = std::function<bool(SCPSession& worker, size_t index)>;
+    using WorkerFailure = std::function<void(size_t index, const std::string& error)>;
 
-            try {
-                file.size = std::stoull(sizeStr);
-            } catch (...) {
-                file.size = 0;
-            }
+    // File de tâches sur au plus `workers` sessions du pool (même protocole),
+    // une par thread. Une tâche en échec n'arrête pas les autres ; onFailure
+    // est appelé sous verrou avec l'erreur de la session.
+    void runWorkers(unsigned workers, size_t jobCount, const WorkerJob& job,
+                    const WorkerFailure& onFailure) {
+        unsigned byPool = std::max(1u, SessionPool::shared().getMaxSessionsPerHost() - 1);
+        size_t count = std::min<size_t>(std::max(1u, std::min(workers, byPool)), jobCount);
 
-            file.isDirectory = (perms[0] == 'd');
-            file.permissions = 0755;
-            file.modificationTime = time(nullptr);
+        std::atomic<size_t> next(0);
+        std::mutex mutex;
+        std::string connectError;
 
-            files.push_back(file);
+        std::vector<std::thread> threads;
+        for (size_t i = 0; i < count; ++i) {
+            threads.emplace_back([&]() {
+                std::string error;
+                SessionPool::Lease worker = acquireLease(protocol, error);
+                size_t index;
+                while (worker && (index = next.fetch_add(1)) < jobCount) {
+                    if (job(*worker, index)) continue;
+                    {
+                        std::lock_guard<std::mutex> lock(mutex);
+                        onFailure(index, worker->getLastError());
+                    }
+                    // Connexion perdue : une nouvelle session pour la suite
+                    if (!worker->isConnected()) {
+                        worker = acquireLease(protocol, error);
+                    }
+                }
+                if (!worker) {
+                    std::lock_guard<std::mutex> lock(mutex);
+                    connectError = error;
+                }
+            });
         }
-
-        return files;
-
-    } else {
-        // Mode SFTP
-        if (!pImpl->sftp) {
-            pImpl->lastError = "SFTP not initialized";
-            return files;
+        for (std::thread& thread : threads) {
+            thread.join();
         }
 
-        LIBSSH2_SFTP_HANDLE* handle = libssh2_sftp_opendir(pImpl->sftp, path.c_str());
-        if (!handle) {
-            pImpl->lastError = "Failed to open directory: " + path;
-            return files;
+        // Tâches jamais prises : aucune session n'a pu être ouverte
+        for (size_t index = next.load(); index < jobCount; ++index) {
+            onFailure(index, "Worker connection failed: " + connectError);
         }
+    }
+
+    // Répertoire SFTP : un répertoire déjà présent n'est pas une erreur
+    bool makeSFTPDirectory(const std::string& path) {
+        int rc = libssh2_sftp_mkdir(sftp, path.c_str(),
+                                    LIBSSH2_SFTP_S_IRWXU | LIBSSH2_SFTP_S_IRGRP |
+                                    LIBSSH2_SFTP_S_IXGRP | LIBSSH2_SFTP_S_IROTH | LIBSSH2_SFTP_S_IXOTH);
+        if (rc == 0) return true;
 
-        char buffer[512];
         LIBSSH2_SFTP_ATTRIBUTES attrs;
+        if (libssh2_sftp_stat(sftp, path.c_str(), &attrs) == 0 && LIBSSH2_SFTP_S_ISDIR(attrs.permissions)) {
+            return true;
+        }
+        setError("Failed to create directory: " + path);
+        return false;
+    }
 
-        while (libssh2_sftp_readdir(handle, buffer, sizeof(buffer), &attrs) > 0) {
-            std::string name(buffer);
-            if (name == "." || name == "..") continue;
+    // Crée les répertoires distants (chemins relatifs à `root`, parents en
+    // premier). SCP : quelques `mkdir -p` groupant des centaines de chemins ;
+    // SFTP : un niveau de profondeur à la fois, réparti sur les workers.
+    void createRemoteDirectories(const std::string& root, const std::vector<std::string>& dirs,
+                                 unsigned workers, TreeTransferReport& report) {
+        if (protocol == ProtocolType::SCP) {
+            const size_t maxCommand = 32 * 1024;
+            size_t begin = 0;
+            while (begin < dirs.size()) {
+                std::string command = "mkdir -p";
+                size_t end = begin;
+                while (end < dirs.size() && (end == begin || command.size() < maxCommand)) {
+                    command += " " + shellQuote(joinPath(root, dirs[end]));
+                    ++end;
+                }
+                if (runCommand(command)) {
+                    report.directories += end - begin;
+                } else {
+                    for (size_t i = begin; i < end; ++i) {
+                        report.failures.push_back({joinPath(root, dirs[i]), errorText()});
+                    }
+                }
+                begin = end;
+            }
+            return;
+        }
 
-            RemoteFile file;
-            file.name = name;
-            file.path = path + (path.back() == '/' ? "" : "/") + name;
-            file.size = attrs.filesize;
-            file.permissions = attrs.permissions;
-            file.isDirectory = LIBSSH2_SFTP_S_ISDIR(attrs.permissions);
-            file.modificationTime = attrs.mtime;
+        size_t begin = 0;
+        while (begin < dirs.size()) {
+            auto depth = [](const std::string& path) {
+                return path.empty() ? -1 : (long)std::count(path.begin(), path.end(), '/');
+            };
+            size_t end = begin;
+            while (end < dirs.size() && depth(dirs[end]) == depth(dirs[begin])) ++end;
 
-            files.push_back(file);
+            std::atomic<uint64_t> created(0);
+            runWorkers(workers, end - begin, [&](SCPSession& worker, size_t index) {
+                if (!worker.pImpl->makeSFTPDirectory(joinPath(root, dirs[begin + index]))) return false;
+                created.fetch_add(1);
+                return true;
+            }, [&](size_t index, const std::string& error) {
+                report.failures.push_back({joinPath(root, dirs[begin + index]), error});
+            });
+            report.directories += created.load();
+            begin = end;
         }
-
-        libssh2_sftp_closedir(handle);
-        return files;
     }
-}
 
-std::string SCPSession::getCurrentDirectory() {
-    return pImpl->currentDir;
-}
+    struct TreeFile {
+        std::string path;   // relatif à la racine
+        uint64_t size;
+    };
 
-bool SCPSession::changeDirectory(const std::string& path) {
-    if (!pImpl->sftp) {
-        pImpl->lastError = "Not connected";
-        return false;
-    }
+    // Transfère les fichiers sur les workers, les plus gros en premier pour
+    // équilibrer la fin ; la progression est cumulée sur tous les fichiers
+    void transferFiles(const std::string& root, std::vector<TreeFile>& files, unsigned workers, ProgressCallback callback,
+                       TreeTransferReport& report,
+                       const std::function<bool(SCPSession&, const TreeFile&, ProgressCallback)>& transfer) {
+        std::sort(files.begin(), files.end(), [](const TreeFile& a, const TreeFile& b) {
+            return a.size > b.size;
+        });
+        uint64_t totalSize = 0;
+        for (const TreeFile& file : files) totalSize += file.size;
 
-    // Vérifier que le répertoire existe
-    LIBSSH2_SFTP_ATTRIBUTES attrs;
-    int rc = libssh2_sftp_stat(pImpl->sftp, path.c_str(), &attrs);
-    if (rc == 0 && LIBSSH2_SFTP_S_ISDIR(attrs.permissions)) {
-        pImpl->currentDir = path;
-        return true;
-    }
+        std::atomic<uint64_t> transferred(0);
+        std::atomic<uint64_t> done(0);
+        std::mutex progressMutex;
 
-    pImpl->lastError = "Directory does not exist: " + path;
-    return false;
-}
+        runWorkers(workers, files.size(), [&](SCPSession& worker, size_t index) {
+            uint64_t last = 0;
+            worker.pImpl->progress = progress;
+            bool ok = transfer(worker, files[index], [&](uint64_t fileTransferred, uint64_t) {
+                uint64_t total = transferred.fetch_add(fileTransferred - last) + fileTransferred - last;
+                last = fileTransferred;
+                if (callback) {
+                    std::lock_guard<std::mutex> lock(progressMutex);
+                    callback(total, totalSize);
+                }
+            });
+            worker.pImpl->progress.reset();
+            if (ok) done.fetch_add(1);
+            return ok;
+        }, [&](size_t index, const std::string& error) {
+            report.failures.push_back({joinPath(root, files[index].path), error});
+        });
 
-// Upload un fichier
-bool SCPSession::uploadFile(const std::string& localPath, const std::string& remotePath,
-                           ProgressCallback callback) {
-    if (!pImpl->session) {
-        pImpl->lastError = "Not connected";
-        return false;
+        report.files += done.load();
+        report.bytes += transferred.load();
     }
 
-    // Ouvrir le fichier local
-    int fd = open(localPath.c_str(), O_RDONLY);
-    if (fd < 0) {
-        pImpl->lastError = "Cannot open local file: " + localPath;
-        return false;
+    // Parcours local en largeur : les répertoires sortent par profondeur
+    // croissante, la racine ("") en tête. Les liens vers des fichiers sont
+    // suivis, pas ceux vers des répertoires.
+    static void walkLocalTree(const std::string& root, std::vector<std::string>& dirs,
+                              std::vector<TreeFile>& files, TreeTransferReport& report) {
+        dirs.push_back("");
+        for (size_t i = 0; i < dirs.size(); ++i) {
+            std::string relative = dirs[i];
+            std::string path = joinPath(root, relative);
+            DIR* dir = opendir(path.c_str());
+            if (!dir) {
+                report.failures.push_back({path, "Cannot open local directory"});
+                if (i == 0) dirs.clear();   // rien à créer côté distant
+                continue;
+            }
+            while (struct dirent* entry = readdir(dir)) {
+                std::string name = entry->d_name;
+                if (name == "." || name == "..") continue;
+
+                std::string child = joinPath(relative, name);
+                std::string childPath = joinPath(root, child);
+                struct stat info;
+                if (lstat(childPath.c_str(), &info) != 0) continue;
+                if (S_ISDIR(info.st_mode)) {
+                    dirs.push_back(child);
+                } else if (S_ISLNK(info.st_mode) && stat(childPath.c_str(), &info) != 0) {
+                    continue;
+                }
+                if (S_ISREG(info.st_mode)) {
+                    files.push_back({child, (uint64_t)info.st_size});
+                }
+            }
+            closedir(dir);
+        }
     }
 
-    struct stat fileInfo;
-    fstat(fd, &fileInfo);
-    uint64_t totalSize = fileInfo.st_size;
+    using StreamProducer = std::function<bool(std::string& buffer, bool& eof)>;
+    using StreamConsumer = std::function<bool(const char* data, size_t length)>;
 
-    if (pImpl->protocol == ProtocolType::SCP) {
-        // Mode SCP - utiliser libssh2_scp_send64
-        LIBSSH2_CHANNEL* channel = libssh2_scp_send64(pImpl->session, remotePath.c_str(),
-                                                       fileInfo.st_mode & 0777,
-                                                       totalSize, 0, 0);
+    // Commande exec en flux : `produce` alimente stdin par blocs (eof quand
+    // tout est envoyé), `consume` reçoit stdout au fil de l'eau. La session
+    // passe en mode non bloquant le temps de l'échange pour écrire et lire en
+    // même temps : une commande bloquée sur stdout ne bloque pas notre envoi.
+    bool streamCommand(const std::string& command, const StreamProducer& produce,
+                       const StreamConsumer& consume, int& exitStatus, std::string& errorOutput) {
+        BlockingScope blocking(*this);
+        LIBSSH2_CHANNEL* channel = libssh2_channel_open_session(session);
         if (!channel) {
-            char* errMsg;
-            libssh2_session_last_error(pImpl->session, &errMsg, nullptr, 0);
-            pImpl->lastError = "Failed to open SCP channel: " + std::string(errMsg);
-            close(fd);
+            setError("Failed to open SSH channel");
+            return false;
+        }
+        if (libssh2_channel_exec(channel, command.c_str()) != 0) {
+            setError("Failed to execute command: " + command);
+            libssh2_channel_free(channel);
             return false;
         }
 
-        // Transfer
-        char buffer[8192];
-        uint64_t transferred = 0;
-        ssize_t nread;
+        libssh2_session_set_blocking(session, 0);
+        std::string pending;
+        size_t offset = 0;
+        bool inputEof = !produce;
+        bool eofSent = false;
+        bool stdoutEof = false;
+        bool stderrEof = false;
+        bool ok = true;
+        BufferPool::Buffer buffer = BufferPool::shared().acquire(transferBufferSize());
 
-        while ((nread = read(fd, buffer, sizeof(buffer))) > 0) {
-            ssize_t written = libssh2_channel_write(channel, buffer, nread);
-            if (written < 0) {
-                pImpl->lastError = "Write error during SCP upload";
-                libssh2_channel_free(channel);
-                close(fd);
-                return false;
+        while (ok && !(stdoutEof && stderrEof)) {
+            bool progressed = false;
+
+            if (offset == pending.size() && !inputEof) {
+                pending.clear();
+                offset = 0;
+                if (!produce(pending, inputEof)) {
+                    ok = false;   // lastError posé par le producteur
+                    break;
+                }
             }
-            transferred += written;
-            if (callback) {
-                callback(transferred, totalSize);
+            if (offset < pending.size()) {
+                ssize_t written = libssh2_channel_write(channel, pending.data() + offset,
+                                                        pending.size() - offset);
+                if (written > 0) {
+                    offset += written;
+                    progressed = true;
+                    throttleBytes(written);
+                } else if (written != LIBSSH2_ERROR_EAGAIN) {
+                    setError("Write error on SSH channel");
+                    ok = false;
+                    break;
+                }
+            } else if (inputEof && !eofSent) {
+                int rc = libssh2_channel_send_eof(channel);
+                if (rc == 0) {
+                    eofSent = true;
+                    progressed = true;
+                } else if (rc != LIBSSH2_ERROR_EAGAIN) {
+                    setError("Write error on SSH channel");
+                    ok = false;
+                    break;
+                }
+            }
+
+            if (!stdoutEof) {
+                ssize_t nread = libssh2_channel_read(channel, buffer.data(), buffer.size());
+                if (nread > 0) {
+                    if (!consume(buffer.data(), nread)) {
+                        ok = false;   // lastError posé par le consommateur
+                        break;
+                    }
+                    progressed = true;
+                    throttleBytes(nread);
+                } else if (nread == 0) {
+                    stdoutEof = true;
+                } else if (nread != LIBSSH2_ERROR_EAGAIN) {
+                    setError("Read error on SSH channel");
+                    ok = false;
+                    break;
+                }
+            }
+            if (!stderrEof) {
+                ssize_t nread = libssh2_channel_read_stderr(channel, buffer.data(), buffer.size());
+                if (nread > 0) {
+                    if (errorOutput.size() < 64 * 1024) errorOutput.append(buffer.data(), nread);
+                    progressed = true;
+                } else if (nread == 0) {
+                    stderrEof = true;
+                } else if (nread != LIBSSH2_ERROR_EAGAIN) {
+                    setError("Read error on SSH channel");
+                    ok = false;
+                    break;
+                }
+            }
+
+            if (!progressed) {
+                waitSocket(sock, session);
             }
         }
 
-        libssh2_channel_send_eof(channel);
-        libssh2_channel_wait_eof(channel);
+        libssh2_session_set_blocking(session, 1);
+        if (!ok && !eofSent) {
+            libssh2_channel_send_eof(channel);
+        }
+        libssh2_channel_close(channel);
+        exitStatus = libssh2_channel_get_exit_status(channel);
+        libssh2_channel_free(channel);
+        return ok;
+    }
+
+    // Commande en flux sans réacteur, sur une session empruntée au pool dont
+    // l'appelant est seul utilisateur : elle passe en mode non bloquant le
+    // temps de la lecture, pour alterner stdout et stderr et surveiller
+    // l'interruption. Une commande interrompue reçoit SIGTERM.
+    bool executeStreaming(const std::string& command, const CommandOutputCallback& onOutput,
+                          const CommandOptions& options, int& exitStatus) {
+        LIBSSH2_CHANNEL* channel = libssh2_channel_open_session(session);
+        if (!channel) {
+            char* errMsg;
+            libssh2_session_last_error(session, &errMsg, nullptr, 0);
+            setError("Failed to open SSH channel: " + std::string(errMsg));
+            return false;
+        }
+        if (libssh2_channel_exec(channel, command.c_str()) != 0) {
+            setError("Failed to execute command: " + command);
+            libssh2_channel_free(channel);
+            return false;
+        }
+
+        libssh2_session_set_blocking(session, 0);
+        BufferPool::Buffer buffer = BufferPool::shared().acquire(options.maxBuffered);
+        bool eof[2] = {false, false};   // stdout, stderr
+        bool cancelled = false;
+        bool ok = true;
+
+        while (ok && !cancelled && !(eof[0] && eof[1])) {
+            if (options.cancel && options.cancel->load()) {
+                cancelled = true;
+                break;
+            }
+            bool progressed = false;
+            for (int stream = 0; stream < 2 && ok && !cancelled; ++stream) {
+                if (eof[stream]) continue;
+                ssize_t nread = libssh2_channel_read_ex(channel,
+                                                        stream ? SSH_EXTENDED_DATA_STDERR : 0,
+                                                        buffer.data(), buffer.size());
+                if (nread > 0) {
+                    progressed = true;
+                    if (!onOutput(buffer.data(), nread, stream == 1)) cancelled = true;
+                } else if (nread == 0) {
+                    eof[stream] = true;
+                } else if (nread != LIBSSH2_ERROR_EAGAIN) {
+                    setError("Read error on SSH channel");
+                    ok = false;
+                }
+            }
+            if (ok && !cancelled && !progressed) {
+                waitSocket(sock, session, 100);
+            }
+        }
+
+        libssh2_session_set_blocking(session, 1);
+        if (cancelled) {
+            libssh2_channel_signal(channel, "TERM");
+            setError("Command cancelled");
+            ok = false;
+        }
+        libssh2_channel_close(channel);
+        exitStatus = libssh2_channel_get_exit_status(channel);
+        libssh2_channel_free(channel);
+        return ok;
+    }
+
+    // Commande en flux pilotée par le réacteur ; un refus de `onOutput`
+    // l'interrompt comme `options.cancel`
+    bool executeOnReactor(const std::shared_ptr<SessionReactor>& running, const std::string& command,
+                          const CommandOutputCallback& onOutput, const CommandOptions& options,
+                          int& exitStatus) {
+        bool stopped = false;
+        ExecOperation op(command, options.maxBuffered);
+        op.onStdout = [&](const char* data, size_t length) {
+            stopped = !onOutput(data, length, false);
+            return !stopped;
+        };
+        op.onStderr = [&](const char* data, size_t length) {
+            stopped = !onOutput(data, length, true);
+            return !stopped;
+        };
+        op.cancel = options.cancel;
+        if (!runOnReactor(running, op)) return false;
+        if (stopped) {
+            setError("Command cancelled");
+            return false;
+        }
+        exitStatus = op.exitStatus;
+        return true;
+    }
+
+    // Synchronisation sans assistant distant : le fichier distant est relu en
+    // SFTP et comparé bloc à bloc au fichier local ; seuls les blocs qui
+    // diffèrent sont réécrits sur place, puis la taille est ajustée.
+    bool patchSFTPInPlace(int fd, uint64_t size, const std::string& remotePath,
+                          size_t blockSize, const ProgressCallback& callback,
+                          DeltaSyncStats& stats, bool& missing) {
+        BlockingScope blocking(*this);
+        LIBSSH2_SFTP_ATTRIBUTES remoteInfo;
+        missing = libssh2_sftp_stat(sftp, remotePath.c_str(), &remoteInfo) != 0 &&
+                  libssh2_sftp_last_error(sftp) == LIBSSH2_FX_NO_SUCH_FILE;
+        if (missing) return false;
+
+        LIBSSH2_SFTP_HANDLE* reader = libssh2_sftp_open(sftp, remotePath.c_str(), LIBSSH2_FXF_READ, 0);
+        if (!reader) {
+            setError("Cannot open remote file: " + remotePath);
+            return false;
+        }
+
+        // Plages à réécrire, fusionnées
+        std::vector<std::pair<uint64_t, uint64_t>> dirty;
+        auto markDirty = [&](uint64_t offset, uint64_t length) {
+            if (!dirty.empty() && dirty.back().first + dirty.back().second == offset) {
+                dirty.back().second += length;
+            } else {
+                dirty.push_back({offset, length});
+            }
+        };
+
+        BufferPool::Buffer remoteBlock = BufferPool::shared().acquire(blockSize);
+        BufferPool::Buffer localBlock = BufferPool::shared().acquire(blockSize);
+        BufferPool::Buffer buffer = BufferPool::shared().acquire(transferBufferSize());
+        size_t blockFill = 0;
+        uint64_t blockOffset = 0;
+        bool ok = true;
+
+        auto compareBlock = [&]() {
+            size_t want = (size_t)std::min<uint64_t>(blockSize, size > blockOffset ? size - blockOffset : 0);
+            ssize_t nread = want ? pread(fd, localBlock.data(), want, (off_t)blockOffset) : 0;
+            if (nread < 0 || (size_t)nread != want) {
+                setError("Read error on local file at offset " + std::to_string(blockOffset));
+                return false;
+            }
+            if (want > 0) {
+                if (want == blockFill && memcmp(localBlock.data(), remoteBlock.data(), want) == 0) {
+                    stats.matchedBytes += want;
+                } else {
+                    markDirty(blockOffset, want);
+                }
+            }
+            blockOffset += blockFill;
+            blockFill = 0;
+            if (callback) {
+                callback(std::min(blockOffset, size), size);
+            }
+            return true;
+        };
+
+        // Lecture du fichier distant jusqu'à la fin du fichier local
+        while (ok && blockOffset < size) {
+            ssize_t nread = libssh2_sftp_read(reader, buffer.data(), buffer.size());
+            if (nread < 0) {
+                setError("Read error on remote file at offset " + std::to_string(blockOffset + blockFill));
+                ok = false;
+                break;
+            }
+            if (nread == 0) break;
+            throttleBytes(nread);
+            for (ssize_t used = 0; used < nread && ok;) {
+                size_t take = std::min<size_t>(blockSize - blockFill, nread - used);
+                memcpy(remoteBlock.data() + blockFill, buffer.data() + used, take);
+                blockFill += take;
+                used += take;
+                if (blockFill == blockSize) ok = compareBlock();
+            }
+        }
+        if (ok && blockFill > 0) ok = compareBlock();
+        libssh2_sftp_close(reader);
+        if (!ok) return false;
+
+        // Au-delà de la fin du fichier distant : tout est nouveau
+        uint64_t remoteEnd = blockOffset;
+        if (remoteEnd < size) markDirty(remoteEnd, size - remoteEnd);
+
+        LIBSSH2_SFTP_HANDLE* writer = libssh2_sftp_open(sftp, remotePath.c_str(), LIBSSH2_FXF_WRITE, 0);
+        if (!writer) {
+            setError("Cannot open remote file: " + remotePath);
+            return false;
+        }
+        for (const auto& range : dirty) {
+            if (!uploadSFTPRange(writer, fd, range.first, range.second, nullptr)) {
+                libssh2_sftp_close(writer);
+                return false;
+            }
+            stats.literalBytes += range.second;
+        }
+
+        // Fichier raccourci
+        LIBSSH2_SFTP_ATTRIBUTES attrs;
+        memset(&attrs, 0, sizeof(attrs));
+        attrs.flags = LIBSSH2_SFTP_ATTR_SIZE;
+        attrs.filesize = size;
+        if (libssh2_sftp_fsetstat(writer, &attrs) != 0) {
+            setError("Failed to truncate remote file: " + remotePath);
+            libssh2_sftp_close(writer);
+            return false;
+        }
+        if (libssh2_sftp_close(writer) != 0) {
+            setError("Failed to close remote file: " + remotePath);
+            return false;
+        }
+        if (callback) {
+            callback(size, size);
+        }
+        return true;
+    }
+
+    // Enregistre le transfert auprès de l'ordonnanceur le temps d'une
+    // opération ; une opération imbriquée (repli, reprise) garde le même
+    struct TransferScope {
+        Impl& impl;
+        bool owner;
+
+        explicit TransferScope(Impl& impl) : impl(impl), owner(!impl.throttle) {
+            if (owner) {
+                impl.throttle = TransferScheduler::shared().begin(impl.credentials.host,
+                                                                  impl.priority, impl.rateLimit);
+            }
+        }
+        ~TransferScope() {
+            if (owner) impl.throttle.reset();
+        }
+    };
+
+    // Transfert public suivi par le ProgressTracker : `callback` est remplacé
+    // par un callback qui met à jour ses compteurs et ne rappelle l'original
+    // qu'aux publications. Les fichiers d'une arborescence, passés sur des
+    // sessions du pool, comptent dans le transfert qui les a lancés.
+    struct ProgressScope {
+        Impl& impl;
+        bool owner;
+        ProgressCallback inner;
+
+        ProgressScope(Impl& impl, ProgressCallback& callback, const std::string& path, bool upload)
+            : impl(impl), owner(!impl.progress) {
+            if (owner) {
+                impl.progress = ProgressTracker::shared().begin(impl.credentials.host, path, upload);
+                inner = std::move(callback);
+                callback = impl.progress->wrap(inner);
+            }
+        }
+        ~ProgressScope() {
+            if (!owner) return;
+            impl.progress->flush(inner);
+            ProgressTracker::shared().end(impl.progress);
+            impl.progress.reset();
+        }
+    };
+
+    // Octets passés sur le réseau : attend que le débit le permette
+    void throttleBytes(uint64_t bytes) {
+        if (throttle) throttle->consume(bytes);
+    }
+
+    // Invalide le cache des listages quand une opération qui modifie `path`
+    // (et tout son contenu si `tree`) a réussi, ou a pu modifier le serveur
+    // avant d'échouer : touch() dès la première écriture distante (fichier
+    // tronqué, arborescence en partie envoyée), puis `return done(ok)`. Un
+    // échec avant touch() laisse le cache intact.
+    struct CacheInvalidation {
+        Impl& impl;
+        std::string path;
+        bool tree;
+        bool touched = false;
+
+        CacheInvalidation(Impl& impl, const std::string& path, bool tree = false)
+            : impl(impl), path(path), tree(tree) {}
+        ~CacheInvalidation() {
+            if (touched) {
+                impl.cache.invalidateParent(path);
+                if (tree) impl.cache.invalidateTree(path);
+            }
+        }
+
+        void touch() { touched = true; }
+        bool done(bool ok) {
+            if (ok) touch();
+            return ok;
+        }
+    };
+
+    void schedulePrefetch(const std::string& path, const DirectoryListing& listing) {
+        if (prefetcher && cache.enabled()) {
+            prefetcher->recordVisit(path);
+            prefetcher->schedule(listing);
+        }
+    }
+
+    // Mot de passe et phrase de passe écrasés en mémoire avant libération
+    static void wipeSecrets(SessionCredentials& target) {
+        for (std::string* secret : {&target.password, &target.passphrase}) {
+            if (!secret->empty()) OPENSSL_cleanse(&(*secret)[0], secret->size());
+            secret->clear();
+        }
+    }
+
+    void forgetCredentials() {
+        wipeSecrets(credentials);
+        credentialsForgotten = true;
+        std::lock_guard<std::mutex> lock(prefetchMutex);
+        wipeSecrets(prefetchCredentials);
+    }
+
+    void updatePrefetchTarget() {
+        std::lock_guard<std::mutex> lock(prefetchMutex);
+        prefetchCredentials = credentials;
+        prefetchProtocol = protocol;
+    }
+
+    // Préchargement, sur le thread du préchargeur : connexion ouverte à la
+    // première demande, refaite si la cible a changé ou après un échec (une
+    // tentative compte dans le budget de requêtes)
+    bool prefetchListing(const std::string& path, uint64_t& bytes) {
+        DirectoryListing listing;
+        int64_t mtime = -1;
+        if (!cache.enabled() || cache.lookup(path, listing, mtime) == DirectoryCache::Lookup::Fresh) {
+            return false;
+        }
+
+        SessionCredentials target;
+        ProtocolType targetProtocol;
+        {
+            std::lock_guard<std::mutex> lock(prefetchMutex);
+            target = prefetchCredentials;
+            targetProtocol = prefetchProtocol;
+        }
+        if (target.host.empty()) return false;
+
+        SessionKey key = SessionKey::from(target, targetProtocol);
+        if (prefetchSession && (key < prefetchKey || prefetchKey < key)) prefetchSession.reset();
+        if (!prefetchSession) {
+            auto fresh = std::make_unique<SCPSession>();
+            fresh->setProtocol(targetProtocol);
+            bool opened = fresh->connect(target);
+            wipeSecrets(target);
+            if (!opened) return true;
+            fresh->forgetCredentials();
+            prefetchSession = std::move(fresh);
+            prefetchKey = key;
+        }
+        wipeSecrets(target);
+
+        Impl& remote = *prefetchSession->pImpl;
+        listing.reset(path);
+        uint64_t generation = cache.generation();
+        if (remote.sftp) mtime = remote.directoryMtime(path);
+        bool ok = remote.listEntries(path, [&](const RemoteFile& file) {
+            listing.append(file);
+            // Entrée SFTP : nom, ligne longue et attributs
+            bytes += 2 * file.name.size() + 64;
+            return true;
+        });
+        if (ok) {
+            cache.store(path, listing, mtime, generation);
+        } else if (!prefetchSession->sendKeepalive()) {
+            prefetchSession.reset();   // connexion perdue, pas seulement un dossier illisible
+        }
+        return true;
+    }
+
+    // Date d'un répertoire distant, -1 si inconnue. En SCP, `stat` par exec
+    // (GNU, sinon BSD) : le cache revalide aussi dans ce mode.
+    int64_t directoryMtime(const std::string& path) {
+        if (!sftp) {
+            std::string target = shellQuote(path.empty() || path[0] == '-' ? "./" + path : path);
+            std::string command = "stat -c %Y " + target + " 2>/dev/null || stat -f %m " + target;
+            std::string output;
+            std::string errorOutput;
+            int exitStatus = -1;
+            bool ok = streamCommand(command, nullptr, [&](const char* data, size_t length) {
+                if (output.size() < 64) output.append(data, length);
+                return true;
+            }, exitStatus, errorOutput);
+            if (!ok || exitStatus != 0) return -1;
+            char* end = nullptr;
+            long long mtime = strtoll(output.c_str(), &end, 10);
+            if (end == output.c_str() || (*end != '\n' && *end != '\0')) return -1;
+            return mtime;
+        }
+        BlockingScope blocking(*this);
+        LIBSSH2_SFTP_ATTRIBUTES attrs;
+        if (libssh2_sftp_stat(sftp, path.c_str(), &attrs) != 0 ||
+            !(attrs.flags & LIBSSH2_SFTP_ATTR_ACMODTIME)) {
+            return -1;
+        }
+        return attrs.mtime;
+    }
+
+    // Listage paginé : le répertoire est lu en entier à la première page
+    // (et mis en cache s'il est actif) ; les pages suivantes reprennent dans
+    // cet instantané, abandonné à la dernière page ou dès qu'une opération de
+    // la session modifie le serveur
+    struct PageSnapshot {
+        std::string path;
+        uint64_t next = 0;          // position attendue de la page suivante
+        uint64_t generation = 0;    // du cache, à la lecture
+        std::shared_ptr<const DirectoryListing> listing;
+    };
+    std::mutex pagingMutex;
+    PageSnapshot paging;
+
+    bool listPage(SCPSession& owner, const std::string& path, size_t batchSize,
+                  const ListingBatchCallback& onBatch, ListingCursor& cursor) {
+        std::shared_ptr<const DirectoryListing> listing;
+        uint64_t generation = cache.generation();
+        {
+            std::lock_guard<std::mutex> lock(pagingMutex);
+            if (paging.listing && paging.path == path && paging.next == cursor.position &&
+                cursor.position > 0 && paging.generation == generation) {
+                listing = paging.listing;
+            }
+        }
+        if (!listing) {
+            auto fresh = std::make_shared<DirectoryListing>();
+            if (!owner.listDirectory(path, *fresh)) return false;
+            listing = fresh;
+        }
+
+        uint64_t size = listing->size();
+        uint64_t index = std::min(cursor.position, size);
+        uint64_t end = cursor.limit ? std::min(size, index + cursor.limit) : size;
+        bool cancelled = false;
+        std::vector<RemoteFile> batch;
+        batch.reserve((size_t)std::min<uint64_t>(batchSize, end - index));
+        RemoteFile file;
+        while (index < end && !cancelled) {
+            listing->entry((size_t)index++, file);
+            batch.push_back(file);
+            if (batch.size() >= batchSize || index == end) {
+                cancelled = !onBatch(batch);
+                batch.clear();
+            }
+        }
+
+        cursor.position = index;
+        cursor.complete = !cancelled && index >= size;
+        std::lock_guard<std::mutex> lock(pagingMutex);
+        if (cursor.complete) {
+            paging = PageSnapshot();
+        } else {
+            paging = PageSnapshot{path, index, generation, listing};
+        }
+        return true;
+    }
+
+    // Entrées d'un répertoire passées une à une au visiteur pendant la
+    // lecture ; le visiteur retourne false pour arrêter
+    using EntryVisitor = std::function<bool(const RemoteFile& file)>;
+
+    bool listEntries(const std::string& path, const EntryVisitor& visit) {
+        if (protocol == ProtocolType::SCP) {
+            return listSCP(path, visit);
+        }
+
+        if (!sftp) {
+            setError("SFTP not initialized");
+            return false;
+        }
+
+        RemoteFile file;
+        std::string base = path.empty() || path.back() == '/' ? path : path + "/";
+        auto toEntry = [&](const char* name, const LIBSSH2_SFTP_ATTRIBUTES& attrs) {
+            if (strcmp(name, ".") == 0 || strcmp(name, "..") == 0) return true;
+
+            file.name = name;
+            file.path.assign(base).append(name);
+            file.size = attrs.filesize;
+            file.permissions = attrs.permissions;
+            file.isDirectory = LIBSSH2_SFTP_S_ISDIR(attrs.permissions);
+            file.modificationTime = attrs.mtime;
+            return visit(file);
+        };
+
+        if (std::shared_ptr<SessionReactor> running = currentReactor()) {
+            SftpListOperation op(sftp, path, toEntry);
+            return runOnReactor(running, op);
+        }
+
+        BlockingScope blocking(*this);
+        LIBSSH2_SFTP_HANDLE* handle = libssh2_sftp_opendir(sftp, path.c_str());
+        if (!handle) {
+            setError("Failed to open directory: " + path);
+            return false;
+        }
+
+        char buffer[512];
+        LIBSSH2_SFTP_ATTRIBUTES attrs;
+        int rc;
+        while ((rc = libssh2_sftp_readdir(handle, buffer, sizeof(buffer), &attrs)) > 0) {
+            if (!toEntry(buffer, attrs)) break;
+        }
+        libssh2_sftp_closedir(handle);
+        if (rc < 0) {
+            setError("Failed to read directory: " + path);
+            return false;
+        }
+        return true;
+    }
+
+    // Listage en mode SCP, passé au visiteur au fil de la réception.
+    // `find -printf` (GNU) donne des champs séparés par NUL, sûrs quel que
+    // soit le nom ; à défaut, repli sur `ls -la` (voir RemoteListing.h).
+    bool listSCP(const std::string& path, const EntryVisitor& visit) {
+        std::string target = shellQuote(path.empty() || path[0] == '-' ? "./" + path : path);
+        std::string command =
+            "if find -H " + target + " -maxdepth 0 -printf '' >/dev/null 2>&1; then "
+            "find -H " + target + " -mindepth 1 -maxdepth 1 -printf '%y\\0%m\\0%s\\0%T@\\0%f\\0' 2>/dev/null; "
+            "else echo; "
+            "if ls -d --time-style=+%s / >/dev/null 2>&1; then echo @s; LC_ALL=C ls -la --time-style=+%s " + target + " 2>/dev/null; "
+            "elif ls -d -D %s / >/dev/null 2>&1; then echo @s; LC_ALL=C ls -laD %s " + target + " 2>/dev/null; "
+            "else LC_ALL=C ls -la " + target + " 2>/dev/null; fi; fi";
+
+        int exitStatus = 0;
+        uint64_t count = 0;
+        if (!streamListing(command, path, visit, exitStatus, count)) return false;
+
+        // Des entrées illisibles n'empêchent pas de lister les autres
+        if (exitStatus != 0 && count == 0) {
+            setError("Failed to list directory: " + path);
+            return false;
+        }
+        return true;
+    }
+
+    // Sortie `find -printf` (ou `ls -la`) analysée au fil de la réception.
+    // Une fois le visiteur arrêté, le canal est fermé sans lire la suite et
+    // exitStatus vaut 0.
+    bool streamListing(const std::string& command, const std::string& basePath,
+                       const EntryVisitor& visit, int& exitStatus, uint64_t& count) {
+        bool stopped = false;
+        ListingParser parser(basePath, [&](const RemoteFile& file) {
+            if (!stopped && !visit(file)) stopped = true;
+        });
+        exitStatus = -1;
+        if (std::shared_ptr<SessionReactor> running = currentReactor()) {
+            ExecOperation op(command);
+            op.onStdout = [&](const char* data, size_t length) {
+                parser.feed(data, length);
+                return !stopped;
+            };
+            if (!runOnReactor(running, op)) return false;
+            exitStatus = op.exitStatus;
+        } else {
+            std::string errorOutput;
+            bool ok = streamCommand(command, nullptr, [&](const char* data, size_t length) {
+                parser.feed(data, length);
+                return !stopped;
+            }, exitStatus, errorOutput);
+            if (!ok && !stopped) return false;
+        }
+        if (stopped) {
+            exitStatus = 0;
+        } else {
+            parser.finish();
+        }
+        count = parser.count();
+        return true;
+    }
+
+    // MARK: - Recherche
+
+    static bool matchesQuery(const ListingQuery& query, const RemoteFile& file) {
+        if (file.size < query.minSize) return false;
+        if (query.newerThan != 0 && file.modificationTime <= query.newerThan) return false;
+        return query.namePattern.empty() || fnmatch(query.namePattern.c_str(), file.name.c_str(), 0) == 0;
+    }
+
+    // Code de sortie de la sonde : find sans -printf ni -newermt
+    static const int findUnsupported = 86;
+
+    // Recherche SCP : la requête devient une commande `find` distante, seules
+    // les entrées retenues sont envoyées. `unsupported` : find trop ancien
+    // (BSD, busybox), à remplacer par un parcours.
+    bool findSCP(const std::string& path, const ListingQuery& query, const EntryVisitor& visit,
+                 bool& unsupported) {
+        std::string target = shellQuote(path.empty() || path[0] == '-' ? "./" + path : path);
+        std::string tests = " -mindepth 1";
+        if (!query.recursive) tests += " -maxdepth 1";
+        if (!query.namePattern.empty()) tests += " -name " + shellQuote(query.namePattern);
+        if (query.minSize > 0) tests += " -size +" + std::to_string(query.minSize - 1) + "c";
+        if (query.newerThan != 0) tests += " -newermt @" + std::to_string(query.newerThan);
+        std::string command =
+            "if find -H " + target + " -maxdepth 0 -newermt @0 -printf '' >/dev/null 2>&1; then "
+            "find -H " + target + tests + " -printf '%y\\0%m\\0%s\\0%T@\\0%P\\0' 2>/dev/null; "
+            "else exit " + std::to_string(findUnsupported) + "; fi";
+
+        // %P : chemin relatif au point de départ ; le nom est sa fin
+        RemoteFile entry;
+        auto named = [&](const RemoteFile& file) {
+            entry = file;
+            size_t slash = entry.name.rfind('/');
+            if (slash != std::string::npos) entry.name.erase(0, slash + 1);
+            return visit(entry);
+        };
+
+        int exitStatus = 0;
+        uint64_t count = 0;
+        unsupported = false;
+        if (!streamListing(command, path, named, exitStatus, count)) return false;
+        if (exitStatus == findUnsupported && count == 0) {
+            unsupported = true;
+            return false;
+        }
+        // Des sous-répertoires illisibles n'empêchent pas de chercher ailleurs
+        return true;
+    }
+
+    // Recherche par parcours (SFTP, ou find distant trop ancien) : chaque
+    // répertoire est listé par le premier worker libre dès sa découverte, le
+    // filtre appliqué au fil des entrées. Le premier worker est cette
+    // session ; les autres sont pris au pool sans attendre.
+    bool walkFind(const std::string& root, const ListingQuery& query, unsigned workers,
+                  const EntryVisitor& visit) {
+        std::mutex mutex;
+        std::condition_variable changed;
+        std::deque<std::string> pending{root};
+        size_t active = 0;
+        bool stopped = false;
+        bool rootFailed = false;
+        std::string rootError;
+
+        auto work = [&](Impl& impl) {
+            std::unique_lock<std::mutex> lock(mutex);
+            while (true) {
+                changed.wait(lock, [&]() { return stopped || !pending.empty() || active == 0; });
+                // Plus rien en attente ni en cours : parcours terminé
+                if (stopped || pending.empty()) break;
+                std::string directory = std::move(pending.front());
+                pending.pop_front();
+                ++active;
+                lock.unlock();
+
+                std::vector<std::string> children;
+                bool ok = impl.listEntries(directory, [&](const RemoteFile& file) {
+                    if (query.recursive && file.isDirectory) children.push_back(file.path);
+                    if (!matchesQuery(query, file)) return true;
+                    std::lock_guard<std::mutex> guard(mutex);
+                    if (!stopped && !visit(file)) stopped = true;
+                    return !stopped;
+                });
+
+                lock.lock();
+                --active;
+                // Sous-répertoires illisibles ignorés, comme find
+                if (!ok && directory == root) {
+                    rootFailed = true;
+                    rootError = impl.errorText();
+                    stopped = true;
+                }
+                for (std::string& child : children) pending.push_back(std::move(child));
+                changed.notify_all();
+            }
+        };
+
+        std::vector<std::thread> threads;
+        if (query.recursive) {
+            unsigned byPool = std::max(1u, SessionPool::shared().getMaxSessionsPerHost() - 1);
+            unsigned extra = std::max(1u, std::min(workers, byPool)) - 1;
+            for (unsigned i = 0; i < extra; ++i) {
+                threads.emplace_back([&]() {
+                    std::string error;
+                    SessionPool::Lease lease = acquireLease(protocol, error, false);
+                    if (lease) work(*lease->pImpl);
+                });
+            }
+        }
+        work(*this);
+        for (std::thread& thread : threads) {
+            thread.join();
+        }
+
+        if (rootFailed) {
+            setError(rootError.empty() ? "Failed to list directory: " + root : rootError);
+            return false;
+        }
+        return true;
+    }
+
+    // MARK: - Lots
+
+    enum class BatchOperation { Unlink, Mkdir, Rmdir };
+
+    // Même message que l'opération unitaire
+    static std::string batchFailure(BatchOperation operation, const std::string& path) {
+        switch (operation) {
+        case BatchOperation::Unlink: return "Failed to delete file: " + path;
+        case BatchOperation::Mkdir: return "Failed to create directory: " + path;
+        case BatchOperation::Rmdir: return "Failed to delete directory: " + path;
+        }
+        return path;
+    }
+
+    bool runBatch(BatchOperation operation, const std::vector<std::string>& paths,
+                  std::vector<PathResult>* results) {
+        std::vector<PathResult> local;
+        std::vector<PathResult>& outcome = results ? *results : local;
+        outcome.assign(paths.size(), PathResult());
+        for (size_t i = 0; i < paths.size(); ++i) {
+            outcome[i].path = paths[i];
+            outcome[i].error = batchFailure(operation, paths[i]);
+        }
+        if (paths.empty()) return true;
+
+        bool ran;
+        if (!session) {
+            setError("Not connected");
+            ran = false;
+        } else if (protocol == ProtocolType::SCP) {
+            ran = batchScript(operation, paths, outcome);
+        } else {
+            ran = batchSFTP(operation, paths, outcome);
+        }
+        for (const PathResult& result : outcome) {
+            if (!result.ok) continue;
+            cache.invalidateParent(result.path);
+            if (operation == BatchOperation::Rmdir) cache.invalidateTree(result.path);
+        }
+
+        // Lot interrompu : les chemins en échec prennent sa cause
+        if (!ran) {
+            std::lock_guard<std::mutex> lock(errorMutex);
+            for (PathResult& result : outcome) {
+                if (!result.ok) result.error = lastError;
+            }
+        }
+        for (const PathResult& result : outcome) {
+            if (!result.ok) {
+                setError(result.error);
+                return false;
+            }
+        }
+        return true;
+    }
+
+    // Script passé par blocs sur stdin d'un seul `sh`. Les chemins vont par
+    // groupes à une seule commande (rm, mkdir et rmdir continuent après un
+    // échec et traitent leurs arguments dans l'ordre), puis chaque chemin est
+    // vérifié par `test`, intégré au shell : un statut (+ ou -) par chemin,
+    // lu au fil de l'eau, sans un processus par chemin. Pour rm et rmdir,
+    // l'existence est relevée avant la commande : un chemin absent n'est pas
+    // compté comme supprimé.
+    bool batchScript(BatchOperation operation, const std::vector<std::string>& paths,
+                     std::vector<PathResult>& results) {
+        const char* before = operation == BatchOperation::Mkdir ? ""
+            : "e=; for p in \"$@\"; do if [ -e \"$p\" ] || [ -L \"$p\" ]; then e=${e}1; else e=${e}0; fi; done\n";
+        const char* command = operation == BatchOperation::Unlink ? "rm -- \"$@\"\n"
+                            : operation == BatchOperation::Mkdir ? "mkdir -p -- \"$@\"\n"
+                            : "rmdir -- \"$@\"\n";
+        const char* check = operation == BatchOperation::Mkdir
+            ? "for p in \"$@\"; do if [ -d \"$p\" ]; then echo +; else echo -; fi; done\n"
+            : "for p in \"$@\"; do case $e in 1*) if [ -e \"$p\" ] || [ -L \"$p\" ]; then echo -; else echo +; fi;; "
+              "*) echo -;; esac; e=${e#?}; done\n";
+        size_t next = 0;
+        size_t answered = 0;
+        bool started = false;
+        std::string line;
+        int exitStatus = -1;
+        std::string errorOutput;
+
+        return streamCommand("sh", [&](std::string& script, bool& eof) {
+            if (!started) {
+                script += "exec 2>/dev/null\n";
+                started = true;
+            }
+            script += "set --";
+            size_t first = next;
+            while (next < paths.size() && (next == first || script.size() < BufferPool::packetSize)) {
+                script += ' ';
+                script += shellQuote(paths[next++]);
+            }
+            script += '\n';
+            script += before;
+            script += command;
+            script += check;
+            eof = next == paths.size();
+            return true;
+        }, [&](const char* data, size_t length) {
+            for (size_t i = 0; i < length; ++i) {
+                if (data[i] != '\n') {
+                    line += data[i];
+                    continue;
+                }
+                if (answered < results.size() && line == "+") {
+                    results[answered].ok = true;
+                    results[answered].error.clear();
+                }
+                ++answered;
+                line.clear();
+            }
+            return true;
+        }, exitStatus, errorOutput);
+    }
+
+    // libssh2 ne garde qu'une requête unlink/mkdir/rmdir en cours par
+    // instance SFTP : le lot ouvre d'autres instances (un canal chacune) sur
+    // la session et les mène en non bloquant, une requête en vol par voie.
+    bool batchSFTP(BatchOperation operation, const std::vector<std::string>& paths,
+                   std::vector<PathResult>& results) {
+        if (!sftp) {
+            setError("SFTP not initialized");
+            return false;
+        }
+        BlockingScope blocking(*this);
+
+        struct Lane {
+            LIBSSH2_SFTP* sftp;
+            bool owned;
+            size_t index;   // chemin en vol, npos : libre
+        };
+        const size_t idle = std::string::npos;
+
+        // Une voie de plus coûte l'ouverture d'un canal : pas en dessous de
+        // 8 chemins par voie ; un refus du serveur limite simplement le lot
+        size_t laneCount = std::min<size_t>(std::max(1u, transferWindow), (paths.size() + 7) / 8);
+        std::vector<Lane> lanes = {{sftp, false, idle}};
+        while (lanes.size() < laneCount) {
+            LIBSSH2_SFTP* extra = libssh2_sftp_init(session);
+            if (!extra) break;
+            lanes.push_back({extra, true, idle});
+        }
+
+        // Un chemin attend les chemins précédents encore en vol qui le
+        // contiennent ou qu'il contient
+        auto blocked = [&](size_t index) {
+            const std::string& path = paths[index];
+            for (const Lane& lane : lanes) {
+                if (lane.index == idle) continue;
+                const std::string& other = paths[lane.index];
+                const std::string& inner = other.size() < path.size() ? path : other;
+                const std::string& outer = other.size() < path.size() ? other : path;
+                if (inner.size() > outer.size() && inner.compare(0, outer.size(), outer) == 0 &&
+                    (inner[outer.size()] == '/' || outer.back() == '/')) {
+                    return true;
+                }
+            }
+            return false;
+        };
+
+        libssh2_session_set_blocking(session, 0);
+        size_t next = 0;
+        size_t inFlight = 0;
+        int transportOwner = -1;   // voie dont un paquet est partiellement envoyé
+        int idleRounds = 0;
+        bool ok = true;
+
+        while (ok && (next < paths.size() || inFlight > 0)) {
+            bool progressed = false;
+            for (size_t i = 0; i < lanes.size() && ok; ++i) {
+                if (transportOwner >= 0 && (size_t)transportOwner != i) continue;
+                Lane& lane = lanes[i];
+                if (lane.index == idle) {
+                    if (next == paths.size() || blocked(next)) continue;
+                    lane.index = next++;
+                    ++inFlight;
+                }
+
+                const std::string& path = paths[lane.index];
+                int rc;
+                switch (operation) {
+                case BatchOperation::Unlink:
+                    rc = libssh2_sftp_unlink_ex(lane.sftp, path.c_str(), path.size());
+                    break;
+                case BatchOperation::Mkdir:
+                    rc = libssh2_sftp_mkdir_ex(lane.sftp, path.c_str(), path.size(),
+                                               LIBSSH2_SFTP_S_IRWXU | LIBSSH2_SFTP_S_IRGRP |
+                                               LIBSSH2_SFTP_S_IXGRP | LIBSSH2_SFTP_S_IROTH |
+                                               LIBSSH2_SFTP_S_IXOTH);
+                    break;
+                case BatchOperation::Rmdir:
+                    rc = libssh2_sftp_rmdir_ex(lane.sftp, path.c_str(), path.size());
+                    break;
+                }
+
+                if (rc == LIBSSH2_ERROR_EAGAIN) {
+                    bool partial = libssh2_session_block_directions(session) &
+                                   LIBSSH2_SESSION_BLOCK_OUTBOUND;
+                    transportOwner = partial ? (int)i : -1;
+                    continue;
+                }
+                transportOwner = -1;
+                if (rc == 0) {
+                    results[lane.index].ok = true;
+                    results[lane.index].error.clear();
+                } else if (rc != LIBSSH2_ERROR_SFTP_PROTOCOL) {
+                    setError("SFTP session error");
+                    ok = false;
+                }
+                lane.index = idle;
+                --inFlight;
+                progressed = true;
+            }
+            // Un appel a pu lire la réponse d'une voie déjà passée dans ce
+            // tour : le socket n'en dit plus rien, d'où un second tour à vide
+            // avant d'attendre
+            idleRounds = progressed ? 0 : idleRounds + 1;
+            if (ok && idleRounds >= 2) {
+                waitSocket(sock, session);
+            }
+        }
+
+        libssh2_session_set_blocking(session, 1);
+        for (const Lane& lane : lanes) {
+            if (lane.owned) libssh2_sftp_shutdown(lane.sftp);
+        }
+        return ok;
+    }
+
+    // MARK: - Opérations côté serveur
+
+    // Commande dont seul le statut compte ; en échec, la première ligne de
+    // stderr complète le message
+    bool runServerCommand(const std::string& command, const std::string& failure) {
+        int exitStatus = -1;
+        std::string errorOutput;
+        if (!streamCommand(command, nullptr, [](const char*, size_t) { return true; },
+                           exitStatus, errorOutput)) {
+            return false;
+        }
+        if (exitStatus == 0) return true;
+        std::string detail = errorOutput.substr(0, errorOutput.find('\n'));
+        setError(detail.empty() ? failure : failure + " (" + detail + ")");
+        return false;
+    }
+
+    // Arborescence SFTP : listée par le parcours de la recherche, puis
+    // supprimée en deux lots pipelinés. Le lot des répertoires va des plus
+    // longs chemins aux plus courts : un répertoire n'est envoyé qu'après
+    // ses sous-répertoires (batchSFTP retient un chemin tant qu'un
+    // descendant est en vol).
+    bool removeSFTPTree(const std::string& path) {
+        LIBSSH2_SFTP_ATTRIBUTES attrs;
+        int rc;
+        unsigned long status = 0;
+        {
+            BlockingScope blocking(*this);
+            rc = libssh2_sftp_stat_ex(sftp, path.c_str(), path.size(), LIBSSH2_SFTP_LSTAT, &attrs);
+            if (rc == LIBSSH2_ERROR_SFTP_PROTOCOL) status = libssh2_sftp_last_error(sftp);
+        }
+        // Déjà absent : succès, comme rm -rf
+        if (status == LIBSSH2_FX_NO_SUCH_FILE) return true;
+        if (rc != 0) {
+            setError("Failed to delete directory: " + path);
+            return false;
+        }
+        // Fichier ou lien symbolique : jamais suivi
+        if (!LIBSSH2_SFTP_S_ISDIR(attrs.permissions)) {
+            return runBatch(BatchOperation::Unlink, {path}, nullptr);
+        }
+
+        ListingQuery query;
+        query.recursive = true;
+        std::vector<std::string> files;
+        std::vector<std::string> dirs;
+        bool listed = walkFind(path, query, 4, [&](const RemoteFile& file) {
+            (file.isDirectory ? dirs : files).push_back(file.path);
+            return true;
+        });
+        if (!listed) return false;
+
+        std::stable_sort(dirs.begin(), dirs.end(), [](const std::string& a, const std::string& b) {
+            return a.size() > b.size();
+        });
+        dirs.push_back(path);
+        // Des fichiers restants laisseraient les répertoires non vides : le
+        // premier échec est plus parlant
+        return runBatch(BatchOperation::Unlink, files, nullptr) &&
+               runBatch(BatchOperation::Rmdir, dirs, nullptr);
+    }
+
+    bool moveSFTP(const std::string& source, const std::string& destination) {
+        int rc;
+        unsigned long status = 0;
+        {
+            BlockingScope blocking(*this);
+            rc = libssh2_sftp_rename_ex(sftp, source.c_str(), source.size(),
+                                        destination.c_str(), destination.size(),
+                                        LIBSSH2_SFTP_RENAME_OVERWRITE | LIBSSH2_SFTP_RENAME_ATOMIC |
+                                        LIBSSH2_SFTP_RENAME_NATIVE);
+            if (rc == LIBSSH2_ERROR_SFTP_PROTOCOL) status = libssh2_sftp_last_error(sftp);
+        }
+        if (rc == 0) return true;
+        // Refus générique (autre système de fichiers, destination existante
+        // pour un serveur SFTP v3) : mv sait copier puis supprimer
+        if (status == LIBSSH2_FX_FAILURE || status == LIBSSH2_FX_OP_UNSUPPORTED) {
+            return runServerCommand("mv -f -- " + shellQuote(source) + " " + shellQuote(destination),
+                                    "Failed to move: " + source);
+        }
+        setError("Failed to move: " + source);
+        return false;
+    }
+
+    // MARK: - Reprise
+
+    // Intervalle entre deux sauvegardes du journal
+    static const uint64_t journalInterval = 64ull * 1024 * 1024;
+
+    // Opération SFTP sur cette session, ou en mode SCP sur une session du pool
+    bool withSFTP(const std::function<bool(Impl& impl)>& operation) {
+        if (sftp) return operation(*this);
+
+        std::string error;
+        SessionPool::Lease lease = acquireStripe(error);
+        if (!lease) {
+            setError("SFTP session unavailable: " + error);
+            return false;
+        }
+        lease->pImpl->throttle = throttle;
+        bool ok = operation(*lease->pImpl);
+        lease->pImpl->throttle.reset();
+        if (!ok) setError(lease->getLastError());
+        return ok;
+    }
+
+    // Petits fichiers distants (journal d'upload)
+    bool readRemoteText(const std::string& path, std::string& text) {
+        LIBSSH2_SFTP_HANDLE* handle = libssh2_sftp_open(sftp, path.c_str(), LIBSSH2_FXF_READ, 0);
+        if (!handle) return false;
+        BufferPool::Buffer buffer = BufferPool::shared().acquire(BufferPool::packetSize);
+        ssize_t nread;
+        while ((nread = libssh2_sftp_read(handle, buffer.data(), buffer.size())) > 0) {
+            text.append(buffer.data(), nread);
+        }
+        libssh2_sftp_close(handle);
+        return nread == 0;
+    }
+
+    bool writeRemoteText(const std::string& path, const std::string& text) {
+        LIBSSH2_SFTP_HANDLE* handle = libssh2_sftp_open(sftp, path.c_str(),
+                                                         LIBSSH2_FXF_WRITE | LIBSSH2_FXF_CREAT | LIBSSH2_FXF_TRUNC,
+                                                         LIBSSH2_SFTP_S_IRUSR | LIBSSH2_SFTP_S_IWUSR |
+                                                         LIBSSH2_SFTP_S_IRGRP | LIBSSH2_SFTP_S_IROTH);
+        if (!handle) return false;
+        size_t offset = 0;
+        while (offset < text.size()) {
+            ssize_t written = libssh2_sftp_write(handle, text.data() + offset, text.size() - offset);
+            if (written < 0) break;
+            offset += written;
+        }
+        return libssh2_sftp_close(handle) == 0 && offset == text.size();
+    }
+
+    // SHA-256 d'une plage d'un fichier distant
+    bool remoteDigest(const std::string& path, uint64_t start, uint64_t length, std::string& hex) {
+        std::string command = "tail -c +" + std::to_string(start + 1) + " " + shellQuote(path) +
+                              " | head -c " + std::to_string(length) +
+                              " | { sha256sum 2>/dev/null || shasum -a 256; }";
+        std::string output;
+        std::string errorOutput;
+        int exitStatus = -1;
+        bool ok = streamCommand(command, nullptr, [&](const char* data, size_t length) {
+            if (output.size() < 256) output.append(data, length);
+            return true;
+        }, exitStatus, errorOutput);
+        if (!ok || exitStatus != 0) return false;
+        hex = output.substr(0, output.find(' '));
+        return hex.size() == 64;
+    }
+
+    // Somme des tailles des fichiers réguliers sous `paths` (relatifs à
+    // `dir`, tout `dir` si vide), pour la progression d'une archive ; 0 si
+    // inconnue. Chemins sur stdin, séparés par NUL ; stat GNU puis BSD.
+    uint64_t remoteTreeSize(const std::string& dir, const std::vector<std::string>& paths) {
+        std::string command =
+            "cd " + shellQuote(dir) + " && xargs -0 sh -c '"
+            "find \"$@\" -type f -exec stat -c %s {} + 2>/dev/null || "
+            "find \"$@\" -type f -exec stat -f %z {} +' sh | awk '{ s += $1 } END { print s + 0 }'";
+        bool listSent = false;
+        std::string output;
+        std::string errorOutput;
+        int exitStatus = -1;
+        bool ok = streamCommand(command, [&](std::string& out, bool& eof) {
+            if (!listSent) {
+                if (paths.empty()) out.append(".\0", 2);
+                for (const std::string& path : paths) {
+                    out += path;
+                    out += '\0';
+                }
+                listSent = true;
+            }
+            eof = true;
+            return true;
+        }, [&](const char* data, size_t length) {
+            if (output.size() < 64) output.append(data, length);
+            return true;
+        }, exitStatus, errorOutput);
+        if (!ok || exitStatus != 0) return 0;
+        return strtoull(output.c_str(), nullptr, 10);
+    }
+
+    // Contrôle optionnel : seules les plages de même empreinte des deux côtés
+    // sont conservées
+    void verifyJournal(TransferJournal& journal, int fd, const std::string& remotePath) {
+        std::vector<JournalRange> kept;
+        for (const JournalRange& range : journal.ranges) {
+            std::string local, remote;
+            if (sha256Range(fd, range.start, range.end - range.start, local) &&
+                remoteDigest(remotePath, range.start, range.end - range.start, remote) &&
+                local == remote) {
+                kept.push_back(range);
+            }
+        }
+        journal.ranges = kept;
+    }
+
+    // `verify` vient de la session appelante (celle-ci peut être empruntée)
+    bool resumeDownload(const std::string& remotePath, const std::string& localPath,
+                        const ProgressCallback& callback, bool verify) {
+        LIBSSH2_SFTP_ATTRIBUTES attrs;
+        int rc;
+        {
+            BlockingScope blocking(*this);
+            rc = libssh2_sftp_stat(sftp, remotePath.c_str(), &attrs);
+        }
+        if (rc != 0) {
+            setError("Cannot open remote file: " + remotePath);
+            return false;
+        }
+        if (!(attrs.flags & LIBSSH2_SFTP_ATTR_SIZE)) {
+            setError("Remote file size unknown, cannot resume: " + remotePath);
+            return false;
+        }
+        uint64_t totalSize = attrs.filesize;
+        int64_t mtime = (attrs.flags & LIBSSH2_SFTP_ATTR_ACMODTIME) ? (int64_t)attrs.mtime : 0;
+
+        int fd = open(localPath.c_str(), O_RDWR | O_CREAT, 0644);
+        if (fd < 0) {
+            setError("Cannot create local file: " + localPath);
+            return false;
+        }
+
+        // Journal d'une tentative précédente sur la même source
+        std::string journalPath = TransferJournal::pathFor(localPath);
+        TransferJournal journal;
+        struct stat localInfo;
+        if (fstat(fd, &localInfo) != 0) {
+            setError("Cannot stat local file: " + localPath);
+            close(fd);
+            return false;
+        }
+        if (!journal.load(journalPath) || !journal.sameSource(totalSize, mtime)) {
+            journal = TransferJournal(totalSize, mtime);
+        }
+        journal.clip(localInfo.st_size);
+        if (verify) verifyJournal(journal, fd, remotePath);
+        if (journal.ranges.empty() && ftruncate(fd, 0) != 0) {
+            setError("Cannot truncate local file: " + localPath);
+            close(fd);
+            return false;
+        }
+        LocalFileWriter::prepare(fd, totalSize, uncachedDownloads);
+
+        // Les données sont sur disque avant que le journal les annonce
+        auto checkpoint = [&]() {
+            fsync(fd);
+            return journal.save(journalPath);
+        };
+        if (!checkpoint()) {
+            setError("Cannot write resume journal: " + journalPath);
+            close(fd);
+            return false;
+        }
+
+        uint64_t transferred = journal.completed();
+        uint64_t sinceCheckpoint = 0;
+        bool ok = true;
+        {
+            BlockingScope blocking(*this);
+            for (const JournalRange& gap : journal.missing()) {
+                ok = downloadSFTPRange(remotePath, fd, gap.start, gap.end, [&](uint64_t bytes) {
+                    transferred += bytes;
+                    if (callback) {
+                        callback(transferred, totalSize);
+                    }
+                    return true;
+                }, [&](uint64_t offset, uint64_t bytes) {
+                    journal.add(offset, offset + bytes);
+                    sinceCheckpoint += bytes;
+                    if (sinceCheckpoint >= journalInterval) {
+                        sinceCheckpoint = 0;
+                        checkpoint();
+                    }
+                });
+                if (!ok) break;
+            }
+        }
+
+        if (ok && journal.completed() != totalSize) {
+            setError("Remote file changed during download: " + remotePath);
+            ok = false;
+        }
+        if (ok && ftruncate(fd, (off_t)totalSize) != 0) {
+            setError("Cannot truncate local file: " + localPath);
+            ok = false;
+        }
+        // Journal gardé pour une reprise seulement si la connexion est perdue
+        if (ok || connectionAlive(remotePath)) {
+            unlink(journalPath.c_str());
+        } else {
+            checkpoint();
+        }
+        close(fd);
+        return ok;
+    }
+
+    // Après un échec : le serveur répond-il encore ? Un statut SFTP (fichier
+    // absent compris) est une réponse ; une erreur de transport non.
+    bool connectionAlive(const std::string& remotePath) {
+        BlockingScope blocking(*this);
+        LIBSSH2_SFTP_ATTRIBUTES attrs;
+        return libssh2_sftp_stat(sftp, remotePath.c_str(), &attrs) == 0 ||
+               libssh2_session_last_errno(session) == LIBSSH2_ERROR_SFTP_PROTOCOL;
+    }
+
+    bool resumeUpload(const std::string& localPath, const std::string& remotePath,
+                      const ProgressCallback& callback, bool verify) {
+        int fd = open(localPath.c_str(), O_RDONLY);
+        if (fd < 0) {
+            setError("Cannot open local file: " + localPath);
+            return false;
+        }
+        struct stat fileInfo;
+        if (fstat(fd, &fileInfo) != 0) {
+            setError("Cannot stat local file: " + localPath);
+            close(fd);
+            return false;
+        }
+        uint64_t totalSize = fileInfo.st_size;
+
+        // Journal d'une tentative précédente, à côté du fichier distant
+        std::string journalPath = TransferJournal::pathFor(remotePath);
+        TransferJournal journal;
+        {
+            BlockingScope blocking(*this);
+            std::string text;
+            LIBSSH2_SFTP_ATTRIBUTES attrs;
+            if (readRemoteText(journalPath, text) && journal.parse(text) &&
+                journal.sameSource(totalSize, fileInfo.st_mtime) &&
+                libssh2_sftp_stat(sftp, remotePath.c_str(), &attrs) == 0 &&
+                (attrs.flags & LIBSSH2_SFTP_ATTR_SIZE)) {
+                journal.clip(attrs.filesize);
+            } else {
+                journal = TransferJournal(totalSize, fileInfo.st_mtime);
+            }
+        }
+        if (verify) verifyJournal(journal, fd, remotePath);
+
+        BlockingScope blocking(*this);
+        unsigned long flags = LIBSSH2_FXF_WRITE | LIBSSH2_FXF_CREAT;
+        if (journal.ranges.empty()) flags |= LIBSSH2_FXF_TRUNC;
+        LIBSSH2_SFTP_HANDLE* handle = libssh2_sftp_open(sftp, remotePath.c_str(), flags,
+                                                         LIBSSH2_SFTP_S_IRUSR | LIBSSH2_SFTP_S_IWUSR |
+                                                         LIBSSH2_SFTP_S_IRGRP | LIBSSH2_SFTP_S_IROTH);
+        if (!handle) {
+            setError("Cannot create remote file: " + remotePath);
+            close(fd);
+            return false;
+        }
+        if (!writeRemoteText(journalPath, journal.serialize())) {
+            setError("Cannot write resume journal: " + journalPath);
+            libssh2_sftp_close(handle);
+            close(fd);
+            return false;
+        }
+
+        // Seuls les octets acquittés par le serveur entrent dans le journal
+        uint64_t transferred = journal.completed();
+        uint64_t sinceCheckpoint = 0;
+        bool ok = true;
+        for (const JournalRange& gap : journal.missing()) {
+            uint64_t acked = gap.start;
+            ok = uploadSFTPRange(handle, fd, gap.start, gap.end - gap.start, [&](uint64_t bytes) {
+                journal.add(acked, acked + bytes);
+                acked += bytes;
+                transferred += bytes;
+                sinceCheckpoint += bytes;
+                if (sinceCheckpoint >= journalInterval) {
+                    sinceCheckpoint = 0;
+                    writeRemoteText(journalPath, journal.serialize());
+                }
+                if (callback) {
+                    callback(transferred, totalSize);
+                }
+                return true;
+            });
+            if (!ok) break;
+        }
+
+        if (ok && journal.completed() != totalSize) {
+            setError("Local file changed during upload: " + localPath);
+            ok = false;
+        }
+        if (ok) {
+            // Destination plus longue que la source : tronquer
+            LIBSSH2_SFTP_ATTRIBUTES attrs;
+            memset(&attrs, 0, sizeof(attrs));
+            attrs.flags = LIBSSH2_SFTP_ATTR_SIZE;
+            attrs.filesize = totalSize;
+            if (libssh2_sftp_fsetstat(handle, &attrs) != 0) {
+                setError("Failed to truncate remote file: " + remotePath);
+                ok = false;
+            }
+        }
+        if (libssh2_sftp_close(handle) != 0 && ok) {
+            setError("Failed to close remote file: " + remotePath);
+            ok = false;
+        }
+        // Échec, connexion encore là : le journal est retiré du serveur. Sur
+        // une connexion perdue la suppression échoue et le dernier point de
+        // reprise reste pour la tentative suivante.
+        libssh2_sftp_unlink(sftp, journalPath.c_str());
+        close(fd);
+        return ok;
+    }
+
+    // MARK: - Intégrité
+
+    // Empreintes SHA-256 distantes des segments `indices` (tous si vide),
+    // par groupes de processus en parallèle sur le serveur. Chaque ligne
+    // "<index> <empreinte>" est écrite d'un bloc : les sorties des
+    // processus ne se mêlent pas.
+    bool remoteSegmentDigests(const std::string& path, const std::vector<size_t>& indices,
+                              std::vector<std::string>& digests, uint64_t& remoteSize) {
+        const std::string segment = std::to_string(SegmentHasher::segmentSize);
+        unsigned jobs = std::max(1u, hashThreads ? hashThreads : 4u);
+        std::string command = "f=" + shellQuote(path) + "; s=$(wc -c < \"$f\") || exit 1; echo \"s $s\"; ";
+        if (indices.empty()) {
+            command += "c=$(( (s + " + segment + " - 1) / " + segment + " )); i=0; "
+                       "while [ $i -lt $c ]; do ";
+        } else {
+            command += "for i in";
+            for (size_t index : indices) command += " " + std::to_string(index);
+            command += "; do ";
+        }
+        command += "(h=$(dd if=\"$f\" bs=" + segment + " skip=$i count=1 2>/dev/null"
+                   " | { sha256sum 2>/dev/null || shasum -a 256; }) && echo \"$i ${h%% *}\") & "
+                   "n=$((n+1)); [ $n -lt " + std::to_string(jobs) + " ] || { wait; n=0; }; ";
+        if (indices.empty()) command += "i=$((i+1)); ";
+        command += "done; wait";
+
+        std::string output;
+        std::string errorOutput;
+        int exitStatus = -1;
+        bool ok = streamCommand(command, nullptr, [&](const char* data, size_t length) {
+            output.append(data, length);
+            return true;
+        }, exitStatus, errorOutput);
+        if (!ok) return false;
+
+        bool sized = false;
+        size_t start = 0;
+        for (size_t end; (end = output.find('\n', start)) != std::string::npos; start = end + 1) {
+            std::string line = output.substr(start, end - start);
+            if (line.compare(0, 2, "s ") == 0) {
+                char* tail = nullptr;
+                remoteSize = strtoull(line.c_str() + 2, &tail, 10);
+                sized = tail != line.c_str() + 2;
+                continue;
+            }
+            size_t space = line.find(' ');
+            if (space == std::string::npos || line.size() - space - 1 != 64) continue;
+            size_t index = strtoull(line.c_str(), nullptr, 10);
+            if (index >= digests.size()) digests.resize(index + 1);
+            digests[index] = line.substr(space + 1);
+        }
+        if (!sized) {
+            setError("Cannot read remote file: " + path);
+            return false;
+        }
+        return true;
+    }
+
+    // Transfert (`transfer`) puis contrôle par segments, renvoi des segments
+    // différents et nouveau contrôle de ceux-ci
+    bool verifiedTransfer(bool upload, const std::string& localPath, const std::string& remotePath,
+                          const std::function<bool()>& transfer) {
+        {
+            std::lock_guard<std::mutex> lock(errorMutex);
+            integrity = IntegrityReport();
+            integrity.segmentSize = SegmentHasher::segmentSize;
+        }
+
+        // Upload : la source, déjà complète sur le disque, est hachée pendant
+        // qu'elle part. Download : le fichier écrit est relu pendant que le
+        // serveur hache (depuis le disque s'il a été écrit hors du cache de
+        // pages).
+        int fd = -1;
+        std::unique_ptr<SegmentHasher> hasher;
+        uint64_t localSize = 0;
+        auto startHashing = [&]() {
+            fd = open(localPath.c_str(), upload ? O_RDONLY : O_RDWR);
+            if (fd < 0) return false;
+            struct stat info;
+            if (fstat(fd, &info) != 0) {
+                close(fd);
+                fd = -1;
+                return false;
+            }
+            localSize = info.st_size;
+            hasher.reset(new SegmentHasher(fd, localSize, hashThreads));
+            return true;
+        };
+        auto finish = [&](bool ok) {
+            hasher.reset();
+            if (fd >= 0) close(fd);
+            return ok;
+        };
+
+        if (upload && !startHashing()) {
+            setError("Cannot open local file: " + localPath);
+            return false;
+        }
+        if (!transfer()) return finish(false);
+        if (!upload && !startHashing()) {
+            setError("Cannot open local file: " + localPath);
+            return false;
+        }
+
+        std::vector<std::string> remote;
+        uint64_t remoteSize = 0;
+        if (!remoteSegmentDigests(remotePath, {}, remote, remoteSize)) return finish(false);
+        std::vector<std::string> local = hasher->digests();
+        if (local.size() != SegmentHasher::segmentCount(localSize)) {
+            setError("Cannot read local file: " + localPath);
+            return finish(false);
+        }
+
+        uint64_t sourceSize = upload ? localSize : remoteSize;
+        size_t count = SegmentHasher::segmentCount(sourceSize);
+        remote.resize(std::max(remote.size(), count));
+        local.resize(std::max(local.size(), count));
+        std::vector<size_t> differing;
+        for (size_t index = 0; index < count; ++index) {
+            if (remote[index].empty() && !local[index].empty() && index * SegmentHasher::segmentSize < remoteSize) {
+                setError("Remote hashing unavailable (sha256sum or shasum): " + remotePath);
+                return finish(false);
+            }
+            if (local[index].empty() || local[index] != remote[index]) differing.push_back(index);
+        }
+
+        std::vector<ByteRange> ranges;
+        for (size_t index : differing) {
+            uint64_t start = index * SegmentHasher::segmentSize;
+            uint64_t end = std::min(start + SegmentHasher::segmentSize, sourceSize);
+            if (!ranges.empty() && ranges.back().end == start) {
+                ranges.back().end = end;
+            } else {
+                ranges.push_back({start, end});
+            }
+        }
+        {
+            std::lock_guard<std::mutex> lock(errorMutex);
+            integrity.checked = true;
+            integrity.mismatched = ranges;
+        }
+        if (ranges.empty() && localSize == remoteSize) {
+            std::lock_guard<std::mutex> lock(errorMutex);
+            integrity.verified = true;
+            return finish(true);
+        }
+
+        // Renvoi des seules plages différentes, puis taille de la source
+        uint64_t resent = 0;
+        auto counter = [&](uint64_t bytes) {
+            resent += bytes;
+            return true;
+        };
+        bool repaired = withSFTP([&](Impl& impl) {
+            BlockingScope blocking(impl);
+            if (!upload) {
+                for (const ByteRange& range : ranges) {
+                    if (!impl.downloadSFTPRange(remotePath, fd, range.start, range.end, counter)) return false;
+                }
+                if (ftruncate(fd, (off_t)sourceSize) != 0) {
+                    impl.setError("Cannot truncate local file: " + localPath);
+                    return false;
+                }
+                return true;
+            }
+            LIBSSH2_SFTP_HANDLE* handle = libssh2_sftp_open(impl.sftp, remotePath.c_str(),
+                                                             LIBSSH2_FXF_WRITE | LIBSSH2_FXF_CREAT,
+                                                             LIBSSH2_SFTP_S_IRUSR | LIBSSH2_SFTP_S_IWUSR |
+                                                             LIBSSH2_SFTP_S_IRGRP | LIBSSH2_SFTP_S_IROTH);
+            if (!handle) {
+                impl.setError("Cannot open remote file: " + remotePath);
+                return false;
+            }
+            bool ok = true;
+            for (const ByteRange& range : ranges) {
+                if (!(ok = impl.uploadSFTPRange(handle, fd, range.start, range.end - range.start, counter))) break;
+            }
+            if (ok) {
+                LIBSSH2_SFTP_ATTRIBUTES attrs;
+                memset(&attrs, 0, sizeof(attrs));
+                attrs.flags = LIBSSH2_SFTP_ATTR_SIZE;
+                attrs.filesize = sourceSize;
+                if (libssh2_sftp_fsetstat(handle, &attrs) != 0) {
+                    impl.setError("Failed to truncate remote file: " + remotePath);
+                    ok = false;
+                }
+            }
+            if (libssh2_sftp_close(handle) != 0 && ok) {
+                impl.setError("Failed to close remote file: " + remotePath);
+                ok = false;
+            }
+            return ok;
+        });
+        {
+            std::lock_guard<std::mutex> lock(errorMutex);
+            integrity.resentBytes = resent;
+        }
+        if (!repaired) return finish(false);
+
+        // Nouveau contrôle des segments renvoyés (taille déjà fixée)
+        size_t still = 0;
+        if (upload) {
+            remoteSize = sourceSize;
+        }
+        if (upload && !differing.empty()) {
+            std::vector<std::string> again;
+            if (!remoteSegmentDigests(remotePath, differing, again, remoteSize)) return finish(false);
+            again.resize(std::max(again.size(), count));
+            for (size_t index : differing) {
+                if (again[index] != local[index]) ++still;
+            }
+        } else if (!upload) {
+            for (size_t index : differing) {
+                uint64_t start = index * SegmentHasher::segmentSize;
+                std::string hex;
+                if (!sha256Range(fd, start, std::min(SegmentHasher::segmentSize, sourceSize - start), hex) ||
+                    hex != remote[index]) {
+                    ++still;
+                }
+            }
+            struct stat info;
+            if (fstat(fd, &info) != 0) {
+                setError("Cannot stat local file: " + localPath);
+                return finish(false);
+            }
+            localSize = info.st_size;
+            remoteSize = sourceSize;
+        }
+        if (still > 0 || (upload ? remoteSize : localSize) != sourceSize) {
+            setError("Integrity check failed after resend (" + std::to_string(still) +
+                     " segment(s) differ): " + remotePath);
+            return finish(false);
+        }
+        std::lock_guard<std::mutex> lock(errorMutex);
+        integrity.verified = true;
+        return finish(true);
+    }
+
+    // Résume les échecs dans lastError
+    bool finishTree(const TreeTransferReport& report) {
+        if (report.failures.empty()) return true;
+        setError(std::to_string(report.failures.size()) + " item(s) failed, first: " +
+                 report.failures.front().path + ": " + report.failures.front().error);
+        return false;
+    }
+};
+
+// Constructeur/Destructeur
+SCPSession::SCPSession() : pImpl(new Impl()) {
+    pImpl->initializeSSH();
+}
+
+SCPSession::~SCPSession() {
+    disconnect();
+}
+
+void SCPSession::setProtocol(ProtocolType protocol) {
+    pImpl->protocol = protocol;
+    pImpl->updatePrefetchTarget();
+}
+
+void SCPSession::setTransferWindow(unsigned requests) {
+    pImpl->transferWindow = std::max(1u, requests);
+}
+
+void SCPSession::setChunkSize(size_t bytes) {
+    // libssh2 découpe de toute façon en paquets de ~30 Ko
+    pImpl->chunkSize = std::max<size_t>(bytes, 4096);
+}
+
+unsigned SCPSession::getTransferWindow() const {
+    return pImpl->transferWindow;
+}
+
+size_t SCPSession::getChunkSize() const {
+    return pImpl->chunkSize;
+}
+
+// Connexion avec password
+bool SCPSession::connect(const std::string& host, int port,
+                        const std::string& username, const std::string& password) {
+    SessionCredentials credentials;
+    credentials.host = host;
+    credentials.port = port;
+    credentials.username = username;
+    credentials.password = password;
+    return connect(credentials);
+}
+
+// Connexion avec clé SSH
+bool SCPSession::connectWithKey(const std::string& host, int port,
+                               const std::string& username, const std::string& privateKeyPath,
+                               const std::string& passphrase) {
+    SessionCredentials credentials;
+    credentials.host = host;
+    credentials.port = port;
+    credentials.username = username;
+    credentials.useKey = true;
+    credentials.privateKeyPath = privateKeyPath;
+    credentials.passphrase = passphrase;
+    return connect(credentials);
+}
+
+bool SCPSession::connect(const SessionCredentials& credentials) {
+    disconnect();
+
+    if (!pImpl->createSocket(credentials.host, credentials.port)) return false;
+    if (!pImpl->startSession()) return false;
+    if (credentials.useKey) {
+        if (!pImpl->authenticateWithKey(credentials.username, credentials.privateKeyPath,
+                                        credentials.passphrase)) return false;
+    } else {
+        if (!pImpl->authenticate(credentials.username, credentials.password)) return false;
+    }
+
+    // Initialiser SFTP seulement si protocol = SFTP
+    if (pImpl->protocol == ProtocolType::SFTP) {
+        if (!pImpl->initSFTP()) return false;
+    }
+
+    // Conservés pour ouvrir des sessions annexes (transferts répartis)
+    pImpl->credentials = credentials;
+    pImpl->credentialsForgotten = false;
+    pImpl->updatePrefetchTarget();
+    pImpl->connected = true;
+    if (pImpl->nonBlocking) {
+        pImpl->startReactor();
+    }
+    return true;
+}
+
+void SCPSession::forgetCredentials() {
+    pImpl->forgetCredentials();
+}
+
+void SCPSession::restoreCredentials(const SessionCredentials& credentials) {
+    if (!pImpl->connected) return;
+    pImpl->credentials = credentials;
+    pImpl->credentialsForgotten = false;
+    pImpl->updatePrefetchTarget();
+}
+
+void SCPSession::disconnect() {
+    pImpl->cleanup();
+}
+
+bool SCPSession::isConnected() const {
+    return pImpl->connected;
+}
+
+void SCPSession::setNonBlocking(bool enabled) {
+    pImpl->nonBlocking = enabled;
+    if (!pImpl->connected) return;
+    if (enabled) {
+        pImpl->startReactor();
+    } else if (!pImpl->currentShell()) {
+        // Sinon arrêté à la fermeture du shell
+        pImpl->stopReactor();
+    }
+}
+
+bool SCPSession::isNonBlocking() const {
+    return pImpl->nonBlocking;
+}
+
+void SCPSession::setResumeTransfers(bool enabled, bool verifyHash) {
+    pImpl->resume = enabled;
+    pImpl->resumeVerify = verifyHash;
+}
+
+bool SCPSession::isResumeEnabled() const {
+    return pImpl->resume;
+}
+
+void SCPSession::setVerifyTransfers(bool enabled, unsigned hashThreads) {
+    pImpl->verifyTransfers = enabled;
+    pImpl->hashThreads = hashThreads;
+}
+
+bool SCPSession::isVerifyEnabled() const {
+    return pImpl->verifyTransfers;
+}
+
+IntegrityReport SCPSession::getLastIntegrityReport() const {
+    std::lock_guard<std::mutex> lock(pImpl->errorMutex);
+    return pImpl->integrity;
+}
+
+void SCPSession::setUncachedDownloads(bool enabled) {
+    pImpl->uncachedDownloads = enabled;
+}
+
+void SCPSession::setTransferPriority(TransferPriority priority) {
+    pImpl->priority = priority;
+}
+
+void SCPSession::setTransferRateLimit(uint64_t bytesPerSecond) {
+    pImpl->rateLimit = bytesPerSecond;
+}
+
+void SCPSession::setDirectoryCache(unsigned ttlSeconds, size_t maxDirectories, size_t maxEntries) {
+    pImpl->cache.configure(std::chrono::seconds(ttlSeconds), maxDirectories, maxEntries);
+}
+
+void SCPSession::setPrefetch(bool enabled, const PrefetchPolicy& policy) {
+    if (!enabled) {
+        pImpl->prefetcher.reset();
+        pImpl->prefetchSession.reset();
+        return;
+    }
+    pImpl->updatePrefetchTarget();
+    if (!pImpl->prefetcher) {
+        Impl* impl = pImpl.get();
+        pImpl->prefetcher = std::make_unique<DirectoryPrefetcher>(
+            [impl](const std::string& path, uint64_t& bytes) {
+                return impl->prefetchListing(path, bytes);
+            });
+    }
+    pImpl->prefetcher->setPolicy(policy);
+}
+
+void SCPSession::invalidateDirectoryCache(const std::string& path) {
+    if (path.empty()) {
+        pImpl->cache.clear();
+    } else {
+        pImpl->cache.invalidateTree(path);
+    }
+}
+
+void SCPSession::setKeepalive(int intervalSeconds) {
+    Impl::BlockingScope blocking(*pImpl);
+    if (pImpl->session) {
+        libssh2_keepalive_config(pImpl->session, 1, intervalSeconds);
+    }
+}
+
+bool SCPSession::sendKeepalive() {
+    if (!pImpl->session || !pImpl->connected) {
+        return false;
+    }
+
+    Impl::BlockingScope blocking(*pImpl);
+    int nextSeconds = 0;
+    if (libssh2_keepalive_send(pImpl->session, &nextSeconds) != 0) {
+        pImpl->setError("Keepalive failed, connection lost");
+        pImpl->cleanup();
+        return false;
+    }
+    return true;
+}
+
+// Liste les fichiers d'un répertoire
+std::vector<RemoteFile> SCPSession::listDirectory(const std::string& path) {
+    DirectoryListing listing;
+    listDirectory(path, listing);
+    return listing.toFiles();
+}
+
+bool SCPSession::listDirectory(const std::string& path, DirectoryListing& listing) {
+    listing.reset(path);
+
+    if (!pImpl->session) {
+        pImpl->setError("Not connected");
+        return false;
+    }
+
+    // Cache : rendu tel quel s'il est récent ; expiré, un stat suffit tant
+    // que la date du répertoire n'a pas changé
+    bool caching = pImpl->cache.enabled();
+    int64_t mtime = -1;
+    if (caching) {
+        int64_t cachedMtime = -1;
+        DirectoryCache::Lookup found = pImpl->cache.lookup(path, listing, cachedMtime);
+        if (found == DirectoryCache::Lookup::Fresh) {
+            pImpl->schedulePrefetch(path, listing);
+            return true;
+        }
+        // En SCP, le stat coûte un exec : pas avant un premier listage, la
+        // date est relevée au premier renouvellement
+        if (found == DirectoryCache::Lookup::Expired || pImpl->sftp) {
+            mtime = pImpl->directoryMtime(path);
+        }
+        if (found == DirectoryCache::Lookup::Expired && mtime >= 0 &&
+            pImpl->cache.revalidate(path, mtime)) {
+            pImpl->schedulePrefetch(path, listing);
+            return true;
+        }
+        listing.reset(path);
+    }
+
+    uint64_t generation = pImpl->cache.generation();
+    bool ok = pImpl->listEntries(path, [&](const RemoteFile& file) {
+        listing.append(file);
+        return true;
+    });
+    if (!ok) return false;
+    if (caching) {
+        pImpl->cache.store(path, listing, mtime, generation);
+    }
+    pImpl->schedulePrefetch(path, listing);
+    return true;
+}
+
+// Recherche : find distant en mode SCP, parcours parallèle filtré en SFTP
+bool SCPSession::find(const std::string& path, const ListingQuery& query,
+                      std::vector<RemoteFile>& matches, unsigned workers) {
+    matches.clear();
+    if (!pImpl->session) {
+        pImpl->setError("Not connected");
+        return false;
+    }
+
+    auto collect = [&](const RemoteFile& file) {
+        matches.push_back(file);
+        return query.maxResults == 0 || matches.size() < query.maxResults;
+    };
+
+    if (pImpl->protocol == ProtocolType::SCP) {
+        bool unsupported = false;
+        if (pImpl->findSCP(path, query, collect, unsupported)) return true;
+        if (!unsupported) return false;
+    }
+    return pImpl->walkFind(path, query, workers, collect);
+}
+
+// Listage en flux, par lots, ou page à partir d'une position
+bool SCPSession::listDirectory(const std::string& path, size_t batchSize,
+                               const ListingBatchCallback& onBatch, ListingCursor* cursor) {
+    if (!pImpl->session) {
+        pImpl->setError("Not connected");
+        return false;
+    }
+
+    batchSize = std::max<size_t>(1, batchSize);
+    if (cursor) return pImpl->listPage(*this, path, batchSize, onBatch, *cursor);
+
+    bool cancelled = false;
+    std::vector<RemoteFile> batch;
+    batch.reserve(batchSize);
+
+    auto visit = [&](const RemoteFile& file) {
+        batch.push_back(file);
+        if (batch.size() >= batchSize) {
+            cancelled = !onBatch(batch);
+            batch.clear();
+        }
+        return !cancelled;
+    };
+
+    // Listage récent en cache : lu sans aller sur le réseau
+    DirectoryListing cached;
+    int64_t cachedMtime = -1;
+    bool ok = true;
+    if (pImpl->cache.enabled() &&
+        pImpl->cache.lookup(path, cached, cachedMtime) == DirectoryCache::Lookup::Fresh) {
+        RemoteFile file;
+        for (size_t i = 0; i < cached.size(); ++i) {
+            cached.entry(i, file);
+            if (!visit(file)) break;
+        }
+    } else {
+        ok = pImpl->listEntries(path, visit);
+    }
+    if (ok && !cancelled && !batch.empty()) {
+        onBatch(batch);
+    }
+    return ok;
+}
+
+std::string SCPSession::getCurrentDirectory() {
+    return pImpl->currentDir;
+}
+
+bool SCPSession::changeDirectory(const std::string& path) {
+    if (!pImpl->sftp) {
+        pImpl->setError("Not connected");
+        return false;
+    }
+
+    // Vérifier que le répertoire existe
+    Impl::BlockingScope blocking(*pImpl);
+    LIBSSH2_SFTP_ATTRIBUTES attrs;
+    int rc = libssh2_sftp_stat(pImpl->sftp, path.c_str(), &attrs);
+    if (rc == 0 && LIBSSH2_SFTP_S_ISDIR(attrs.permissions)) {
+        pImpl->currentDir = path;
+        return true;
+    }
+
+    pImpl->setError("Directory does not exist: " + path);
+    return false;
+}
+
+// Transfert contrôlé en cours sur ce thread : l'appel interne de
+// uploadFile / downloadFile fait le transfert seul
+static thread_local const void* verifyingSession = nullptr;
+
+struct VerifyingScope {
+    const void* previous;
+
+    explicit VerifyingScope(const void* session) : previous(verifyingSession) {
+        verifyingSession = session;
+    }
+    ~VerifyingScope() { verifyingSession = previous; }
+};
+
+// Upload un fichier
+bool SCPSession::uploadFile(const std::string& localPath, const std::string& remotePath,
+                           ProgressCallback callback) {
+    if (!pImpl->session) {
+        pImpl->setError("Not connected");
+        return false;
+    }
+    Impl::CacheInvalidation invalidation(*pImpl, remotePath);
+    Impl::TransferScope throttled(*pImpl);
+    Impl::ProgressScope tracked(*pImpl, callback, remotePath, true);
+
+    if (pImpl->verifyTransfers && verifyingSession != pImpl.get()) {
+        VerifyingScope verifying(pImpl.get());
+        return invalidation.done(pImpl->verifiedTransfer(true, localPath, remotePath, [&]() {
+            return uploadFile(localPath, remotePath, callback);
+        }));
+    }
+
+    if (pImpl->resume) {
+        invalidation.touch();
+        return invalidation.done(pImpl->withSFTP([&](Impl& impl) {
+            return impl.resumeUpload(localPath, remotePath, callback, pImpl->resumeVerify);
+        }));
+    }
+
+    // Ouvrir le fichier local
+    int fd = open(localPath.c_str(), O_RDONLY);
+    if (fd < 0) {
+        pImpl->setError("Cannot open local file: " + localPath);
+        return false;
+    }
+
+    struct stat fileInfo;
+    if (fstat(fd, &fileInfo) != 0) {
+        pImpl->setError("Cannot stat local file: " + localPath);
+        close(fd);
+        return false;
+    }
+    uint64_t totalSize = fileInfo.st_size;
+
+    if (pImpl->protocol == ProtocolType::SCP) {
+        // Mode SCP - utiliser libssh2_scp_send64
+        Impl::BlockingScope blocking(*pImpl);
+        LIBSSH2_CHANNEL* channel = libssh2_scp_send64(pImpl->session, remotePath.c_str(),
+                                                       fileInfo.st_mode & 0777,
+                                                       totalSize, 0, 0);
+        if (!channel) {
+            char* errMsg;
+            libssh2_session_last_error(pImpl->session, &errMsg, nullptr, 0);
+            pImpl->setError("Failed to open SCP channel: " + std::string(errMsg));
+            close(fd);
+            return false;
+        }
+        invalidation.touch();
+
+        // Transfer : tranches larges, prises dans la projection du fichier
+        // quand il est gros ; une écriture partielle reprend dans la même
+        LocalFileReader reader(fd);
+        const size_t sliceSize = pImpl->transferBufferSize();
+        uint64_t transferred = 0;
+
+        while (transferred < totalSize) {
+            const char* data;
+            ssize_t available = reader.slice(transferred, (size_t)std::min<uint64_t>(sliceSize, totalSize - transferred), data);
+            if (available <= 0) {
+                // Fichier raccourci depuis l'annonce de sa taille
+                pImpl->setError("Read error on local file at offset " + std::to_string(transferred));
+                libssh2_channel_free(channel);
+                close(fd);
+                return false;
+            }
+            ssize_t written = libssh2_channel_write(channel, data, available);
+            if (written < 0) {
+                pImpl->setError("Write error during SCP upload");
+                libssh2_channel_free(channel);
+                close(fd);
+                return false;
+            }
+            transferred += written;
+            reader.release(transferred);
+            pImpl->throttleBytes(written);
+            if (callback) {
+                callback(transferred, totalSize);
+            }
+        }
+
+        libssh2_channel_send_eof(channel);
+        libssh2_channel_wait_eof(channel);
         libssh2_channel_wait_closed(channel);
         libssh2_channel_free(channel);
         close(fd);
-        return true;
+        return invalidation.done(true);
+
+    } else {
+        // Mode SFTP
+        if (!pImpl->sftp) {
+            pImpl->setError("SFTP not initialized");
+            close(fd);
+            return false;
+        }
+
+        if (std::shared_ptr<SessionReactor> reactor = pImpl->currentReactor()) {
+            SftpUploadOperation op(pImpl->sftp, remotePath, fd, totalSize,
+                                   pImpl->transferBufferSize(), callback);
+            op.throttle = pImpl->throttle;
+            invalidation.touch();
+            bool ok = pImpl->runOnReactor(reactor, op);
+            close(fd);
+            return invalidation.done(ok);
+        }
+
+        Impl::BlockingScope blocking(*pImpl);
+        // Créer le fichier distant
+        LIBSSH2_SFTP_HANDLE* handle = libssh2_sftp_open(pImpl->sftp, remotePath.c_str(),
+                                                         LIBSSH2_FXF_WRITE | LIBSSH2_FXF_CREAT | LIBSSH2_FXF_TRUNC,
+                                                         LIBSSH2_SFTP_S_IRUSR | LIBSSH2_SFTP_S_IWUSR |
+                                                         LIBSSH2_SFTP_S_IRGRP | LIBSSH2_SFTP_S_IROTH);
+        if (!handle) {
+            pImpl->setError("Cannot create remote file: " + remotePath);
+            close(fd);
+            return false;
+        }
+        invalidation.touch();
+
+        uint64_t transferred = 0;
+        bool ok = pImpl->uploadSFTPRange(handle, fd, 0, UINT64_MAX, [&](uint64_t bytes) {
+            transferred += bytes;
+            if (callback) {
+                callback(transferred, totalSize);
+            }
+            return true;
+        });
+
+        // La fermeture confirme les dernières écritures
+        if (libssh2_sftp_close(handle) != 0 && ok) {
+            pImpl->setError("Failed to close remote file: " + remotePath);
+            ok = false;
+        }
+        close(fd);
+        return invalidation.done(ok);
+    }
+}
+
+// Download un fichier
+bool SCPSession::downloadFile(const std::string& remotePath, const std::string& localPath,
+                             ProgressCallback callback) {
+    if (!pImpl->session) {
+        pImpl->setError("Not connected");
+        return false;
+    }
+    Impl::TransferScope throttled(*pImpl);
+    Impl::ProgressScope tracked(*pImpl, callback, remotePath, false);
+
+    if (pImpl->verifyTransfers && verifyingSession != pImpl.get()) {
+        VerifyingScope verifying(pImpl.get());
+        return pImpl->verifiedTransfer(false, localPath, remotePath, [&]() {
+            return downloadFile(remotePath, localPath, callback);
+        });
+    }
+
+    if (pImpl->resume) {
+        return pImpl->withSFTP([&](Impl& impl) {
+            return impl.resumeDownload(remotePath, localPath, callback, pImpl->resumeVerify);
+        });
+    }
+
+    if (pImpl->protocol == ProtocolType::SCP) {
+        // Mode SCP - utiliser libssh2_scp_recv2
+        Impl::BlockingScope blocking(*pImpl);
+        struct stat fileInfo;
+        LIBSSH2_CHANNEL* channel = libssh2_scp_recv2(pImpl->session, remotePath.c_str(), &fileInfo);
+        if (!channel) {
+            char* errMsg;
+            libssh2_session_last_error(pImpl->session, &errMsg, nullptr, 0);
+            pImpl->setError("Failed to open SCP channel for download: " + std::string(errMsg));
+            return false;
+        }
+
+        uint64_t totalSize = fileInfo.st_size;
+
+        // Créer le fichier local
+        int fd = open(localPath.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+        if (fd < 0) {
+            pImpl->setError("Cannot create local file: " + localPath);
+            libssh2_channel_free(channel);
+            return false;
+        }
+        LocalFileWriter::prepare(fd, totalSize, pImpl->uncachedDownloads);
+
+        // Transfer : écritures regroupées par LocalFileWriter
+        BufferPool::Buffer buffer = BufferPool::shared().acquire(pImpl->transferBufferSize());
+        LocalFileWriter writer(fd);
+        uint64_t transferred = 0;
+        ssize_t nread;
+
+        while (transferred < totalSize) {
+            size_t amount = buffer.size();
+            if ((totalSize - transferred) < amount) {
+                amount = totalSize - transferred;
+            }
+
+            nread = libssh2_channel_read(channel, buffer.data(), amount);
+            if (nread < 0) {
+                pImpl->setError("Read error during SCP download");
+                libssh2_channel_free(channel);
+                close(fd);
+                return false;
+            }
+            if (nread == 0) break;
+
+            if (!writer.write(transferred, buffer.data(), nread)) {
+                pImpl->setError("Write error during download");
+                libssh2_channel_free(channel);
+                close(fd);
+                return false;
+            }
+            transferred += nread;
+            pImpl->throttleBytes(nread);
+            if (callback) {
+                callback(transferred, totalSize);
+            }
+        }
+
+        libssh2_channel_free(channel);
+        bool written = writer.finish();
+        if (!written) {
+            pImpl->setError("Write error during download");
+        }
+        close(fd);
+        return written;
 
     } else {
         // Mode SFTP
         if (!pImpl->sftp) {
-            pImpl->lastError = "SFTP not initialized";
+            pImpl->setError("SFTP not initialized");
+            return false;
+        }
+
+        if (std::shared_ptr<SessionReactor> reactor = pImpl->currentReactor()) {
+            int fd = open(localPath.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+            if (fd < 0) {
+                pImpl->setError("Cannot create local file: " + localPath);
+                return false;
+            }
+            SftpDownloadOperation op(pImpl->sftp, remotePath, fd,
+                                     pImpl->transferBufferSize(), callback);
+            op.throttle = pImpl->throttle;
+            op.uncached = pImpl->uncachedDownloads;
+            bool ok = pImpl->runOnReactor(reactor, op);
             close(fd);
+            return ok;
+        }
+
+        Impl::BlockingScope blocking(*pImpl);
+        // Obtenir la taille (inconnue : lecture jusqu'à EOF)
+        LIBSSH2_SFTP_ATTRIBUTES attrs;
+        if (libssh2_sftp_stat(pImpl->sftp, remotePath.c_str(), &attrs) != 0) {
+            pImpl->setError("Cannot open remote file: " + remotePath);
+            return false;
+        }
+        bool sizeKnown = attrs.flags & LIBSSH2_SFTP_ATTR_SIZE;
+        uint64_t totalSize = sizeKnown ? attrs.filesize : 0;
+
+        // Créer le fichier local
+        int fd = open(localPath.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+        if (fd < 0) {
+            pImpl->setError("Cannot create local file: " + localPath);
             return false;
         }
+        LocalFileWriter::prepare(fd, totalSize, pImpl->uncachedDownloads);
+
+        uint64_t transferred = 0;
+        bool ok = pImpl->downloadSFTPRange(remotePath, fd, 0, sizeKnown ? totalSize : UINT64_MAX,
+                                           [&](uint64_t bytes) {
+            transferred += bytes;
+            if (callback) {
+                callback(transferred, totalSize);
+            }
+            return true;
+        });
+        close(fd);
+        return ok;
+    }
+}
+
+// Upload réparti sur plusieurs sessions SFTP
+bool SCPSession::uploadFileStriped(const std::string& localPath, const std::string& remotePath,
+                                   unsigned streams, ProgressCallback callback) {
+    if (!pImpl->session) {
+        pImpl->setError("Not connected");
+        return false;
+    }
+    Impl::CacheInvalidation invalidation(*pImpl, remotePath);
+    Impl::TransferScope throttled(*pImpl);
+    Impl::ProgressScope tracked(*pImpl, callback, remotePath, true);
+
+    int fd = open(localPath.c_str(), O_RDONLY);
+    if (fd < 0) {
+        pImpl->setError("Cannot open local file: " + localPath);
+        return false;
+    }
+
+    struct stat fileInfo;
+    if (fstat(fd, &fileInfo) != 0) {
+        pImpl->setError("Cannot stat local file: " + localPath);
+        close(fd);
+        return false;
+    }
+    uint64_t totalSize = fileInfo.st_size;
+
+    // La première bande crée (ou tronque) le fichier distant ; les autres
+    // l'ouvrent en écriture sans troncature
+    std::string error;
+    SessionPool::Lease first = pImpl->acquireStripe(error);
+    if (!first) {
+        pImpl->setError("Stripe connection failed: " + error);
+        close(fd);
+        return false;
+    }
+    LIBSSH2_SFTP_HANDLE* handle = libssh2_sftp_open(first->pImpl->sftp, remotePath.c_str(),
+                                                     LIBSSH2_FXF_WRITE | LIBSSH2_FXF_CREAT | LIBSSH2_FXF_TRUNC,
+                                                     LIBSSH2_SFTP_S_IRUSR | LIBSSH2_SFTP_S_IWUSR |
+                                                     LIBSSH2_SFTP_S_IRGRP | LIBSSH2_SFTP_S_IROTH);
+    if (!handle) {
+        pImpl->setError("Cannot create remote file: " + remotePath);
+        close(fd);
+        return false;
+    }
+    libssh2_sftp_close(handle);
+    invalidation.touch();
 
-        // Créer le fichier distant
-        LIBSSH2_SFTP_HANDLE* handle = libssh2_sftp_open(pImpl->sftp, remotePath.c_str(),
-                                                         LIBSSH2_FXF_WRITE | LIBSSH2_FXF_CREAT | LIBSSH2_FXF_TRUNC,
-                                                         LIBSSH2_SFTP_S_IRUSR | LIBSSH2_SFTP_S_IWUSR |
-                                                         LIBSSH2_SFTP_S_IRGRP | LIBSSH2_SFTP_S_IROTH);
-        if (!handle) {
-            pImpl->lastError = "Cannot create remote file: " + remotePath;
-            close(fd);
+    bool ok = pImpl->runStripes(std::move(first), Impl::stripeCount(streams, totalSize),
+                                totalSize, callback,
+                                [&](SCPSession& stripe, uint64_t start, uint64_t end,
+                                    const Impl::ByteCounter& onBytes) {
+        Impl& impl = *stripe.pImpl;
+        LIBSSH2_SFTP_HANDLE* part = libssh2_sftp_open(impl.sftp, remotePath.c_str(),
+                                                       LIBSSH2_FXF_WRITE, 0);
+        if (!part) {
+            impl.setError("Cannot open remote file: " + remotePath);
             return false;
         }
+        bool partOk = impl.uploadSFTPRange(part, fd, start, end - start, onBytes);
+        if (libssh2_sftp_close(part) != 0 && partOk) {
+            impl.setError("Failed to close remote file: " + remotePath);
+            partOk = false;
+        }
+        return partOk;
+    });
 
-        // Transfer
-        char buffer[8192];
-        uint64_t transferred = 0;
-        ssize_t nread;
+    close(fd);
+    return invalidation.done(ok);
+}
 
-        while ((nread = read(fd, buffer, sizeof(buffer))) > 0) {
-            ssize_t written = libssh2_sftp_write(handle, buffer, nread);
-            if (written < 0) {
-                pImpl->lastError = "Write error during upload";
-                libssh2_sftp_close(handle);
-                close(fd);
-                return false;
-            }
-            transferred += written;
-            if (callback) {
-                callback(transferred, totalSize);
-            }
-        }
+// Download réparti sur plusieurs sessions SFTP
+bool SCPSession::downloadFileStriped(const std::string& remotePath, const std::string& localPath,
+                                     unsigned streams, ProgressCallback callback) {
+    if (!pImpl->session) {
+        pImpl->setError("Not connected");
+        return false;
+    }
+    Impl::TransferScope throttled(*pImpl);
+    Impl::ProgressScope tracked(*pImpl, callback, remotePath, false);
 
-        libssh2_sftp_close(handle);
+    // La première bande sert aussi à obtenir la taille
+    std::string error;
+    SessionPool::Lease first = pImpl->acquireStripe(error);
+    if (!first) {
+        pImpl->setError("Stripe connection failed: " + error);
+        return false;
+    }
+    LIBSSH2_SFTP_ATTRIBUTES attrs;
+    if (libssh2_sftp_stat(first->pImpl->sftp, remotePath.c_str(), &attrs) != 0 ||
+        !(attrs.flags & LIBSSH2_SFTP_ATTR_SIZE)) {
+        pImpl->setError("Cannot stat remote file: " + remotePath);
+        return false;
+    }
+    uint64_t totalSize = attrs.filesize;
+
+    // Fichier local préalloué : chaque bande écrit directement à ses offsets
+    int fd = open(localPath.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    if (fd < 0) {
+        pImpl->setError("Cannot create local file: " + localPath);
+        return false;
+    }
+    if (ftruncate(fd, (off_t)totalSize) != 0) {
+        pImpl->setError("Cannot allocate local file: " + localPath);
         close(fd);
-        return true;
+        return false;
     }
+    LocalFileWriter::prepare(fd, totalSize, pImpl->uncachedDownloads);
+
+    bool ok = pImpl->runStripes(std::move(first), Impl::stripeCount(streams, totalSize),
+                                totalSize, callback,
+                                [&](SCPSession& stripe, uint64_t start, uint64_t end,
+                                    const Impl::ByteCounter& onBytes) {
+        return stripe.pImpl->downloadSFTPRange(remotePath, fd, start, end, onBytes);
+    });
+
+    close(fd);
+    return ok;
 }
 
-// Download un fichier
-bool SCPSession::downloadFile(const std::string& remotePath, const std::string& localPath,
-                             ProgressCallback callback) {
+// Upload groupé : une archive tar produite à la volée vers `tar -x` distant
+bool SCPSession::uploadBundle(const std::string& localDir, const std::string& remoteDir,
+                              const std::vector<std::string>& paths, ProgressCallback callback) {
     if (!pImpl->session) {
-        pImpl->lastError = "Not connected";
+        pImpl->setError("Not connected");
         return false;
     }
+    Impl::CacheInvalidation invalidation(*pImpl, remoteDir, true);
+    Impl::TransferScope throttled(*pImpl);
+    Impl::ProgressScope tracked(*pImpl, callback, remoteDir, true);
 
-    if (pImpl->protocol == ProtocolType::SCP) {
-        // Mode SCP - utiliser libssh2_scp_recv2
-        struct stat fileInfo;
-        LIBSSH2_CHANNEL* channel = libssh2_scp_recv2(pImpl->session, remotePath.c_str(), &fileInfo);
-        if (!channel) {
-            char* errMsg;
-            libssh2_session_last_error(pImpl->session, &errMsg, nullptr, 0);
-            pImpl->lastError = "Failed to open SCP channel for download: " + std::string(errMsg);
-            return false;
+    // Entrées de l'archive : répertoires avant leur contenu
+    std::vector<std::string> entries;
+    uint64_t totalSize = 0;
+    TreeTransferReport walk;
+    std::vector<std::string> roots = paths.empty() ? std::vector<std::string>{""} : paths;
+    for (const std::string& root : roots) {
+        struct stat info;
+        if (stat(joinPath(localDir, root).c_str(), &info) == 0 && !S_ISDIR(info.st_mode)) {
+            entries.push_back(root);
+            totalSize += info.st_size;
+            continue;
+        }
+        std::vector<std::string> dirs;
+        std::vector<Impl::TreeFile> files;
+        Impl::walkLocalTree(joinPath(localDir, root), dirs, files, walk);
+        for (const std::string& dir : dirs) {
+            if (!joinPath(root, dir).empty()) entries.push_back(joinPath(root, dir));
         }
+        for (const Impl::TreeFile& file : files) {
+            entries.push_back(joinPath(root, file.path));
+            totalSize += file.size;
+        }
+    }
+    if (!walk.failures.empty()) {
+        pImpl->setError("Cannot open local directory: " + walk.failures.front().path);
+        return false;
+    }
 
-        uint64_t totalSize = fileInfo.st_size;
+    const size_t blockTarget = 256 * 1024;
+    size_t next = 0;
+    int fd = -1;
+    uint64_t left = 0;
+    uint64_t padding = 0;
+    uint64_t transferred = 0;
+    bool trailerSent = false;
 
-        // Créer le fichier local
-        int fd = open(localPath.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
-        if (fd < 0) {
-            pImpl->lastError = "Cannot create local file: " + localPath;
-            libssh2_channel_free(channel);
-            return false;
-        }
+    auto produce = [&](std::string& out, bool& eof) {
+        while (out.size() < blockTarget) {
+            if (fd >= 0) {
+                size_t want = (size_t)std::min<uint64_t>(left, blockTarget - out.size());
+                size_t start = out.size();
+                out.resize(start + want);
+                ssize_t nread = read(fd, &out[start], want);
+                if (nread < 0) {
+                    if (errno == EINTR) {
+                        out.resize(start);
+                        continue;
+                    }
+                    pImpl->setError("Read error on local file: " + joinPath(localDir, entries[next - 1]));
+                    return false;
+                }
+                // Fichier raccourci depuis le parcours : complété par des zéros
+                if (nread == 0) nread = want;
+                out.resize(start + nread);
+                left -= nread;
+                transferred += nread;
+                if (left == 0) {
+                    out.append(padding, '\0');
+                    close(fd);
+                    fd = -1;
+                }
+                if (callback) {
+                    callback(transferred, totalSize);
+                }
+            } else if (next < entries.size()) {
+                const std::string& name = entries[next++];
+                std::string path = joinPath(localDir, name);
+                struct stat info;
+                if (stat(path.c_str(), &info) != 0) {
+                    pImpl->setError("Cannot open local file: " + path);
+                    return false;
+                }
 
-        // Transfer
-        char buffer[8192];
-        uint64_t transferred = 0;
-        ssize_t nread;
+                TarEntry entry;
+                entry.name = name;
+                entry.mode = info.st_mode & 07777;
+                entry.mtime = info.st_mtime;
+                if (S_ISDIR(info.st_mode)) {
+                    entry.type = '5';
+                    out += TarWriter::header(entry);
+                    continue;
+                }
 
-        while (transferred < totalSize) {
-            size_t amount = sizeof(buffer);
-            if ((totalSize - transferred) < amount) {
-                amount = totalSize - transferred;
+                fd = open(path.c_str(), O_RDONLY);
+                if (fd < 0) {
+                    pImpl->setError("Cannot open local file: " + path);
+                    return false;
+                }
+                entry.size = info.st_size;
+                out += TarWriter::header(entry);
+                left = entry.size;
+                padding = TarWriter::padding(entry.size);
+                if (left == 0) {
+                    close(fd);
+                    fd = -1;
+                }
+            } else if (!trailerSent) {
+                out += TarWriter::trailer();
+                trailerSent = true;
+            } else {
+                eof = true;
+                break;
             }
+        }
+        return true;
+    };
 
-            nread = libssh2_channel_read(channel, buffer, amount);
-            if (nread < 0) {
-                pImpl->lastError = "Read error during SCP download";
-                libssh2_channel_free(channel);
-                close(fd);
-                return false;
-            }
-            if (nread == 0) break;
+    std::string command = "mkdir -p " + shellQuote(remoteDir) + " && tar -x -f - -C " + shellQuote(remoteDir);
+    invalidation.touch();
+    int exitStatus = -1;
+    std::string errorOutput;
+    bool ok = pImpl->streamCommand(command, produce, [](const char*, size_t) { return true; },
+                                   exitStatus, errorOutput);
+    if (fd >= 0) close(fd);
+    if (!ok) return false;
 
-            ssize_t written = write(fd, buffer, nread);
-            if (written < 0) {
-                pImpl->lastError = "Write error during download";
-                libssh2_channel_free(channel);
-                close(fd);
+    if (exitStatus != 0) {
+        pImpl->setError("Remote tar failed (exit code " + std::to_string(exitStatus) + ")" +
+                        (errorOutput.empty() ? "" : ": " + errorOutput.substr(0, errorOutput.find('\n'))));
+        return false;
+    }
+    return invalidation.done(true);
+}
+
+// Download groupé : `tar -c` distant lu et extrait à la volée
+bool SCPSession::downloadBundle(const std::string& remoteDir, const std::string& localDir,
+                                const std::vector<std::string>& paths, ProgressCallback callback) {
+    if (!pImpl->session) {
+        pImpl->setError("Not connected");
+        return false;
+    }
+    Impl::TransferScope throttled(*pImpl);
+    Impl::ProgressScope tracked(*pImpl, callback, remoteDir, false);
+    if (!makeLocalDirectories(localDir)) {
+        pImpl->setError("Cannot create local directory: " + localDir);
+        return false;
+    }
+
+    int fd = -1;
+    TarEntry current;
+    uint64_t fileOffset = 0;
+    uint64_t transferred = 0;
+    std::string skipped;
+    // Estimée avant l'archive : un fichier grossi depuis ne la dépasse pas
+    uint64_t totalSize = pImpl->remoteTreeSize(remoteDir, paths);
+
+    TarReader reader([&](const TarEntry& entry) {
+        current = entry;
+        if (entry.name.empty()) return true;   // "." : la destination elle-même
+        if (!isSafeRelativePath(entry.name)) {
+            if (skipped.empty()) skipped = entry.name;
+            return true;
+        }
+
+        std::string path = joinPath(localDir, entry.name);
+        if (entry.type == '5') {
+            if (!makeLocalDirectories(path)) {
+                pImpl->setError("Cannot create local directory: " + path);
                 return false;
             }
-            transferred += written;
-            if (callback) {
-                callback(transferred, totalSize);
-            }
+            return true;
+        }
+        if (entry.type != '0' && entry.type != '7') {
+            return true;   // liens et fichiers spéciaux ignorés
         }
 
-        libssh2_channel_free(channel);
+        size_t slash = path.rfind('/');
+        if (slash != std::string::npos && slash > 0 && !makeLocalDirectories(path.substr(0, slash))) {
+            pImpl->setError("Cannot create local directory: " + path.substr(0, slash));
+            return false;
+        }
+        fd = open(path.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+        if (fd < 0) {
+            pImpl->setError("Cannot create local file: " + path);
+            return false;
+        }
+        fileOffset = 0;
+        return true;
+    }, [&](const char* data, size_t length) {
+        if (fd < 0) return true;
+        if (!Impl::pwriteAll(fd, data, length, fileOffset)) {
+            pImpl->setError("Write error during download");
+            return false;
+        }
+        fileOffset += length;
+        transferred += length;
+        if (callback) {
+            callback(transferred, std::max(totalSize, transferred));
+        }
+        return true;
+    }, [&]() {
+        if (fd < 0) return true;
+        struct timespec times[2];
+        times[0].tv_sec = times[1].tv_sec = current.mtime;
+        times[0].tv_nsec = times[1].tv_nsec = 0;
+        futimens(fd, times);
+        fchmod(fd, current.mode & 0777);
         close(fd);
+        fd = -1;
         return true;
+    });
 
+    // Liste des chemins sur stdin, séparés par NUL (aucune limite de ligne de commande)
+    std::string command = "tar -c -f - -C " + shellQuote(remoteDir);
+    Impl::StreamProducer produce = nullptr;
+    bool listSent = false;
+    if (paths.empty()) {
+        command += " .";
     } else {
-        // Mode SFTP
-        if (!pImpl->sftp) {
-            pImpl->lastError = "SFTP not initialized";
-            return false;
-        }
+        command += " --null -T -";
+        produce = [&](std::string& out, bool& eof) {
+            if (!listSent) {
+                for (const std::string& path : paths) {
+                    out += path;
+                    out += '\0';
+                }
+                listSent = true;
+            }
+            eof = true;
+            return true;
+        };
+    }
 
-        // Ouvrir le fichier distant
-        LIBSSH2_SFTP_HANDLE* handle = libssh2_sftp_open(pImpl->sftp, remotePath.c_str(),
-                                                         LIBSSH2_FXF_READ, 0);
-        if (!handle) {
-            pImpl->lastError = "Cannot open remote file: " + remotePath;
-            return false;
+    int exitStatus = -1;
+    std::string errorOutput;
+    bool ok = pImpl->streamCommand(command, produce, [&](const char* data, size_t length) {
+        if (reader.feed(data, length)) return true;
+        // Arrêt demandé par un callback : lastError est déjà posé
+        if (reader.error != "Transfer cancelled") {
+            pImpl->setError(reader.error);
         }
+        return false;
+    }, exitStatus, errorOutput);
+    if (fd >= 0) close(fd);
+    if (!ok) return false;
 
-        // Obtenir la taille
-        LIBSSH2_SFTP_ATTRIBUTES attrs;
-        libssh2_sftp_fstat(handle, &attrs);
-        uint64_t totalSize = attrs.filesize;
+    if (exitStatus != 0) {
+        pImpl->setError("Remote tar failed (exit code " + std::to_string(exitStatus) + ")" +
+                        (errorOutput.empty() ? "" : ": " + errorOutput.substr(0, errorOutput.find('\n'))));
+        return false;
+    }
+    if (!reader.finished()) {
+        pImpl->setError("Truncated tar stream");
+        return false;
+    }
+    if (!skipped.empty()) {
+        pImpl->setError("Unsafe path skipped: " + skipped);
+        return false;
+    }
+    return true;
+}
 
-        // Créer le fichier local
-        int fd = open(localPath.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
-        if (fd < 0) {
-            pImpl->lastError = "Cannot create local file: " + localPath;
-            libssh2_sftp_close(handle);
-            return false;
-        }
+// Upload différentiel : seuls les blocs absents du fichier distant sont envoyés
+bool SCPSession::uploadFileDelta(const std::string& localPath, const std::string& remotePath,
+                                 ProgressCallback callback, DeltaSyncStats* stats) {
+    DeltaSyncStats result;
+    if (stats) *stats = result;
+    if (!pImpl->session) {
+        pImpl->setError("Not connected");
+        return false;
+    }
+    Impl::CacheInvalidation invalidation(*pImpl, remotePath);
+    Impl::TransferScope throttled(*pImpl);
+    Impl::ProgressScope tracked(*pImpl, callback, remotePath, true);
 
-        // Transfer
-        char buffer[8192];
-        uint64_t transferred = 0;
-        ssize_t nread;
+    int fd = open(localPath.c_str(), O_RDONLY);
+    if (fd < 0) {
+        pImpl->setError("Cannot open local file: " + localPath);
+        return false;
+    }
+    struct stat fileInfo;
+    if (fstat(fd, &fileInfo) != 0) {
+        pImpl->setError("Cannot stat local file: " + localPath);
+        close(fd);
+        return false;
+    }
+    uint64_t size = fileInfo.st_size;
+    size_t blockSize = deltaBlockSize(size);
 
-        while ((nread = libssh2_sftp_read(handle, buffer, sizeof(buffer))) > 0) {
-            ssize_t written = write(fd, buffer, nread);
-            if (written < 0) {
-                pImpl->lastError = "Write error during download";
-                libssh2_sftp_close(handle);
-                close(fd);
+    // 1. Signatures des blocs distants, calculées par l'assistant python3
+    SignatureParser signatures;
+    int exitStatus = -1;
+    std::string errorOutput;
+    std::string command = "python3 -c " + shellQuote(deltaSignatureScript) + " " +
+                          shellQuote(remotePath) + " " + std::to_string(blockSize);
+    bool helper = pImpl->streamCommand(command, nullptr, [&](const char* data, size_t length) {
+        return signatures.feed(data, length);
+    }, exitStatus, errorOutput) && exitStatus == 0 && signatures.complete(blockSize);
+
+    // Fichier absent : envoi complet
+    if (helper && !signatures.exists) {
+        close(fd);
+        result.literalBytes = size;
+        if (stats) *stats = result;
+        return invalidation.done(uploadFile(localPath, remotePath, callback));
+    }
+
+    bool ok;
+    bool missing = false;
+    invalidation.touch();
+    if (helper) {
+        // 2. Instructions copie/données appliquées par l'assistant distant,
+        //    qui reconstruit le fichier à côté puis le renomme
+        result.usedHelper = true;
+        DeltaEncoder encoder(fd, size, blockSize, signatures.blocks, signatures.remoteSize);
+        command = "python3 -c " + shellQuote(deltaPatchScript) + " " + shellQuote(remotePath);
+        errorOutput.clear();
+        ok = pImpl->streamCommand(command, [&](std::string& out, bool& eof) {
+            if (!encoder.produce(out, 256 * 1024, eof)) {
+                pImpl->setError(encoder.error);
                 return false;
             }
-            transferred += written;
             if (callback) {
-                callback(transferred, totalSize);
+                callback(encoder.processed(), size);
             }
+            return true;
+        }, [](const char*, size_t) { return true; }, exitStatus, errorOutput);
+
+        if (ok && exitStatus != 0) {
+            pImpl->setError("Remote delta helper failed" +
+                            (errorOutput.empty() ? "" : ": " + errorOutput.substr(0, errorOutput.find('\n'))));
+            ok = false;
         }
+        result.literalBytes = encoder.literalBytes;
+        result.matchedBytes = encoder.matchedBytes;
+    } else if (pImpl->sftp) {
+        ok = pImpl->patchSFTPInPlace(fd, size, remotePath, blockSize, callback, result, missing);
+    } else {
+        // Mode SCP sans python3 distant : session SFTP empruntée au pool
+        std::string error;
+        SessionPool::Lease lease = pImpl->acquireStripe(error);
+        if (!lease) {
+            pImpl->setError("Delta sync needs python3 or SFTP on the server: " + error);
+            ok = false;
+        } else {
+            ok = lease->pImpl->patchSFTPInPlace(fd, size, remotePath, blockSize, callback, result, missing);
+            if (!ok) pImpl->setError(lease->getLastError());
+        }
+    }
 
-        libssh2_sftp_close(handle);
-        close(fd);
-        return true;
+    // 3. Fichier reconstruit contrôlé en entier : un bloc faussement apparié
+    //    ou un fichier modifié pendant l'envoi se répare par un envoi complet.
+    //    Un octet de plus est haché côté distant pour voir un fichier trop long.
+    //    Une empreinte impossible à calculer ne prouve rien : envoi complet.
+    if (ok && !missing) {
+        std::string local, remote;
+        result.verified = sha256Range(fd, 0, size, local) &&
+                          pImpl->remoteDigest(remotePath, 0, size + 1, remote) &&
+                          local == remote;
+        result.resent = !result.verified;
     }
+    close(fd);
+    if (missing || result.resent) {
+        result.literalBytes = size;
+        result.matchedBytes = 0;
+        ok = uploadFile(localPath, remotePath, callback);
+        result.verified = false;
+    }
+    if (stats) *stats = result;
+    return invalidation.done(ok);
 }
 
 // Helper pour exécuter une commande SSH
@@ -600,8 +3804,8 @@ bool executeSSHCommand(LIBSSH2_SESSION* session, const std::string& command, std
     }
 
     // Attendre la fin de l'exécution
-    char buffer[1024];
-    while (libssh2_channel_read(channel, buffer, sizeof(buffer)) > 0) {
+    BufferPool::Buffer buffer = BufferPool::shared().acquire(BufferPool::packetSize);
+    while (libssh2_channel_read(channel, buffer.data(), buffer.size()) > 0) {
         // Consommer la sortie
     }
 
@@ -617,137 +3821,361 @@ bool executeSSHCommand(LIBSSH2_SESSION* session, const std::string& command, std
     return true;
 }
 
+// Upload d'une arborescence locale
+bool SCPSession::uploadTree(const std::string& localDir, const std::string& remoteDir,
+                            unsigned workers, ProgressCallback callback,
+                            TreeTransferReport* report) {
+    TreeTransferReport result;
+    if (!pImpl->session) {
+        pImpl->setError("Not connected");
+        if (report) *report = result;
+        return false;
+    }
+    Impl::CacheInvalidation invalidation(*pImpl, remoteDir, true);
+    Impl::ProgressScope tracked(*pImpl, callback, remoteDir, true);
+
+    std::vector<std::string> dirs;
+    std::vector<Impl::TreeFile> files;
+    Impl::walkLocalTree(localDir, dirs, files, result);
+
+    invalidation.touch();
+    pImpl->createRemoteDirectories(remoteDir, dirs, workers, result);
+    pImpl->transferFiles(localDir, files, workers, callback, result,
+                         [&](SCPSession& worker, const Impl::TreeFile& file, ProgressCallback progress) {
+        return worker.uploadFile(joinPath(localDir, file.path), joinPath(remoteDir, file.path), progress);
+    });
+
+    bool ok = pImpl->finishTree(result);
+    if (report) *report = std::move(result);
+    return ok;
+}
+
+// Download d'une arborescence distante
+bool SCPSession::downloadTree(const std::string& remoteDir, const std::string& localDir,
+                              unsigned workers, ProgressCallback callback,
+                              TreeTransferReport* report) {
+    TreeTransferReport result;
+    if (!pImpl->session) {
+        pImpl->setError("Not connected");
+        if (report) *report = result;
+        return false;
+    }
+    Impl::ProgressScope tracked(*pImpl, callback, remoteDir, false);
+
+    // Parcours distant niveau par niveau, les répertoires d'un niveau étant
+    // listés en parallèle ; les répertoires locaux sont créés au passage
+    std::vector<std::string> level{""};
+    std::vector<Impl::TreeFile> files;
+    std::mutex mutex;
+
+    while (!level.empty()) {
+        std::vector<std::string> listed;
+        for (const std::string& relative : level) {
+            std::string path = joinPath(localDir, relative);
+            if (mkdir(path.c_str(), 0755) != 0 && errno != EEXIST) {
+                result.failures.push_back({path, "Cannot create local directory: " +
+                                                 std::string(strerror(errno))});
+                continue;
+            }
+            ++result.directories;
+            listed.push_back(relative);
+        }
+
+        std::vector<std::string> next;
+        pImpl->runWorkers(workers, listed.size(), [&](SCPSession& worker, size_t index) {
+            DirectoryListing entries;
+            if (!worker.listDirectory(joinPath(remoteDir, listed[index]), entries)) return false;
+
+            std::lock_guard<std::mutex> lock(mutex);
+            for (size_t i = 0; i < entries.size(); ++i) {
+                // Nom renvoyé par le serveur : un seul composant, jamais ".."
+                // ni "." (hors de localDir, ou parcours sans fin)
+                std::string name(entries.name(i));
+                if (!isSafeRelativePath(name) || name == "." || name.find('/') != std::string::npos) {
+                    result.failures.push_back({joinPath(joinPath(remoteDir, listed[index]), name),
+                                               "Unsafe entry name from server"});
+                    continue;
+                }
+                std::string child = joinPath(listed[index], name);
+                if (entries.isDirectory(i)) {
+                    next.push_back(child);
+                } else {
+                    files.push_back({child, entries.fileSize(i)});
+                }
+            }
+            return true;
+        }, [&](size_t index, const std::string& error) {
+            result.failures.push_back({joinPath(remoteDir, listed[index]), error});
+        });
+        level.swap(next);
+    }
+
+    pImpl->transferFiles(remoteDir, files, workers, callback, result,
+                         [&](SCPSession& worker, const Impl::TreeFile& file, ProgressCallback progress) {
+        // Noms déjà filtrés au listage ; vérifié encore avant toute écriture
+        if (!isSafeRelativePath(file.path)) {
+            worker.pImpl->setError("Unsafe entry name from server: " + file.path);
+            return false;
+        }
+        return worker.downloadFile(joinPath(remoteDir, file.path), joinPath(localDir, file.path), progress);
+    });
+
+    bool ok = pImpl->finishTree(result);
+    if (report) *report = std::move(result);
+    return ok;
+}
+
 bool SCPSession::deleteFile(const std::string& remotePath) {
     if (!pImpl->session) {
-        pImpl->lastError = "Not connected";
+        pImpl->setError("Not connected");
         return false;
     }
+    Impl::CacheInvalidation invalidation(*pImpl, remotePath);
 
     if (pImpl->protocol == ProtocolType::SCP) {
         // Mode SCP - utiliser commande SSH rm
         std::string command = "rm -f \"" + remotePath + "\"";
-        return executeSSHCommand(pImpl->session, command, pImpl->lastError);
+        return invalidation.done(pImpl->runCommand(command));
     } else {
         // Mode SFTP
         if (!pImpl->sftp) {
-            pImpl->lastError = "SFTP not initialized";
+            pImpl->setError("SFTP not initialized");
             return false;
         }
 
+        Impl::BlockingScope blocking(*pImpl);
         int rc = libssh2_sftp_unlink(pImpl->sftp, remotePath.c_str());
         if (rc != 0) {
-            pImpl->lastError = "Failed to delete file: " + remotePath;
+            pImpl->setError("Failed to delete file: " + remotePath);
             return false;
         }
-        return true;
+        return invalidation.done(true);
     }
 }
 
 bool SCPSession::createDirectory(const std::string& remotePath) {
     if (!pImpl->session) {
-        pImpl->lastError = "Not connected";
+        pImpl->setError("Not connected");
         return false;
     }
+    Impl::CacheInvalidation invalidation(*pImpl, remotePath);
 
     if (pImpl->protocol == ProtocolType::SCP) {
         // Mode SCP - utiliser commande SSH mkdir
         std::string command = "mkdir -p \"" + remotePath + "\"";
-        return executeSSHCommand(pImpl->session, command, pImpl->lastError);
+        // Parents créés même si le dernier niveau échoue
+        invalidation.touch();
+        return invalidation.done(pImpl->runCommand(command));
     } else {
         // Mode SFTP
         if (!pImpl->sftp) {
-            pImpl->lastError = "SFTP not initialized";
+            pImpl->setError("SFTP not initialized");
             return false;
         }
 
+        Impl::BlockingScope blocking(*pImpl);
         int rc = libssh2_sftp_mkdir(pImpl->sftp, remotePath.c_str(),
                                     LIBSSH2_SFTP_S_IRWXU | LIBSSH2_SFTP_S_IRGRP |
                                     LIBSSH2_SFTP_S_IXGRP | LIBSSH2_SFTP_S_IROTH | LIBSSH2_SFTP_S_IXOTH);
         if (rc != 0) {
-            pImpl->lastError = "Failed to create directory: " + remotePath;
+            pImpl->setError("Failed to create directory: " + remotePath);
             return false;
         }
-        return true;
+        return invalidation.done(true);
     }
 }
 
 bool SCPSession::deleteDirectory(const std::string& remotePath) {
     if (!pImpl->session) {
-        pImpl->lastError = "Not connected";
+        pImpl->setError("Not connected");
         return false;
     }
+    Impl::CacheInvalidation invalidation(*pImpl, remotePath, true);
 
     if (pImpl->protocol == ProtocolType::SCP) {
         // Mode SCP - utiliser commande SSH rmdir
         std::string command = "rmdir \"" + remotePath + "\"";
-        return executeSSHCommand(pImpl->session, command, pImpl->lastError);
+        return invalidation.done(pImpl->runCommand(command));
     } else {
         // Mode SFTP
         if (!pImpl->sftp) {
-            pImpl->lastError = "SFTP not initialized";
+            pImpl->setError("SFTP not initialized");
             return false;
         }
 
+        Impl::BlockingScope blocking(*pImpl);
         int rc = libssh2_sftp_rmdir(pImpl->sftp, remotePath.c_str());
         if (rc != 0) {
-            pImpl->lastError = "Failed to delete directory: " + remotePath;
+            pImpl->setError("Failed to delete directory: " + remotePath);
             return false;
         }
-        return true;
+        return invalidation.done(true);
     }
 }
 
-// Exécuter une commande SSH et retourner la sortie
-std::string SCPSession::executeCommand(const std::string& command) {
+bool SCPSession::deleteFiles(const std::vector<std::string>& remotePaths,
+                             std::vector<PathResult>* results) {
+    return pImpl->runBatch(Impl::BatchOperation::Unlink, remotePaths, results);
+}
+
+bool SCPSession::createDirectories(const std::vector<std::string>& remotePaths,
+                                   std::vector<PathResult>* results) {
+    return pImpl->runBatch(Impl::BatchOperation::Mkdir, remotePaths, results);
+}
+
+bool SCPSession::deleteDirectories(const std::vector<std::string>& remotePaths,
+                                   std::vector<PathResult>* results) {
+    return pImpl->runBatch(Impl::BatchOperation::Rmdir, remotePaths, results);
+}
+
+bool SCPSession::removeTree(const std::string& remotePath) {
     if (!pImpl->session) {
-        pImpl->lastError = "Not connected";
-        return "";
+        pImpl->setError("Not connected");
+        return false;
+    }
+    if (remotePath.empty()) {
+        pImpl->setError("Failed to delete directory: empty path");
+        return false;
     }
+    Impl::CacheInvalidation invalidation(*pImpl, remotePath, true);
+    // Arborescence en partie supprimée même en cas d'échec
+    invalidation.touch();
 
-    LIBSSH2_CHANNEL* channel = libssh2_channel_open_session(pImpl->session);
-    if (!channel) {
-        char* errMsg;
-        libssh2_session_last_error(pImpl->session, &errMsg, nullptr, 0);
-        pImpl->lastError = "Failed to open SSH channel: " + std::string(errMsg);
-        return "";
+    if (pImpl->protocol == ProtocolType::SCP) {
+        return invalidation.done(pImpl->runServerCommand("rm -rf -- " + shellQuote(remotePath),
+                                                         "Failed to delete directory: " + remotePath));
+    }
+    if (!pImpl->sftp) {
+        pImpl->setError("SFTP not initialized");
+        return false;
     }
+    return invalidation.done(pImpl->removeSFTPTree(remotePath));
+}
 
-    int rc = libssh2_channel_exec(channel, command.c_str());
-    if (rc != 0) {
-        pImpl->lastError = "Failed to execute command: " + command;
-        libssh2_channel_free(channel);
-        return "";
+bool SCPSession::copyRemote(const std::string& sourcePath, const std::string& destinationPath) {
+    if (!pImpl->session) {
+        pImpl->setError("Not connected");
+        return false;
+    }
+    Impl::CacheInvalidation invalidation(*pImpl, destinationPath, true);
+    invalidation.touch();
+
+    return invalidation.done(pImpl->runServerCommand("cp -a -- " + shellQuote(sourcePath) + " " +
+                                                     shellQuote(destinationPath),
+                                                     "Failed to copy: " + sourcePath));
+}
+
+bool SCPSession::moveRemote(const std::string& sourcePath, const std::string& destinationPath) {
+    if (!pImpl->session) {
+        pImpl->setError("Not connected");
+        return false;
+    }
+    // mv entre deux systèmes de fichiers : copie puis suppression, qui peut
+    // s'arrêter en route
+    Impl::CacheInvalidation source(*pImpl, sourcePath, true);
+    Impl::CacheInvalidation destination(*pImpl, destinationPath, true);
+    source.touch();
+    destination.touch();
+
+    bool ok;
+    if (pImpl->protocol == ProtocolType::SCP) {
+        ok = pImpl->runServerCommand("mv -f -- " + shellQuote(sourcePath) + " " +
+                                     shellQuote(destinationPath),
+                                     "Failed to move: " + sourcePath);
+    } else if (!pImpl->sftp) {
+        pImpl->setError("SFTP not initialized");
+        return false;
+    } else {
+        ok = pImpl->moveSFTP(sourcePath, destinationPath);
     }
+    return source.done(destination.done(ok));
+}
 
-    // Lire la sortie (stdout et stderr)
+// Exécuter une commande SSH et retourner la sortie
+std::string SCPSession::executeCommand(const std::string& command) {
     std::string output;
-    char buffer[1024];
-    ssize_t nread;
+    int exitStatus = -1;
+    bool ok = executeCommand(command, [&output](const char* data, size_t length, bool) {
+        output.append(data, length);
+        return true;
+    }, &exitStatus);
+    if (!ok) return "";
 
-    // Lire stdout
-    while ((nread = libssh2_channel_read(channel, buffer, sizeof(buffer))) > 0) {
-        output.append(buffer, nread);
+    if (exitStatus != 0 && output.empty()) {
+        output = "Command failed with exit code " + std::to_string(exitStatus);
     }
+    return output;
+}
 
-    // Lire stderr
-    while ((nread = libssh2_channel_read_stderr(channel, buffer, sizeof(buffer))) > 0) {
-        output.append(buffer, nread);
+bool SCPSession::executeCommand(const std::string& command, const CommandOutputCallback& onOutput,
+                                int* exitStatus, const CommandOptions& options) {
+    if (exitStatus) *exitStatus = -1;
+    if (!pImpl->session) {
+        pImpl->setError("Not connected");
+        return false;
     }
 
-    // Obtenir le code de retour
-    int exitcode = libssh2_channel_get_exit_status(channel);
+    CommandOptions bounded = options;
+    bounded.maxBuffered = std::max<size_t>(options.maxBuffered, 1);
 
-    libssh2_channel_close(channel);
-    libssh2_channel_free(channel);
+    int status = -1;
+    bool ok;
+    if (std::shared_ptr<SessionReactor> reactor = pImpl->currentReactor()) {
+        ok = pImpl->executeOnReactor(reactor, command, onOutput, bounded, status);
+    } else {
+        // La session partagée ne change jamais de mode (des transferts peuvent
+        // l'utiliser) : commande sur une session du pool, sinon échec
+        std::string error;
+        SessionPool::Lease lease = pImpl->acquireLease(ProtocolType::SCP, error, false);
+        if (!lease) {
+            pImpl->setError("No session available for the command: " + error);
+            return false;
+        }
+        ok = lease->pImpl->executeStreaming(command, onOutput, bounded, status);
+        if (!ok) pImpl->setError(lease->getLastError());
+    }
+    if (!ok) return false;
 
-    if (exitcode != 0 && output.empty()) {
-        output = "Command failed with exit code " + std::to_string(exitcode);
+    if (exitStatus) *exitStatus = status;
+    return true;
+}
+
+bool SCPSession::openShell(const ShellOptions& options, ShellOutputCallback onOutput,
+                           ShellClosedCallback onClosed) {
+    return pImpl->openShell(options, std::move(onOutput), std::move(onClosed));
+}
+
+bool SCPSession::writeShell(const std::string& input) {
+    std::shared_ptr<ShellOperation> shell = pImpl->currentShell();
+    if (!shell || !shell->isOpen()) {
+        pImpl->setError("Shell not open");
+        return false;
+    }
+    shell->write(input.data(), input.size());
+    return true;
+}
+
+bool SCPSession::resizeShell(unsigned columns, unsigned rows) {
+    std::shared_ptr<ShellOperation> shell = pImpl->currentShell();
+    if (!shell || !shell->isOpen()) {
+        pImpl->setError("Shell not open");
+        return false;
     }
+    shell->resize(columns, rows);
+    return true;
+}
 
-    return output;
+void SCPSession::closeShell() {
+    pImpl->closeShell();
+}
+
+bool SCPSession::isShellOpen() const {
+    std::shared_ptr<ShellOperation> shell = pImpl->currentShell();
+    return shell && shell->isOpen();
 }
 
 std::string SCPSession::getLastError() const {
+    std::lock_guard<std::mutex> lock(pImpl->errorMutex);
     return pImpl->lastError;
 }
 
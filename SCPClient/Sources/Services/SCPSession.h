@@ -12,6 +12,7 @@
 #include <vector>
 #include <functional>
 #include <memory>
+#include <atomic>
 
 namespace SCPClient {
 
@@ -31,9 +32,125 @@ struct RemoteFile {
     int64_t modificationTime;
 };
 
-// Callback pour la progression des transferts
+// Classe de priorité d'un transfert, pour le partage de débit
+enum class TransferPriority {
+    Interactive,
+    Normal,
+    Bulk
+};
+
+// Identifiants d'une connexion, conservés pour ouvrir des sessions annexes
+struct SessionCredentials {
+    std::string host;
+    int port = 22;
+    std::string username;
+    bool useKey = false;
+    std::string password;
+    std::string privateKeyPath;
+    std::string passphrase;
+};
+
+// Position dans un listage paginé
+struct ListingCursor {
+    uint64_t position = 0;    // index de la première entrée à rendre
+    uint64_t limit = 0;       // nombre maximal d'entrées, 0 : toutes
+    bool complete = false;    // fin du répertoire atteinte
+};
+
+// Préchargement des sous-répertoires
+struct PrefetchPolicy {
+    unsigned maxChildren = 4;                          // par répertoire listé
+    unsigned maxRequestsPerMinute = 60;
+    uint64_t maxBytesPerMinute = 4ull * 1024 * 1024;   // taille estimée des réponses
+};
+
+// Lot d'entrées d'un listage en flux ; retourner false pour arrêter
+using ListingBatchCallback = std::function<bool(const std::vector<RemoteFile>& batch)>;
+
+// Recherche côté serveur ; les critères se cumulent
+struct ListingQuery {
+    std::string namePattern;   // motif glob sur le nom (find -name), vide : tous
+    uint64_t minSize = 0;      // octets
+    int64_t newerThan = 0;     // modifiés strictement après (epoch), 0 : tous
+    bool recursive = false;
+    size_t maxResults = 0;     // arrêt dès ce nombre atteint, 0 : illimité
+};
+
+// Callback pour la progression des transferts, appelé à cadence limitée
+// (ProgressTracker::setPublishRate) ; la fin est toujours signalée
 using ProgressCallback = std::function<void(uint64_t transferred, uint64_t total)>;
 
+// Sortie d'une commande en flux : morceaux de stdout et de stderr dans leur
+// ordre d'arrivée ; retourner false interrompt la commande
+using CommandOutputCallback = std::function<bool(const char* data, size_t length, bool isStderr)>;
+
+struct CommandOptions {
+    // Plus gros morceau passé au callback (et seule mémoire tenue pour la
+    // sortie) ; un morceau part dès que le canal n'a plus rien à lire
+    size_t maxBuffered = 64 * 1024;
+    // Interruption depuis un autre thread, vue en 100 ms au plus : la
+    // commande reçoit SIGTERM et le canal est fermé
+    const std::atomic<bool>* cancel = nullptr;
+};
+
+// Shell interactif : pseudo-terminal demandé à l'ouverture
+struct ShellOptions {
+    std::string term = "xterm-256color";
+    unsigned columns = 80;
+    unsigned rows = 24;
+    bool echo = true;   // écho de l'entrée par le pseudo-terminal distant
+};
+using ShellOutputCallback = std::function<void(const char* data, size_t length)>;
+using ShellClosedCallback = std::function<void(int exitStatus)>;
+
+// Résultat d'un chemin dans une opération par lot
+struct PathResult {
+    std::string path;
+    bool ok = false;
+    std::string error;
+};
+
+// Échec d'un élément lors d'un transfert d'arborescence
+struct TransferFailure {
+    std::string path;
+    std::string error;
+};
+
+// Bilan d'une synchronisation différentielle
+struct DeltaSyncStats {
+    uint64_t literalBytes = 0;   // données envoyées
+    uint64_t matchedBytes = 0;   // blocs repris du fichier distant
+    bool usedHelper = false;     // assistant python3 distant (sinon SFTP sur place)
+    bool verified = false;       // SHA-256 complet identique des deux côtés
+    bool resent = false;         // empreintes différentes ou incalculables : renvoi complet
+};
+
+// Plage d'octets [start, end)
+struct ByteRange {
+    uint64_t start = 0;
+    uint64_t end = 0;
+};
+
+// Bilan du contrôle d'intégrité d'un transfert
+struct IntegrityReport {
+    bool checked = false;               // empreintes comparées
+    uint64_t segmentSize = 0;
+    std::vector<ByteRange> mismatched;  // plages différentes au premier contrôle
+    uint64_t resentBytes = 0;
+    bool verified = false;              // identiques, après renvoi éventuel
+};
+
+// Bilan d'un transfert d'arborescence
+struct TreeTransferReport {
+    uint64_t files = 0;         // fichiers transférés
+    uint64_t directories = 0;   // répertoires créés (ou déjà présents)
+    uint64_t bytes = 0;
+    std::vector<TransferFailure> failures;
+};
+
+// Listage compact (DirectoryListing.h)
+class DirectoryListing;
+
 // Session SSH/SCP
 class SCPSession {
 public:
@@ -43,31 +160,206 @@ public:
     // Configuration
     void setProtocol(ProtocolType protocol);
 
+    // Pipeline SFTP : nombre de requêtes READ en vol et taille de chaque bloc.
+    // Leur produit donne aussi le tampon des transferts SCP et des flux exec
+    // (pris au BufferPool partagé) : 256 Ko x 32 pour un lien 10 GbE.
+    void setTransferWindow(unsigned requests);
+    void setChunkSize(size_t bytes);
+    unsigned getTransferWindow() const;
+    size_t getChunkSize() const;
+
     // Connexion
     bool connect(const std::string& host, int port,
                  const std::string& username, const std::string& password);
     bool connectWithKey(const std::string& host, int port,
                        const std::string& username, const std::string& privateKeyPath,
                        const std::string& passphrase = "");
+    bool connect(const SessionCredentials& credentials);
+    // Efface le mot de passe et la phrase de passe gardés pour les sessions
+    // annexes (sessions de travail du pool) : la session n'en ouvre plus
+    void forgetCredentials();
+    // Session connectée avec ces identifiants (même clé de pool) : les
+    // garde à nouveau pour ses sessions annexes
+    void restoreCredentials(const SessionCredentials& credentials);
     void disconnect();
     bool isConnected() const;
 
+    // Mode non bloquant : un réacteur pilote la session, et les listages,
+    // commandes et transferts SFTP lancés depuis plusieurs threads avancent en
+    // parallèle sur la même connexion. Les callbacks de progression sont alors
+    // appelés depuis le thread du réacteur et ne doivent pas rappeler la session.
+    void setNonBlocking(bool enabled);
+    bool isNonBlocking() const;
+
+    // Reprise : uploadFile et downloadFile tiennent à côté de la destination
+    // un journal "<destination>.scpresume" des plages écrites. Relancés après
+    // une coupure, ils ne transfèrent que ce qui manque si la source n'a pas
+    // changé (taille et date) ; avec verifyHash, les plages déjà présentes
+    // sont en plus comparées par SHA-256 des deux côtés. Le journal n'est
+    // gardé qu'après une connexion perdue : tout autre échec le supprime. En
+    // mode SCP, ces transferts passent par une session SFTP du pool.
+    void setResumeTransfers(bool enabled, bool verifyHash = false);
+    bool isResumeEnabled() const;
+
+    // Contrôle d'intégrité : après uploadFile ou downloadFile, source et
+    // destination sont comparées par segments de 8 Mo. Côté local, SHA-256
+    // calculé sur `hashThreads` threads (0 : un par cœur), dès le début d'un
+    // upload ; côté distant, sha256sum par exec, sur autant de processus.
+    // Seuls les segments différents sont renvoyés (par SFTP, via une session
+    // du pool en mode SCP) puis contrôlés de nouveau : s'ils diffèrent
+    // encore, le transfert échoue. Bilan du dernier contrôle dans
+    // getLastIntegrityReport().
+    void setVerifyTransfers(bool enabled, unsigned hashThreads = 0);
+    bool isVerifyEnabled() const;
+    IntegrityReport getLastIntegrityReport() const;
+
+    // Fichier local des téléchargements : espace réservé d'un bloc d'après
+    // la taille annoncée, écritures regroupées et blocs nuls laissés en trous
+    // (une image disque creuse le reste). Activé, un fichier de plus de 1 Go
+    // est en plus écrit hors du cache de pages (O_DIRECT / F_NOCACHE).
+    void setUncachedDownloads(bool enabled);
+
+    // Débit des transferts de cette session : priorité dans le partage des
+    // limites globale et par hôte (TransferScheduler), et limite propre à
+    // chaque transfert en octets par seconde (0 : aucune)
+    void setTransferPriority(TransferPriority priority);
+    void setTransferRateLimit(uint64_t bytesPerSecond);
+
+    // Cache des listages (désactivé par défaut) : un répertoire listé il y a
+    // moins de `ttlSeconds` est rendu sans requête ; au-delà, en SFTP, un stat
+    // suffit tant que sa date n'a pas changé. Les uploads, suppressions et
+    // créations faits par cette session invalident les répertoires touchés.
+    void setDirectoryCache(unsigned ttlSeconds, size_t maxDirectories = 256,
+                           size_t maxEntries = 200000);
+    // Vide le cache pour `path` et ses sous-répertoires (tout si vide)
+    void invalidateDirectoryCache(const std::string& path = "");
+
+    // Préchargement (cache requis) : après listDirectory, les premiers
+    // sous-répertoires, les plus visités puis les plus récents, sont listés
+    // en arrière-plan sur une session libre du pool et mis en cache
+    void setPrefetch(bool enabled, const PrefetchPolicy& policy = PrefetchPolicy());
+
+    // Keepalive SSH (sessions inactives du pool)
+    void setKeepalive(int intervalSeconds);
+    bool sendKeepalive();
+
     // Navigation
     std::vector<RemoteFile> listDirectory(const std::string& path);
+    // Même listage sous forme compacte, pour les grands répertoires
+    bool listDirectory(const std::string& path, DirectoryListing& listing);
+    // Listage en flux : lots de `batchSize` entrées rendus pendant la lecture
+    // du répertoire, sans le garder en mémoire. En mode non bloquant, le
+    // callback est appelé depuis le thread du réacteur.
+    // Avec un curseur, seules les entrées [position, position + limit) sont
+    // rendues et position avance d'autant. La page à la position 0 lit le
+    // répertoire en entier ; la session en garde un instantané compact où
+    // la page suivante reprend sans relire le serveur, jusqu'à la dernière
+    // page ou une modification faite par la session.
+    bool listDirectory(const std::string& path, size_t batchSize,
+                       const ListingBatchCallback& onBatch, ListingCursor* cursor = nullptr);
     bool changeDirectory(const std::string& path);
     std::string getCurrentDirectory();
 
+    // Entrées de `path` (et de ses sous-répertoires si recursive) répondant
+    // à `query`. SCP : requête traduite en `find` distant, seules les
+    // entrées retenues transitent. SFTP : parcours réparti sur `workers`
+    // sessions, filtré au fil de la lecture. Ordre non défini.
+    bool find(const std::string& path, const ListingQuery& query,
+              std::vector<RemoteFile>& matches, unsigned workers = 4);
+
     // Opérations fichiers
     bool uploadFile(const std::string& localPath, const std::string& remotePath,
                    ProgressCallback callback = nullptr);
     bool downloadFile(const std::string& remotePath, const std::string& localPath,
                      ProgressCallback callback = nullptr);
+
+    // Upload différentiel type rsync : un assistant python3 distant fournit
+    // les signatures des blocs et reconstruit le fichier à partir des blocs
+    // existants et des seules données modifiées. Sans assistant, le fichier
+    // distant est relu en SFTP et les blocs différents réécrits sur place.
+    // Le résultat est contrôlé par SHA-256 du fichier entier des deux côtés
+    // (sha256sum ou shasum distant) ; s'il diffère ou ne peut être calculé,
+    // le fichier est renvoyé en entier.
+    bool uploadFileDelta(const std::string& localPath, const std::string& remotePath,
+                         ProgressCallback callback = nullptr, DeltaSyncStats* stats = nullptr);
+
+    // Transferts répartis : `streams` sessions SFTP vers le même hôte,
+    // chacune déplaçant une plage disjointe du fichier
+    bool uploadFileStriped(const std::string& localPath, const std::string& remotePath,
+                           unsigned streams, ProgressCallback callback = nullptr);
+    bool downloadFileStriped(const std::string& remotePath, const std::string& localPath,
+                             unsigned streams, ProgressCallback callback = nullptr);
+
+    // Arborescences : répertoires créés par lots, fichiers répartis sur
+    // `workers` sessions du pool. Un fichier en échec n'arrête pas les autres ;
+    // retourne false si au moins un élément a échoué (détail dans report).
+    bool uploadTree(const std::string& localDir, const std::string& remoteDir,
+                    unsigned workers = 4, ProgressCallback callback = nullptr,
+                    TreeTransferReport* report = nullptr);
+    bool downloadTree(const std::string& remoteDir, const std::string& localDir,
+                      unsigned workers = 4, ProgressCallback callback = nullptr,
+                      TreeTransferReport* report = nullptr);
+
+    // Lots de petits fichiers : une seule archive tar sur un canal exec
+    // (`tar -x` / `tar -c` distant), construite ou extraite à la volée sans
+    // fichier temporaire. `paths` est relatif au répertoire source (fichiers
+    // ou répertoires) ; vide, tout le répertoire est transféré.
+    bool uploadBundle(const std::string& localDir, const std::string& remoteDir,
+                      const std::vector<std::string>& paths = {},
+                      ProgressCallback callback = nullptr);
+    bool downloadBundle(const std::string& remoteDir, const std::string& localDir,
+                        const std::vector<std::string>& paths = {},
+                        ProgressCallback callback = nullptr);
+
     bool deleteFile(const std::string& remotePath);
     bool createDirectory(const std::string& remotePath);
     bool deleteDirectory(const std::string& remotePath);
 
+    // Lots : en SCP, un seul canal dont le shell lit sur stdin une commande
+    // par chemin ; en SFTP, requêtes en pipeline sur plusieurs canaux SFTP
+    // de la session. L'ordre des chemins est respecté entre un répertoire et
+    // ce qu'il contient (parents avant enfants pour mkdir, l'inverse pour
+    // rmdir). `results` reçoit un résultat par chemin, dans l'ordre ; false
+    // si l'un d'eux a échoué (lastError : le premier échec).
+    bool deleteFiles(const std::vector<std::string>& remotePaths,
+                     std::vector<PathResult>* results = nullptr);
+    bool createDirectories(const std::vector<std::string>& remotePaths,
+                           std::vector<PathResult>* results = nullptr);
+    bool deleteDirectories(const std::vector<std::string>& remotePaths,
+                           std::vector<PathResult>* results = nullptr);
+
+    // Opérations entièrement côté serveur, aucune donnée de fichier ne
+    // transite. SCP : rm -rf, cp -a, mv. SFTP : parcours réparti puis
+    // suppressions en pipeline (fichiers, puis répertoires des plus profonds
+    // aux moins profonds) ; rename, avec repli sur mv entre deux systèmes de
+    // fichiers. SFTP n'a pas de copie : cp -a par exec dans les deux modes.
+    bool removeTree(const std::string& remotePath);
+    bool copyRemote(const std::string& sourcePath, const std::string& destinationPath);
+    bool moveRemote(const std::string& sourcePath, const std::string& destinationPath);
+
     // Terminal / Commandes SSH
     std::string executeCommand(const std::string& command);
+    // En flux : false en erreur ou si la commande est interrompue (lastError),
+    // sinon son code de retour dans exitStatus. Sans réacteur, la commande
+    // passe par une session annexe du pool : false si aucune n'est libre.
+    bool executeCommand(const std::string& command, const CommandOutputCallback& onOutput,
+                        int* exitStatus = nullptr, const CommandOptions& options = {});
+
+    // Shell persistant sur un pseudo-terminal : un seul canal pour toute la
+    // session de terminal, qui garde répertoire courant et variables. Il est
+    // ouvert sur une session annexe du pool (les transferts de celle-ci ne le
+    // suspendent pas), ou sur celle-ci en mode non bloquant. Un réacteur pilote
+    // sa session tant qu'il est ouvert ; la sortie et la fin du shell sont
+    // signalées depuis son thread, et ces callbacks ne doivent appeler que
+    // writeShell et resizeShell. openShell et closeShell bloquent le temps
+    // d'un aller-retour réseau : à appeler hors du fil principal.
+    bool openShell(const ShellOptions& options, ShellOutputCallback onOutput,
+                   ShellClosedCallback onClosed = nullptr);
+    // Entrée et taille de fenêtre : mises en file, envoyées sans attendre
+    bool writeShell(const std::string& input);
+    bool resizeShell(unsigned columns, unsigned rows);
+    void closeShell();
+    bool isShellOpen() const;
 
     // Informations
     std::string getLastError() const;
@@ -18,13 +18,75 @@ NS_ASSUME_NONNULL_BEGIN
 @property (nonatomic, strong) NSDate *modificationDate;
 @end
 
+// Transfert en cours, lu par +activeTransfers
+@interface SCPTransferInfo : NSObject
+@property (nonatomic, assign) uint64_t transferID;
+@property (nonatomic, copy) NSString *host;
+@property (nonatomic, copy) NSString *path;
+@property (nonatomic, assign) BOOL isUpload;
+@property (nonatomic, assign) uint64_t transferred;
+@property (nonatomic, assign) uint64_t total;              // 0 : inconnu
+@property (nonatomic, assign) double bytesPerSecond;       // débit lissé
+@property (nonatomic, assign) NSTimeInterval timeRemaining; // -1 : inconnu
+@property (nonatomic, assign) NSTimeInterval elapsed;
+@end
+
+// Appelé à cadence limitée (voir +setProgressInterval:minimumBytes:)
 typedef void(^ProgressBlock)(uint64_t transferred, uint64_t total);
+typedef BOOL(^ListingBatchBlock)(NSArray<RemoteFileInfo *> *batch);
+typedef void(^ShellOutputBlock)(NSString *text);
+typedef void(^ShellClosedBlock)(int exitStatus);
+
+// Priorité des transferts dans le partage du débit
+typedef NS_ENUM(NSInteger, SCPTransferPriority) {
+    SCPTransferPriorityInteractive,
+    SCPTransferPriorityNormal,
+    SCPTransferPriorityBulk
+};
 
 @interface SCPSessionBridge : NSObject
 
 // Configuration
 - (void)setProtocolSCP:(BOOL)useSCP;
 
+// Limites de débit en octets par seconde (0 : illimité), partagées par
+// toutes les sessions
++ (void)setGlobalBandwidthLimit:(uint64_t)bytesPerSecond;
++ (void)setBandwidthLimit:(uint64_t)bytesPerSecond forHost:(NSString *)host;
+
+// Progression : au plus un appel des blocs par intervalle, et seulement
+// après `bytes` octets de plus (0,1 s et 64 Ko par défaut) ; la fin d'un
+// transfert est toujours signalée
++ (void)setProgressInterval:(NSTimeInterval)interval minimumBytes:(uint64_t)bytes;
+// Instantané de tous les transferts en cours, toutes sessions confondues,
+// à interroger depuis l'interface plutôt que de suivre chaque bloc
++ (NSArray<SCPTransferInfo *> *)activeTransfers;
+
+// Transferts de cette session : priorité et limite par transfert
+- (void)setTransferPriority:(SCPTransferPriority)priority;
+- (void)setTransferRateLimit:(uint64_t)bytesPerSecond;
+
+// Taille des blocs et requêtes en vol (64 Ko x 8 par défaut)
+- (void)setChunkSize:(NSUInteger)bytes transferWindow:(NSUInteger)requests;
+
+// Téléchargements de plus de 1 Go écrits hors du cache de pages
+- (void)setUncachedDownloads:(BOOL)enabled;
+
+// Contrôle d'intégrité des uploads et downloads : SHA-256 par segments de
+// 8 Mo des deux côtés, seuls les segments différents sont renvoyés
+- (void)setVerifyTransfers:(BOOL)enabled;
+// Plages [location, location + length) différentes au dernier contrôle,
+// renvoyées depuis
+- (NSArray<NSValue *> *)lastMismatchedRanges;
+
+// Cache des listages (30 s par défaut, 0 pour le désactiver)
+- (void)setDirectoryCacheTTL:(NSTimeInterval)seconds;
+// Oublie le listage en cache de `path` et de ses sous-répertoires
+- (void)refreshDirectoryAtPath:(NSString *)path;
+// Préchargement des sous-répertoires probables après chaque listage, sur une
+// connexion à part (cache requis)
+- (void)setPrefetchDirectories:(BOOL)enabled;
+
 // Connexion
 - (BOOL)connectToHost:(NSString *)host
                  port:(NSInteger)port
@@ -45,6 +107,30 @@ typedef void(^ProgressBlock)(uint64_t transferred, uint64_t total);
 // Navigation
 - (nullable NSArray<RemoteFileInfo *> *)listDirectoryAtPath:(NSString *)path
                                                        error:(NSError **)error;
+
+// Listage en flux : lots de `batchSize` entrées passés au bloc (sur le thread
+// de lecture) pendant la lecture ; le bloc retourne NO pour arrêter
+- (BOOL)listDirectoryAtPath:(NSString *)path
+                  batchSize:(NSUInteger)batchSize
+                    handler:(ListingBatchBlock)handler
+                      error:(NSError **)error;
+
+// Page `page` de `pageSize` entrées, sans garder le répertoire entier ;
+// hasMore passe à NO en fin de répertoire
+- (nullable NSArray<RemoteFileInfo *> *)listDirectoryAtPath:(NSString *)path
+                                                        page:(NSUInteger)page
+                                                    pageSize:(NSUInteger)pageSize
+                                                     hasMore:(nullable BOOL *)hasMore
+                                                       error:(NSError **)error;
+
+// Recherche côté serveur : seules les entrées retenues sont rendues.
+// pattern : motif glob sur le nom (nil : tous) ; modifiedAfter nil : toutes
+- (nullable NSArray<RemoteFileInfo *> *)findAtPath:(NSString *)path
+                                           matching:(nullable NSString *)pattern
+                                            minSize:(uint64_t)minSize
+                                      modifiedAfter:(nullable NSDate *)modifiedAfter
+                                          recursive:(BOOL)recursive
+                                              error:(NSError **)error;
 - (BOOL)changeDirectoryToPath:(NSString *)path error:(NSError **)error;
 - (NSString *)getCurrentDirectory;
 
@@ -59,14 +145,55 @@ typedef void(^ProgressBlock)(uint64_t transferred, uint64_t total);
                 progress:(nullable ProgressBlock)progress
                    error:(NSError **)error;
 
+// Arborescences : fichiers répartis sur `workers` sessions parallèles
+- (BOOL)uploadDirectoryFrom:(NSString *)localPath
+                         to:(NSString *)remotePath
+                    workers:(NSInteger)workers
+                   progress:(nullable ProgressBlock)progress
+                      error:(NSError **)error;
+
+- (BOOL)downloadDirectoryFrom:(NSString *)remotePath
+                           to:(NSString *)localPath
+                      workers:(NSInteger)workers
+                     progress:(nullable ProgressBlock)progress
+                        error:(NSError **)error;
+
 - (BOOL)deleteFileAtPath:(NSString *)remotePath error:(NSError **)error;
 - (BOOL)createDirectoryAtPath:(NSString *)remotePath error:(NSError **)error;
 - (BOOL)deleteDirectoryAtPath:(NSString *)remotePath error:(NSError **)error;
 
+// Lots (un seul canal en SCP, requêtes en pipeline en SFTP) : chemins en
+// échec associés à leur message d'erreur, vide si tout a réussi
+- (NSDictionary<NSString *, NSString *> *)deleteFilesAtPaths:(NSArray<NSString *> *)paths;
+- (NSDictionary<NSString *, NSString *> *)createDirectoriesAtPaths:(NSArray<NSString *> *)paths;
+- (NSDictionary<NSString *, NSString *> *)deleteDirectoriesAtPaths:(NSArray<NSString *> *)paths;
+
+// Côté serveur, sans transfert : dossier et tout son contenu, copie, déplacement
+- (BOOL)removeTreeAtPath:(NSString *)remotePath error:(NSError **)error;
+- (BOOL)copyItemAtPath:(NSString *)sourcePath toPath:(NSString *)destinationPath error:(NSError **)error;
+- (BOOL)moveItemAtPath:(NSString *)sourcePath toPath:(NSString *)destinationPath error:(NSError **)error;
+
 // Terminal
 - (NSString *)executeCommand:(NSString *)command error:(NSError **)error NS_SWIFT_NAME(executeCommand(_:));
 - (NSString *)executeCommandSimple:(NSString *)command NS_SWIFT_NAME(executeCommandSimple(_:));
 
+// Shell persistant sur un pseudo-terminal : un seul canal pour tout le
+// terminal, répertoire courant et variables conservés. Sortie et fin
+// passées aux blocs depuis le thread de la session (qui ne doivent appeler
+// que writeToShell: et resizeShellToColumns:rows:).
+- (BOOL)openShellWithTerminal:(NSString *)term
+                      columns:(NSUInteger)columns
+                         rows:(NSUInteger)rows
+                         echo:(BOOL)echo
+                       output:(ShellOutputBlock)output
+                       closed:(nullable ShellClosedBlock)closed
+                        error:(NSError **)error;
+// Entrée envoyée sans attendre ; NO si le shell n'est pas ouvert
+- (BOOL)writeToShell:(NSString *)input NS_SWIFT_NAME(writeShell(_:));
+- (void)resizeShellToColumns:(NSUInteger)columns rows:(NSUInteger)rows NS_SWIFT_NAME(resizeShell(columns:rows:));
+- (void)closeShell;
+- (BOOL)isShellOpen;
+
 @end
 
 NS_ASSUME_NONNULL_END
@@ -7,6 +7,10 @@
 
 #import "SCPSessionBridge.h"
 #include "SCPSession.h"
+#include "DirectoryListing.h"
+#include "SessionPool.h"
+#include "TransferScheduler.h"
+#include "ProgressTracker.h"
 #include <memory>
 
 static NSString *const SCPErrorDomain = @"com.scpclient.error";
@@ -14,8 +18,110 @@ static NSString *const SCPErrorDomain = @"com.scpclient.error";
 @implementation RemoteFileInfo
 @end
 
+@implementation SCPTransferInfo
+@end
+
+static RemoteFileInfo *makeFileInfo(const SCPClient::RemoteFile& file) {
+    RemoteFileInfo *info = [[RemoteFileInfo alloc] init];
+    info.name = [NSString stringWithUTF8String:file.name.c_str()];
+    info.path = [NSString stringWithUTF8String:file.path.c_str()];
+    info.size = file.size;
+    info.permissions = file.permissions;
+    info.isDirectory = file.isDirectory;
+    info.modificationDate = [NSDate dateWithTimeIntervalSince1970:file.modificationTime];
+    return info;
+}
+
+static NSArray<RemoteFileInfo *> *makeFileInfos(const std::vector<SCPClient::RemoteFile>& files) {
+    NSMutableArray<RemoteFileInfo *> *result = [NSMutableArray arrayWithCapacity:files.size()];
+    for (const auto& file : files) {
+        [result addObject:makeFileInfo(file)];
+    }
+    return result;
+}
+
+// Chemins complets construits ici seulement, une entrée à la fois
+static NSArray<RemoteFileInfo *> *makeFileInfos(const SCPClient::DirectoryListing& listing) {
+    NSMutableArray<RemoteFileInfo *> *result = [NSMutableArray arrayWithCapacity:listing.size()];
+    SCPClient::RemoteFile file;
+    for (size_t i = 0; i < listing.size(); ++i) {
+        listing.entry(i, file);
+        [result addObject:makeFileInfo(file)];
+    }
+    return result;
+}
+
+using BatchCall = bool (SCPClient::SCPSession::*)(const std::vector<std::string>&,
+                                                  std::vector<SCPClient::PathResult>*);
+
+static NSDictionary<NSString *, NSString *> *runBatch(SCPClient::SCPSession& session, BatchCall call,
+                                                      NSArray<NSString *> *paths) {
+    std::vector<std::string> pathStrs;
+    pathStrs.reserve(paths.count);
+    for (NSString *path in paths) {
+        pathStrs.push_back([path UTF8String]);
+    }
+
+    std::vector<SCPClient::PathResult> results;
+    (session.*call)(pathStrs, &results);
+
+    NSMutableDictionary<NSString *, NSString *> *failures = [NSMutableDictionary dictionary];
+    for (const auto& result : results) {
+        if (!result.ok) {
+            failures[[NSString stringWithUTF8String:result.path.c_str()]] =
+                [NSString stringWithUTF8String:result.error.c_str()];
+        }
+    }
+    return failures;
+}
+
+// Texte d'un morceau de sortie ; un caractère UTF-8 coupé en fin de morceau
+// attend le suivant dans `pending`, sauf au dernier. nil si rien n'est complet.
+static NSString *takeOutputText(std::string& pending, const char* data, size_t length, bool last) {
+    if (length) pending.append(data, length);
+    size_t complete = pending.size();
+    if (!last) {
+        // Recule jusqu'au dernier octet de tête, et le garde si sa séquence
+        // n'est pas entière
+        size_t back = 0;
+        while (back < 3 && back < complete &&
+               ((unsigned char)pending[complete - 1 - back] & 0xC0) == 0x80) {
+            ++back;
+        }
+        if (back < complete) {
+            unsigned char lead = pending[complete - 1 - back];
+            size_t needed = lead >= 0xF0 ? 4 : lead >= 0xE0 ? 3 : lead >= 0xC0 ? 2 : 1;
+            if (needed > back + 1) complete -= back + 1;
+        }
+    }
+    if (complete == 0) return nil;
+
+    NSString *text = [[NSString alloc] initWithBytes:pending.data()
+                                              length:complete
+                                            encoding:NSUTF8StringEncoding];
+    if (!text) {
+        // Sortie qui n'est pas de l'UTF-8 : octet pour octet
+        text = [[NSString alloc] initWithBytes:pending.data()
+                                        length:complete
+                                      encoding:NSISOLatin1StringEncoding];
+    }
+    pending.erase(0, complete);
+    return text;
+}
+
 @interface SCPSessionBridge() {
-    std::unique_ptr<SCPClient::SCPSession> _session;
+    // Session empruntée au pool partagé une fois connecté ; rendue (et gardée
+    // ouverte) à la déconnexion pour que le prochain onglet la réutilise
+    std::shared_ptr<SCPClient::SCPSession> _session;
+    SCPClient::ProtocolType _protocol;
+    NSTimeInterval _cacheTTL;
+    SCPClient::TransferPriority _priority;
+    uint64_t _rateLimit;
+    BOOL _uncachedDownloads;
+    BOOL _verifyTransfers;
+    BOOL _prefetchDirectories;
+    size_t _chunkSize;
+    unsigned _transferWindow;
 }
 @end
 
@@ -24,13 +130,142 @@ static NSString *const SCPErrorDomain = @"com.scpclient.error";
 - (instancetype)init {
     self = [super init];
     if (self) {
-        _session = std::make_unique<SCPClient::SCPSession>();
+        _protocol = SCPClient::ProtocolType::SCP;
+        _cacheTTL = 30;
+        _priority = SCPClient::TransferPriority::Normal;
+        _rateLimit = 0;
+        _uncachedDownloads = NO;
+        _verifyTransfers = NO;
+        _prefetchDirectories = NO;
+        _chunkSize = 64 * 1024;
+        _transferWindow = 8;
+        _session = std::make_shared<SCPClient::SCPSession>();
     }
     return self;
 }
 
 - (void)setProtocolSCP:(BOOL)useSCP {
-    _session->setProtocol(useSCP ? SCPClient::ProtocolType::SCP : SCPClient::ProtocolType::SFTP);
+    _protocol = useSCP ? SCPClient::ProtocolType::SCP : SCPClient::ProtocolType::SFTP;
+    _session->setProtocol(_protocol);
+}
+
++ (void)setGlobalBandwidthLimit:(uint64_t)bytesPerSecond {
+    SCPClient::TransferScheduler::shared().setGlobalLimit(bytesPerSecond);
+}
+
++ (void)setBandwidthLimit:(uint64_t)bytesPerSecond forHost:(NSString *)host {
+    SCPClient::TransferScheduler::shared().setHostLimit([host UTF8String], bytesPerSecond);
+}
+
++ (void)setProgressInterval:(NSTimeInterval)interval minimumBytes:(uint64_t)bytes {
+    SCPClient::ProgressTracker::shared().setPublishRate(
+        std::chrono::milliseconds((int64_t)(MAX(interval, 0) * 1000)), bytes);
+}
+
++ (NSArray<SCPTransferInfo *> *)activeTransfers {
+    std::vector<SCPClient::TransferSnapshot> snapshots = SCPClient::ProgressTracker::shared().snapshot();
+    NSMutableArray<SCPTransferInfo *> *result = [NSMutableArray arrayWithCapacity:snapshots.size()];
+    for (const auto& snapshot : snapshots) {
+        SCPTransferInfo *info = [[SCPTransferInfo alloc] init];
+        info.transferID = snapshot.id;
+        info.host = [NSString stringWithUTF8String:snapshot.host.c_str()];
+        info.path = [NSString stringWithUTF8String:snapshot.path.c_str()];
+        info.isUpload = snapshot.upload;
+        info.transferred = snapshot.transferred;
+        info.total = snapshot.total;
+        info.bytesPerSecond = snapshot.bytesPerSecond;
+        info.timeRemaining = snapshot.secondsRemaining;
+        info.elapsed = snapshot.elapsedSeconds;
+        [result addObject:info];
+    }
+    return result;
+}
+
+- (void)setTransferPriority:(SCPTransferPriority)priority {
+    switch (priority) {
+        case SCPTransferPriorityInteractive: _priority = SCPClient::TransferPriority::Interactive; break;
+        case SCPTransferPriorityBulk: _priority = SCPClient::TransferPriority::Bulk; break;
+        default: _priority = SCPClient::TransferPriority::Normal; break;
+    }
+    _session->setTransferPriority(_priority);
+}
+
+- (void)setTransferRateLimit:(uint64_t)bytesPerSecond {
+    _rateLimit = bytesPerSecond;
+    _session->setTransferRateLimit(_rateLimit);
+}
+
+- (void)setChunkSize:(NSUInteger)bytes transferWindow:(NSUInteger)requests {
+    _chunkSize = bytes;
+    _transferWindow = (unsigned)requests;
+    _session->setChunkSize(_chunkSize);
+    _session->setTransferWindow(_transferWindow);
+}
+
+- (void)setUncachedDownloads:(BOOL)enabled {
+    _uncachedDownloads = enabled;
+    _session->setUncachedDownloads(_uncachedDownloads);
+}
+
+- (void)setVerifyTransfers:(BOOL)enabled {
+    _verifyTransfers = enabled;
+    _session->setVerifyTransfers(_verifyTransfers);
+}
+
+- (NSArray<NSValue *> *)lastMismatchedRanges {
+    SCPClient::IntegrityReport report = _session->getLastIntegrityReport();
+    NSMutableArray<NSValue *> *ranges = [NSMutableArray arrayWithCapacity:report.mismatched.size()];
+    for (const auto& range : report.mismatched) {
+        [ranges addObject:[NSValue valueWithRange:NSMakeRange((NSUInteger)range.start,
+                                                              (NSUInteger)(range.end - range.start))]];
+    }
+    return ranges;
+}
+
+- (void)setDirectoryCacheTTL:(NSTimeInterval)seconds {
+    _cacheTTL = MAX(seconds, 0);
+    _session->setDirectoryCache((unsigned)_cacheTTL);
+}
+
+- (void)refreshDirectoryAtPath:(NSString *)path {
+    _session->invalidateDirectoryCache([path UTF8String]);
+}
+
+- (void)setPrefetchDirectories:(BOOL)enabled {
+    _prefetchDirectories = enabled;
+    _session->setPrefetch(_prefetchDirectories);
+}
+
+- (BOOL)acquireSessionWithCredentials:(const SCPClient::SessionCredentials &)credentials
+                                error:(NSError **)error {
+    // Rendre la session courante avant d'en emprunter une autre
+    _session = std::make_shared<SCPClient::SCPSession>();
+    _session->setProtocol(_protocol);
+
+    std::string errMsg;
+    SCPClient::SessionPool::Lease lease =
+        SCPClient::SessionPool::shared().acquire(credentials, _protocol, &errMsg, true, true);
+
+    if (!lease) {
+        if (error) {
+            NSDictionary *userInfo = @{
+                NSLocalizedDescriptionKey: [NSString stringWithUTF8String:errMsg.c_str()]
+            };
+            *error = [NSError errorWithDomain:SCPErrorDomain code:1 userInfo:userInfo];
+        }
+        return NO;
+    }
+
+    _session = lease;
+    _session->setDirectoryCache((unsigned)_cacheTTL);
+    _session->setTransferPriority(_priority);
+    _session->setTransferRateLimit(_rateLimit);
+    _session->setUncachedDownloads(_uncachedDownloads);
+    _session->setVerifyTransfers(_verifyTransfers);
+    _session->setPrefetch(_prefetchDirectories);
+    _session->setChunkSize(_chunkSize);
+    _session->setTransferWindow(_transferWindow);
+    return YES;
 }
 
 - (BOOL)connectToHost:(NSString *)host
@@ -39,21 +274,13 @@ static NSString *const SCPErrorDomain = @"com.scpclient.error";
              password:(NSString *)password
                 error:(NSError **)error {
 
-    std::string hostStr = [host UTF8String];
-    std::string userStr = [username UTF8String];
-    std::string passStr = [password UTF8String];
-
-    BOOL success = _session->connect(hostStr, (int)port, userStr, passStr);
-
-    if (!success && error) {
-        std::string errMsg = _session->getLastError();
-        NSDictionary *userInfo = @{
-            NSLocalizedDescriptionKey: [NSString stringWithUTF8String:errMsg.c_str()]
-        };
-        *error = [NSError errorWithDomain:SCPErrorDomain code:1 userInfo:userInfo];
-    }
+    SCPClient::SessionCredentials credentials;
+    credentials.host = [host UTF8String];
+    credentials.port = (int)port;
+    credentials.username = [username UTF8String];
+    credentials.password = [password UTF8String];
 
-    return success;
+    return [self acquireSessionWithCredentials:credentials error:error];
 }
 
 - (BOOL)connectToHost:(NSString *)host
@@ -63,53 +290,129 @@ static NSString *const SCPErrorDomain = @"com.scpclient.error";
            passphrase:(nullable NSString *)passphrase
                 error:(NSError **)error {
 
-    std::string hostStr = [host UTF8String];
-    std::string userStr = [username UTF8String];
-    std::string keyStr = [privateKeyPath UTF8String];
-    std::string passStr = passphrase ? [passphrase UTF8String] : "";
+    SCPClient::SessionCredentials credentials;
+    credentials.host = [host UTF8String];
+    credentials.port = (int)port;
+    credentials.username = [username UTF8String];
+    credentials.useKey = true;
+    credentials.privateKeyPath = [privateKeyPath UTF8String];
+    credentials.passphrase = passphrase ? [passphrase UTF8String] : "";
 
-    BOOL success = _session->connectWithKey(hostStr, (int)port, userStr, keyStr, passStr);
+    return [self acquireSessionWithCredentials:credentials error:error];
+}
+
+- (void)disconnect {
+    // La session retourne au pool, qui la maintient en vie jusqu'à expiration
+    _session = std::make_shared<SCPClient::SCPSession>();
+    _session->setProtocol(_protocol);
+}
+
+- (BOOL)isConnected {
+    return _session->isConnected();
+}
+
+- (nullable NSArray<RemoteFileInfo *> *)listDirectoryAtPath:(NSString *)path
+                                                       error:(NSError **)error {
+    std::string pathStr = [path UTF8String];
+    SCPClient::DirectoryListing listing;
+    if (!_session->listDirectory(pathStr, listing)) {
+        if (error) {
+            std::string errMsg = _session->getLastError();
+            NSDictionary *userInfo = @{
+                NSLocalizedDescriptionKey: [NSString stringWithUTF8String:errMsg.c_str()]
+            };
+            *error = [NSError errorWithDomain:SCPErrorDomain code:11 userInfo:userInfo];
+        }
+        return nil;
+    }
+    return makeFileInfos(listing);
+}
+
+- (BOOL)listDirectoryAtPath:(NSString *)path
+                  batchSize:(NSUInteger)batchSize
+                    handler:(ListingBatchBlock)handler
+                      error:(NSError **)error {
+    std::string pathStr = [path UTF8String];
+    BOOL success = _session->listDirectory(pathStr, batchSize,
+                                           [handler](const std::vector<SCPClient::RemoteFile>& batch) {
+        @autoreleasepool {
+            return (bool)handler(makeFileInfos(batch));
+        }
+    });
 
     if (!success && error) {
         std::string errMsg = _session->getLastError();
         NSDictionary *userInfo = @{
             NSLocalizedDescriptionKey: [NSString stringWithUTF8String:errMsg.c_str()]
         };
-        *error = [NSError errorWithDomain:SCPErrorDomain code:1 userInfo:userInfo];
+        *error = [NSError errorWithDomain:SCPErrorDomain code:11 userInfo:userInfo];
     }
 
     return success;
 }
 
-- (void)disconnect {
-    _session->disconnect();
-}
-
-- (BOOL)isConnected {
-    return _session->isConnected();
-}
-
 - (nullable NSArray<RemoteFileInfo *> *)listDirectoryAtPath:(NSString *)path
+                                                        page:(NSUInteger)page
+                                                    pageSize:(NSUInteger)pageSize
+                                                     hasMore:(nullable BOOL *)hasMore
                                                        error:(NSError **)error {
     std::string pathStr = [path UTF8String];
-    std::vector<SCPClient::RemoteFile> files = _session->listDirectory(pathStr);
+    pageSize = MAX(pageSize, (NSUInteger)1);
 
-    NSMutableArray<RemoteFileInfo *> *result = [NSMutableArray array];
+    SCPClient::ListingCursor cursor;
+    cursor.position = (uint64_t)page * pageSize;
+    cursor.limit = pageSize;
 
-    for (const auto& file : files) {
-        RemoteFileInfo *info = [[RemoteFileInfo alloc] init];
-        info.name = [NSString stringWithUTF8String:file.name.c_str()];
-        info.path = [NSString stringWithUTF8String:file.path.c_str()];
-        info.size = file.size;
-        info.permissions = file.permissions;
-        info.isDirectory = file.isDirectory;
-        info.modificationDate = [NSDate dateWithTimeIntervalSince1970:file.modificationTime];
-        [result addObject:info];
+    NSMutableArray<RemoteFileInfo *> *result = [NSMutableArray arrayWithCapacity:pageSize];
+    BOOL success = _session->listDirectory(pathStr, pageSize,
+                                           [result](const std::vector<SCPClient::RemoteFile>& batch) {
+        for (const auto& file : batch) {
+            [result addObject:makeFileInfo(file)];
+        }
+        return true;
+    }, &cursor);
+
+    if (!success) {
+        if (error) {
+            std::string errMsg = _session->getLastError();
+            NSDictionary *userInfo = @{
+                NSLocalizedDescriptionKey: [NSString stringWithUTF8String:errMsg.c_str()]
+            };
+            *error = [NSError errorWithDomain:SCPErrorDomain code:11 userInfo:userInfo];
+        }
+        return nil;
     }
 
+    if (hasMore) *hasMore = !cursor.complete;
     return result;
 }
 
+- (nullable NSArray<RemoteFileInfo *> *)findAtPath:(NSString *)path
+                                           matching:(nullable NSString *)pattern
+                                            minSize:(uint64_t)minSize
+                                      modifiedAfter:(nullable NSDate *)modifiedAfter
+                                          recursive:(BOOL)recursive
+                                              error:(NSError **)error {
+    SCPClient::ListingQuery query;
+    if (pattern) query.namePattern = [pattern UTF8String];
+    query.minSize = minSize;
+    if (modifiedAfter) query.newerThan = (int64_t)[modifiedAfter timeIntervalSince1970];
+    query.recursive = recursive;
+
+    std::vector<SCPClient::RemoteFile> matches;
+    if (!_session->find([path UTF8String], query, matches)) {
+        if (error) {
+            std::string errMsg = _session->getLastError();
+            NSDictionary *userInfo = @{
+                NSLocalizedDescriptionKey: [NSString stringWithUTF8String:errMsg.c_str()]
+            };
+            *error = [NSError errorWithDomain:SCPErrorDomain code:12 userInfo:userInfo];
+        }
+        return nil;
+    }
+    return makeFileInfos(matches);
+}
+
 - (BOOL)changeDirectoryToPath:(NSString *)path error:(NSError **)error {
     std::string pathStr = [path UTF8String];
     BOOL success = _session->changeDirectory(pathStr);
@@ -190,6 +493,68 @@ static NSString *const SCPErrorDomain = @"com.scpclient.error";
     return success;
 }
 
+- (BOOL)uploadDirectoryFrom:(NSString *)localPath
+                         to:(NSString *)remotePath
+                    workers:(NSInteger)workers
+                   progress:(nullable ProgressBlock)progress
+                      error:(NSError **)error {
+
+    std::string localStr = [localPath UTF8String];
+    std::string remoteStr = [remotePath UTF8String];
+
+    SCPClient::ProgressCallback callback = nullptr;
+    if (progress) {
+        callback = [progress](uint64_t transferred, uint64_t total) {
+            dispatch_async(dispatch_get_main_queue(), ^{
+                progress(transferred, total);
+            });
+        };
+    }
+
+    BOOL success = _session->uploadTree(localStr, remoteStr, (unsigned)MAX(workers, 1), callback);
+
+    if (!success && error) {
+        std::string errMsg = _session->getLastError();
+        NSDictionary *userInfo = @{
+            NSLocalizedDescriptionKey: [NSString stringWithUTF8String:errMsg.c_str()]
+        };
+        *error = [NSError errorWithDomain:SCPErrorDomain code:9 userInfo:userInfo];
+    }
+
+    return success;
+}
+
+- (BOOL)downloadDirectoryFrom:(NSString *)remotePath
+                           to:(NSString *)localPath
+                      workers:(NSInteger)workers
+                     progress:(nullable ProgressBlock)progress
+                        error:(NSError **)error {
+
+    std::string remoteStr = [remotePath UTF8String];
+    std::string localStr = [localPath UTF8String];
+
+    SCPClient::ProgressCallback callback = nullptr;
+    if (progress) {
+        callback = [progress](uint64_t transferred, uint64_t total) {
+            dispatch_async(dispatch_get_main_queue(), ^{
+                progress(transferred, total);
+            });
+        };
+    }
+
+    BOOL success = _session->downloadTree(remoteStr, localStr, (unsigned)MAX(workers, 1), callback);
+
+    if (!success && error) {
+        std::string errMsg = _session->getLastError();
+        NSDictionary *userInfo = @{
+            NSLocalizedDescriptionKey: [NSString stringWithUTF8String:errMsg.c_str()]
+        };
+        *error = [NSError errorWithDomain:SCPErrorDomain code:10 userInfo:userInfo];
+    }
+
+    return success;
+}
+
 - (BOOL)deleteFileAtPath:(NSString *)remotePath error:(NSError **)error {
     std::string pathStr = [remotePath UTF8String];
     BOOL success = _session->deleteFile(pathStr);
@@ -235,6 +600,60 @@ static NSString *const SCPErrorDomain = @"com.scpclient.error";
     return success;
 }
 
+- (NSDictionary<NSString *, NSString *> *)deleteFilesAtPaths:(NSArray<NSString *> *)paths {
+    return runBatch(*_session, &SCPClient::SCPSession::deleteFiles, paths);
+}
+
+- (NSDictionary<NSString *, NSString *> *)createDirectoriesAtPaths:(NSArray<NSString *> *)paths {
+    return runBatch(*_session, &SCPClient::SCPSession::createDirectories, paths);
+}
+
+- (NSDictionary<NSString *, NSString *> *)deleteDirectoriesAtPaths:(NSArray<NSString *> *)paths {
+    return runBatch(*_session, &SCPClient::SCPSession::deleteDirectories, paths);
+}
+
+- (BOOL)removeTreeAtPath:(NSString *)remotePath error:(NSError **)error {
+    BOOL success = _session->removeTree([remotePath UTF8String]);
+
+    if (!success && error) {
+        std::string errMsg = _session->getLastError();
+        NSDictionary *userInfo = @{
+            NSLocalizedDescriptionKey: [NSString stringWithUTF8String:errMsg.c_str()]
+        };
+        *error = [NSError errorWithDomain:SCPErrorDomain code:15 userInfo:userInfo];
+    }
+
+    return success;
+}
+
+- (BOOL)copyItemAtPath:(NSString *)sourcePath toPath:(NSString *)destinationPath error:(NSError **)error {
+    BOOL success = _session->copyRemote([sourcePath UTF8String], [destinationPath UTF8String]);
+
+    if (!success && error) {
+        std::string errMsg = _session->getLastError();
+        NSDictionary *userInfo = @{
+            NSLocalizedDescriptionKey: [NSString stringWithUTF8String:errMsg.c_str()]
+        };
+        *error = [NSError errorWithDomain:SCPErrorDomain code:16 userInfo:userInfo];
+    }
+
+    return success;
+}
+
+- (BOOL)moveItemAtPath:(NSString *)sourcePath toPath:(NSString *)destinationPath error:(NSError **)error {
+    BOOL success = _session->moveRemote([sourcePath UTF8String], [destinationPath UTF8String]);
+
+    if (!success && error) {
+        std::string errMsg = _session->getLastError();
+        NSDictionary *userInfo = @{
+            NSLocalizedDescriptionKey: [NSString stringWithUTF8String:errMsg.c_str()]
+        };
+        *error = [NSError errorWithDomain:SCPErrorDomain code:17 userInfo:userInfo];
+    }
+
+    return success;
+}
+
 - (NSString *)executeCommand:(NSString *)command error:(NSError **)error {
     std::string cmdStr = [command UTF8String];
     std::string output = _session->executeCommand(cmdStr);
@@ -259,4 +678,59 @@ static NSString *const SCPErrorDomain = @"com.scpclient.error";
     return [NSString stringWithUTF8String:output.c_str()];
 }
 
+- (BOOL)openShellWithTerminal:(NSString *)term
+                      columns:(NSUInteger)columns
+                         rows:(NSUInteger)rows
+                         echo:(BOOL)echo
+                       output:(ShellOutputBlock)output
+                       closed:(nullable ShellClosedBlock)closed
+                        error:(NSError **)error {
+    SCPClient::ShellOptions options;
+    options.term = [term UTF8String];
+    options.columns = (unsigned)columns;
+    options.rows = (unsigned)rows;
+    options.echo = echo;
+
+    // Appelés depuis le thread du réacteur, l'un après l'autre
+    auto pending = std::make_shared<std::string>();
+    SCPClient::ShellClosedCallback onClosed = nullptr;
+    if (closed) {
+        onClosed = [closed](int exitStatus) {
+            closed(exitStatus);
+        };
+    }
+    BOOL success = _session->openShell(options, [output, pending](const char* data, size_t length) {
+        @autoreleasepool {
+            NSString *text = takeOutputText(*pending, data, length, false);
+            if (text) output(text);
+        }
+    }, onClosed);
+
+    if (!success && error) {
+        std::string errMsg = _session->getLastError();
+        NSDictionary *userInfo = @{
+            NSLocalizedDescriptionKey: [NSString stringWithUTF8String:errMsg.c_str()]
+        };
+        *error = [NSError errorWithDomain:SCPErrorDomain code:13 userInfo:userInfo];
+    }
+
+    return success;
+}
+
+- (BOOL)writeToShell:(NSString *)input {
+    return _session->writeShell([input UTF8String]);
+}
+
+- (void)resizeShellToColumns:(NSUInteger)columns rows:(NSUInteger)rows {
+    _session->resizeShell((unsigned)columns, (unsigned)rows);
+}
+
+- (void)closeShell {
+    _session->closeShell();
+}
+
+- (BOOL)isShellOpen {
+    return _session->isShellOpen();
+}
+
 @end
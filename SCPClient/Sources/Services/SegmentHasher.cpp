@@ -0,0 +1,67 @@
+//
+//  SegmentHasher.cpp
+//  SCP Client for macOS
+//
+//  Implémentation du hachage par segments
+//
+
+#include "SegmentHasher.h"
+#include "TransferJournal.h"
+#include <algorithm>
+
+namespace SCPClient {
+
+const uint64_t SegmentHasher::segmentSize;
+
+size_t SegmentHasher::segmentCount(uint64_t size) {
+    return (size_t)((size + segmentSize - 1) / segmentSize);
+}
+
+SegmentHasher::SegmentHasher(int fd, uint64_t size, unsigned threadCount)
+    : fd(fd), size(size), hashes(segmentCount(size)), remaining(segmentCount(size)) {
+    if (threadCount == 0) {
+        threadCount = std::min(8u, std::max(1u, std::thread::hardware_concurrency()));
+    }
+    threadCount = (unsigned)std::min<size_t>(threadCount, remaining);
+    for (unsigned i = 0; i < threadCount; ++i) {
+        threads.emplace_back([this]() { work(); });
+    }
+}
+
+SegmentHasher::~SegmentHasher() {
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        stopping = true;
+    }
+    changed.notify_all();
+    for (std::thread& thread : threads) {
+        thread.join();
+    }
+}
+
+std::vector<std::string> SegmentHasher::digests() {
+    std::unique_lock<std::mutex> lock(mutex);
+    changed.wait(lock, [&]() { return remaining == 0; });
+    if (failed) return {};
+    return hashes;
+}
+
+// Chaque thread prend le segment suivant jusqu'au dernier
+void SegmentHasher::work() {
+    std::unique_lock<std::mutex> lock(mutex);
+    while (!stopping && next < hashes.size()) {
+        size_t index = next++;
+        lock.unlock();
+
+        uint64_t start = index * segmentSize;
+        std::string hex;
+        bool ok = sha256Range(fd, start, std::min(segmentSize, size - start), hex);
+
+        lock.lock();
+        hashes[index] = std::move(hex);
+        if (!ok) failed = true;
+        if (--remaining == 0) changed.notify_all();
+    }
+}
+
+} // namespace SCPClient
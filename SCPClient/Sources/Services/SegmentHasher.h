@@ -0,0 +1,62 @@
+//
+//  SegmentHasher.h
+//  SCP Client for macOS
+//
+//  Empreintes SHA-256 d'un fichier local par segments, calculées en
+//  parallèle, pour le contrôle d'intégrité
+//
+
+#ifndef SegmentHasher_h
+#define SegmentHasher_h
+
+#include <condition_variable>
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace SCPClient {
+
+// Le fichier est découpé en segments de segmentSize octets, chacun haché
+// indépendamment (SHA-256 de libcrypto, qui utilise les instructions SHA du
+// processeur) : plusieurs threads se partagent les segments, et un segment
+// ne différant pas côté distant n'a pas à être renvoyé. Le hachage commence
+// dès la construction, sur le fichier tel qu'il est sur le disque : l'appelant
+// peut faire autre chose (transfert, hachage distant) en attendant digests().
+class SegmentHasher {
+public:
+    static const uint64_t segmentSize = 8 * 1024 * 1024;
+
+    static size_t segmentCount(uint64_t size);
+
+    // `fd` reste à l'appelant et doit rester ouvert jusqu'à la destruction ;
+    // `threads` = 0 : un par cœur (8 au plus)
+    SegmentHasher(int fd, uint64_t size, unsigned threads = 0);
+    ~SegmentHasher();
+
+    SegmentHasher(const SegmentHasher&) = delete;
+    SegmentHasher& operator=(const SegmentHasher&) = delete;
+
+    // Attend tous les segments : empreintes hexadécimales dans l'ordre, vide
+    // si un segment n'a pas pu être lu
+    std::vector<std::string> digests();
+
+private:
+    void work();
+
+    int fd;
+    uint64_t size;
+    std::vector<std::string> hashes;
+    size_t next = 0;        // prochain segment à prendre
+    size_t remaining;
+    bool failed = false;
+    bool stopping = false;
+    std::mutex mutex;
+    std::condition_variable changed;
+    std::vector<std::thread> threads;
+};
+
+} // namespace SCPClient
+
+#endif /* SegmentHasher_h */
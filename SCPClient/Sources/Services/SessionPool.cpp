@@ -0,0 +1,289 @@
+//
+//  SessionPool.cpp
+//  SCP Client for macOS
+//
+//  Implémentation du pool de sessions SSH
+//
+
+#include "SessionPool.h"
+#include <openssl/evp.h>
+#include <algorithm>
+#include <tuple>
+
+namespace SCPClient {
+
+// Empreinte du secret d'authentification : le clair ne reste pas dans les
+// clés du pool. Les champs sont préfixés de leur longueur.
+static std::string credentialDigest(const SessionCredentials& credentials) {
+    std::string material;
+    for (const std::string* field : {&credentials.password, &credentials.passphrase}) {
+        material += std::to_string(field->size()) + ":" + *field;
+    }
+    unsigned char digest[EVP_MAX_MD_SIZE];
+    unsigned int length = 0;
+    EVP_Digest(material.data(), material.size(), digest, &length, EVP_sha256(), nullptr);
+    std::fill(material.begin(), material.end(), '\0');
+    return std::string(reinterpret_cast<const char*>(digest), length);
+}
+
+SessionKey SessionKey::from(const SessionCredentials& credentials, ProtocolType protocol) {
+    SessionKey key;
+    key.host = credentials.host;
+    key.port = credentials.port;
+    key.username = credentials.username;
+    key.useKey = credentials.useKey;
+    key.privateKeyPath = credentials.useKey ? credentials.privateKeyPath : "";
+    key.secretDigest = credentialDigest(credentials);
+    key.protocol = protocol;
+    return key;
+}
+
+std::string SessionKey::hostKey() const {
+    return host + ":" + std::to_string(port);
+}
+
+bool SessionKey::operator<(const SessionKey& other) const {
+    return std::tie(host, port, username, useKey, privateKeyPath, secretDigest, protocol) <
+           std::tie(other.host, other.port, other.username, other.useKey,
+                    other.privateKeyPath, other.secretDigest, other.protocol);
+}
+
+SessionPool& SessionPool::shared() {
+    // Jamais détruit : à la sortie, OpenSSL peut déjà être nettoyé et la
+    // fermeture des sessions inactives planterait
+    static SessionPool* pool = new SessionPool();
+    return *pool;
+}
+
+SessionPool::SessionPool() = default;
+
+SessionPool::~SessionPool() {
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        stopping = true;
+    }
+    wakeMaintenance.notify_all();
+    if (maintenance.joinable()) {
+        maintenance.join();
+    }
+    clear();
+}
+
+void SessionPool::setMaxSessionsPerHost(unsigned max) {
+    std::lock_guard<std::mutex> lock(mutex);
+    maxPerHost = std::max(1u, max);
+}
+
+void SessionPool::setIdleTimeout(int seconds) {
+    std::lock_guard<std::mutex> lock(mutex);
+    idleTimeout = seconds;
+}
+
+void SessionPool::setKeepaliveInterval(int seconds) {
+    std::lock_guard<std::mutex> lock(mutex);
+    keepaliveInterval = std::max(2, seconds);
+    wakeMaintenance.notify_all();
+}
+
+void SessionPool::setAcquireTimeout(int seconds) {
+    std::lock_guard<std::mutex> lock(mutex);
+    acquireTimeout = seconds;
+}
+
+unsigned SessionPool::getMaxSessionsPerHost() const {
+    std::lock_guard<std::mutex> lock(mutex);
+    return maxPerHost;
+}
+
+SessionPool::Lease SessionPool::acquire(const SessionCredentials& credentials,
+                                        ProtocolType protocol, std::string* error, bool wait,
+                                        bool keepCredentials) {
+    SessionKey key = SessionKey::from(credentials, protocol);
+    std::string hostKey = key.hostKey();
+    std::unique_ptr<SCPSession> session;
+    // Sessions évincées, fermées à la sortie, une fois le verrou rendu
+    std::vector<std::unique_ptr<SCPSession>> evicted;
+    int keepalive;
+
+    {
+        std::unique_lock<std::mutex> lock(mutex);
+        if (!maintenance.joinable()) {
+            maintenance = std::thread(&SessionPool::maintenanceLoop, this);
+        }
+
+        auto deadline = Clock::now() + std::chrono::seconds(acquireTimeout);
+        while (true) {
+            // Réutiliser la session inactive la plus récente
+            auto it = idle.find(key);
+            if (it != idle.end() && !it->second.empty()) {
+                session = std::move(it->second.back().session);
+                it->second.pop_back();
+                if (it->second.empty()) idle.erase(it);
+                break;
+            }
+            // Une session de même clé en cours de keepalive revient bientôt :
+            // pas de nouvelle connexion en attendant
+            if (wait && checking.count(key) && released.wait_until(lock, deadline) != std::cv_status::timeout) {
+                continue;
+            }
+            // Sinon réserver une place avant de se connecter
+            if (openPerHost[hostKey] < maxPerHost) {
+                ++openPerHost[hostKey];
+                break;
+            }
+            if (std::unique_ptr<SCPSession> oldest = evictIdleForHost(hostKey)) {
+                evicted.push_back(std::move(oldest));
+                ++openPerHost[hostKey];
+                break;
+            }
+            if (!wait || released.wait_until(lock, deadline) == std::cv_status::timeout) {
+                if (error) *error = "Too many sessions open to " + hostKey;
+                return nullptr;
+            }
+        }
+        keepalive = keepaliveInterval;
+    }
+
+    // Nouvelle connexion, hors verrou
+    if (!session) {
+        session = std::make_unique<SCPSession>();
+        session->setProtocol(protocol);
+        if (!session->connect(credentials)) {
+            if (error) *error = session->getLastError();
+            std::lock_guard<std::mutex> lock(mutex);
+            --openPerHost[hostKey];
+            released.notify_one();
+            return nullptr;
+        }
+        session->setKeepalive(keepalive);
+    }
+    // Une session de travail n'ouvre pas d'autre session : le secret n'a pas
+    // à rester en clair dans chacune. Une session inactive n'en a plus.
+    if (keepCredentials) {
+        session->restoreCredentials(credentials);
+    } else {
+        session->forgetCredentials();
+    }
+
+    return Lease(session.release(), [this, key](SCPSession* returned) {
+        release(key, returned);
+    });
+}
+
+void SessionPool::release(const SessionKey& key, SCPSession* session) {
+    std::unique_ptr<SCPSession> owned(session);
+    // Le shell du terminal et le préchargement ne suivent pas la session chez
+    // le prochain emprunteur
+    owned->closeShell();
+    owned->setPrefetch(false);
+    owned->forgetCredentials();
+    std::lock_guard<std::mutex> lock(mutex);
+    if (owned->isConnected() && !stopping) {
+        idle[key].push_back({std::move(owned), Clock::now()});
+    } else {
+        --openPerHost[key.hostKey()];
+    }
+    released.notify_all();
+}
+
+// Plus ancienne session inactive de l'hôte (autre clé), retirée pour libérer
+// une place ; appelé sous verrou
+std::unique_ptr<SCPSession> SessionPool::evictIdleForHost(const std::string& hostKey) {
+    auto oldest = idle.end();
+    for (auto it = idle.begin(); it != idle.end(); ++it) {
+        if (it->first.hostKey() != hostKey || it->second.empty()) continue;
+        if (oldest == idle.end() || it->second.front().since < oldest->second.front().since) {
+            oldest = it;
+        }
+    }
+    if (oldest == idle.end()) return nullptr;
+
+    std::unique_ptr<SCPSession> session = std::move(oldest->second.front().session);
+    oldest->second.erase(oldest->second.begin());
+    if (oldest->second.empty()) idle.erase(oldest);
+    --openPerHost[hostKey];
+    return session;
+}
+
+void SessionPool::maintain() {
+    // Les sessions inactives sont sorties du pool le temps du keepalive
+    // (E/S réseau), mais restent comptées et marquées en contrôle : acquire()
+    // attend leur retour plutôt que d'ouvrir une nouvelle connexion. Chacune
+    // est rendue dès son keepalive passé.
+    std::vector<std::pair<SessionKey, IdleSession>> checked;
+    std::vector<std::unique_ptr<SCPSession>> expired;
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        auto now = Clock::now();
+        for (auto& entry : idle) {
+            for (IdleSession& session : entry.second) {
+                if (now - session.since > std::chrono::seconds(idleTimeout)) {
+                    expired.push_back(std::move(session.session));
+                    --openPerHost[entry.first.hostKey()];
+                } else {
+                    ++checking[entry.first];
+                    checked.emplace_back(entry.first, std::move(session));
+                }
+            }
+        }
+        idle.clear();
+    }
+    released.notify_all();
+
+    for (auto& entry : checked) {
+        bool alive = entry.second.session->sendKeepalive();
+        std::unique_ptr<SCPSession> closing;
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            if (--checking[entry.first] == 0) checking.erase(entry.first);
+            if (alive && !stopping) {
+                // Les plus récentes restent en fin de liste (réutilisées d'abord)
+                std::vector<IdleSession>& sessions = idle[entry.first];
+                auto position = std::upper_bound(sessions.begin(), sessions.end(), entry.second.since,
+                    [](Clock::time_point since, const IdleSession& other) { return since < other.since; });
+                sessions.insert(position, std::move(entry.second));
+            } else {
+                closing = std::move(entry.second.session);
+                --openPerHost[entry.first.hostKey()];
+            }
+        }
+        released.notify_all();
+        // Fermée hors verrou
+        closing.reset();
+    }
+    // Les sessions expirées sont fermées ici, hors verrou
+}
+
+void SessionPool::clear() {
+    std::map<SessionKey, std::vector<IdleSession>> closing;
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        for (auto& entry : idle) {
+            openPerHost[entry.first.hostKey()] -= (unsigned)entry.second.size();
+        }
+        closing.swap(idle);
+    }
+    released.notify_all();
+}
+
+size_t SessionPool::idleCount() const {
+    std::lock_guard<std::mutex> lock(mutex);
+    size_t count = 0;
+    for (const auto& entry : idle) {
+        count += entry.second.size();
+    }
+    return count;
+}
+
+void SessionPool::maintenanceLoop() {
+    std::unique_lock<std::mutex> lock(mutex);
+    while (!stopping) {
+        wakeMaintenance.wait_for(lock, std::chrono::seconds(std::max(1, keepaliveInterval / 2)));
+        if (stopping) break;
+        lock.unlock();
+        maintain();
+        lock.lock();
+    }
+}
+
+} // namespace SCPClient
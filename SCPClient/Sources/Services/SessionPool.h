@@ -0,0 +1,102 @@
+//
+//  SessionPool.h
+//  SCP Client for macOS
+//
+//  Pool de sessions SSH authentifiées, réutilisées entre onglets et transferts
+//
+
+#ifndef SessionPool_h
+#define SessionPool_h
+
+#include "SCPSession.h"
+#include <chrono>
+#include <condition_variable>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <thread>
+
+namespace SCPClient {
+
+// Une session n'est réutilisée que pour le même hôte, port, utilisateur,
+// mode d'authentification, protocole et secret : un mot de passe (ou une
+// phrase de passe) faux n'obtient pas une session déjà authentifiée
+struct SessionKey {
+    std::string host;
+    int port = 22;
+    std::string username;
+    bool useKey = false;
+    std::string privateKeyPath;
+    std::string secretDigest;   // SHA-256 du mot de passe / de la phrase de passe
+    ProtocolType protocol = ProtocolType::SCP;
+
+    static SessionKey from(const SessionCredentials& credentials, ProtocolType protocol);
+    std::string hostKey() const;
+    bool operator<(const SessionKey& other) const;
+};
+
+class SessionPool {
+public:
+    // Session empruntée : rendue au pool quand le dernier pointeur disparaît
+    using Lease = std::shared_ptr<SCPSession>;
+
+    // Pool partagé par toute l'application
+    static SessionPool& shared();
+
+    SessionPool();
+    ~SessionPool();
+
+    // Configuration
+    void setMaxSessionsPerHost(unsigned max);
+    void setIdleTimeout(int seconds);
+    void setKeepaliveInterval(int seconds);
+    void setAcquireTimeout(int seconds);
+    unsigned getMaxSessionsPerHost() const;
+
+    // Session authentifiée : une session inactive si possible, sinon une
+    // nouvelle connexion. Attend si la limite de l'hôte est atteinte, sauf
+    // avec wait à false (travail spéculatif) : nul aussitôt. Le secret n'est
+    // gardé dans la session que si keepCredentials (session principale, qui
+    // ouvre des sessions annexes) ; il est effacé quand elle revient au pool.
+    Lease acquire(const SessionCredentials& credentials, ProtocolType protocol,
+                  std::string* error = nullptr, bool wait = true,
+                  bool keepCredentials = false);
+
+    // Keepalive des sessions inactives et éviction de celles trop anciennes
+    void maintain();
+
+    // Ferme toutes les sessions inactives
+    void clear();
+    size_t idleCount() const;
+
+private:
+    using Clock = std::chrono::steady_clock;
+
+    struct IdleSession {
+        std::unique_ptr<SCPSession> session;
+        Clock::time_point since;
+    };
+
+    void release(const SessionKey& key, SCPSession* session);
+    // Retire du pool la plus ancienne session inactive de l'hôte ; elle est
+    // fermée par l'appelant, hors verrou
+    std::unique_ptr<SCPSession> evictIdleForHost(const std::string& hostKey);
+    void maintenanceLoop();
+
+    mutable std::mutex mutex;
+    std::condition_variable released;
+    std::condition_variable wakeMaintenance;
+    std::map<SessionKey, std::vector<IdleSession>> idle;
+    std::map<SessionKey, unsigned> checking;        // sorties pour un keepalive
+    std::map<std::string, unsigned> openPerHost;   // empruntées + inactives
+    unsigned maxPerHost = 8;
+    int idleTimeout = 300;
+    int keepaliveInterval = 30;
+    int acquireTimeout = 60;
+    bool stopping = false;
+    std::thread maintenance;
+};
+
+} // namespace SCPClient
+
+#endif /* SessionPool_h */
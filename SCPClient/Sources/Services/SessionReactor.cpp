@@ -0,0 +1,843 @@
+//
+//  SessionReactor.cpp
+//  SCP Client for macOS
+//
+//  Implémentation de la boucle d'événements non bloquante
+//
+
+#include "SessionReactor.h"
+#include <sys/socket.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <cerrno>
+#include <cstring>
+
+#ifdef __linux__
+#include <sys/epoll.h>
+#else
+#include <sys/event.h>
+#include <sys/time.h>
+#endif
+
+namespace SCPClient {
+
+// MARK: - SocketWaiter
+
+SocketWaiter::SocketWaiter(int sock) : sock(sock) {
+    if (pipe(wakePipe) == 0) {
+        fcntl(wakePipe[0], F_SETFL, O_NONBLOCK);
+        fcntl(wakePipe[1], F_SETFL, O_NONBLOCK);
+    }
+
+#ifdef __linux__
+    pollFd = epoll_create1(EPOLL_CLOEXEC);
+    struct epoll_event event;
+    memset(&event, 0, sizeof(event));
+    event.events = EPOLLIN;
+    event.data.fd = wakePipe[0];
+    epoll_ctl(pollFd, EPOLL_CTL_ADD, wakePipe[0], &event);
+    event.events = 0;
+    event.data.fd = sock;
+    epoll_ctl(pollFd, EPOLL_CTL_ADD, sock, &event);
+#else
+    pollFd = kqueue();
+    struct kevent change;
+    EV_SET(&change, wakePipe[0], EVFILT_READ, EV_ADD, 0, 0, nullptr);
+    kevent(pollFd, &change, 1, nullptr, 0, nullptr);
+#endif
+}
+
+SocketWaiter::~SocketWaiter() {
+    if (pollFd >= 0) close(pollFd);
+    if (wakePipe[0] >= 0) close(wakePipe[0]);
+    if (wakePipe[1] >= 0) close(wakePipe[1]);
+}
+
+void SocketWaiter::wait(int directions, int timeoutMs) {
+#ifdef __linux__
+    struct epoll_event event;
+    memset(&event, 0, sizeof(event));
+    event.data.fd = sock;
+    if (directions & LIBSSH2_SESSION_BLOCK_INBOUND) event.events |= EPOLLIN;
+    if (directions & LIBSSH2_SESSION_BLOCK_OUTBOUND) event.events |= EPOLLOUT;
+    epoll_ctl(pollFd, EPOLL_CTL_MOD, sock, &event);
+
+    struct epoll_event ready[2];
+    epoll_wait(pollFd, ready, 2, timeoutMs);
+#else
+    struct kevent changes[2];
+    int count = 0;
+    if (directions & LIBSSH2_SESSION_BLOCK_INBOUND) {
+        EV_SET(&changes[count++], sock, EVFILT_READ, EV_ADD | EV_ONESHOT, 0, 0, nullptr);
+    }
+    if (directions & LIBSSH2_SESSION_BLOCK_OUTBOUND) {
+        EV_SET(&changes[count++], sock, EVFILT_WRITE, EV_ADD | EV_ONESHOT, 0, 0, nullptr);
+    }
+
+    struct timespec timeout;
+    timeout.tv_sec = timeoutMs / 1000;
+    timeout.tv_nsec = (timeoutMs % 1000) * 1000000L;
+    struct kevent ready[3];
+    kevent(pollFd, changes, count, ready, 3, &timeout);
+#endif
+    drainWake();
+}
+
+void SocketWaiter::wake() {
+    char byte = 1;
+    ssize_t rc = write(wakePipe[1], &byte, 1);
+    (void)rc;   // tube plein : un réveil est déjà en attente
+}
+
+void SocketWaiter::drainWake() {
+    char bytes[64];
+    while (read(wakePipe[0], bytes, sizeof(bytes)) > 0) {
+    }
+}
+
+// MARK: - SessionReactor
+
+// Compte les octets reçus : un tour sans progrès mais avec des octets lus a pu
+// mettre en file des paquets destinés à une opération déjà passée
+static LIBSSH2_RECV_FUNC(countingRecv) {
+    ssize_t rc = recv(socket, buffer, length, flags);
+    if (rc < 0) {
+        return -errno;
+    }
+    if (*abstract) {
+        static_cast<std::atomic<uint64_t>*>(*abstract)->fetch_add(rc);
+    }
+    return rc;
+}
+
+SessionReactor::SessionReactor(LIBSSH2_SESSION* session, int sock)
+    : sshSession(session), waiter(sock) {
+    *libssh2_session_abstract(sshSession) = &received;
+#if LIBSSH2_VERSION_NUM >= 0x010b01
+    libssh2_session_callback_set2(sshSession, LIBSSH2_CALLBACK_RECV,
+                                  (libssh2_cb_generic*)countingRecv);
+#else
+    libssh2_session_callback_set(sshSession, LIBSSH2_CALLBACK_RECV, (void*)countingRecv);
+#endif
+    libssh2_session_set_blocking(sshSession, 0);
+    thread = std::thread(&SessionReactor::loop, this);
+}
+
+SessionReactor::~SessionReactor() {
+    stop();
+}
+
+void SessionReactor::stop() {
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        if (stopping) return;
+        stopping = true;
+    }
+    changed.notify_all();
+    waiter.wake();
+    if (thread.joinable()) {
+        thread.join();
+    }
+    libssh2_session_set_blocking(sshSession, 1);
+    *libssh2_session_abstract(sshSession) = nullptr;
+}
+
+bool SessionReactor::run(ReactorOperation& op) {
+    start(op);
+    return wait(op);
+}
+
+void SessionReactor::start(ReactorOperation& op) {
+    std::lock_guard<std::mutex> lock(mutex);
+    if (stopping) {
+        op.error = "Session closed";
+        op.failed = true;
+        op.finished = true;
+        return;
+    }
+    submitted.push_back(&op);
+    waiter.wake();
+    changed.notify_all();
+}
+
+bool SessionReactor::wait(ReactorOperation& op) {
+    std::unique_lock<std::mutex> lock(mutex);
+    changed.wait(lock, [&op] { return op.finished; });
+    return !op.failed;
+}
+
+void SessionReactor::wake() {
+    waiter.wake();
+}
+
+void SessionReactor::pause() {
+    pauseMutex.lock();
+    std::unique_lock<std::mutex> lock(mutex);
+    pausePending = true;
+    waiter.wake();
+    changed.notify_all();
+    changed.wait(lock, [this] { return paused || stopping; });
+}
+
+void SessionReactor::resume() {
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        pausePending = false;
+    }
+    changed.notify_all();
+    pauseMutex.unlock();
+}
+
+bool SessionReactor::mayCall(ReactorOperation& op, ReactorLane lane) const {
+    // Un paquet partiellement envoyé doit être terminé par son émetteur
+    if (transportOwner && transportOwner != &op) return false;
+
+    ReactorOperation* owner = laneOwner[(int)lane];
+    if (lane != ReactorLane::None && owner && owner != &op) return false;
+
+    // Pause demandée : seuls les appels déjà commencés peuvent continuer
+    if (pauseRequested && owner != &op && transportOwner != &op) return false;
+    return true;
+}
+
+void SessionReactor::afterCall(ReactorOperation& op, ReactorLane lane, bool again) {
+    op.wouldBlock = again;
+    if (lane != ReactorLane::None) {
+        laneOwner[(int)lane] = again ? &op : nullptr;
+    }
+
+    int directions = again ? libssh2_session_block_directions(sshSession) : 0;
+    if (directions & LIBSSH2_SESSION_BLOCK_OUTBOUND) {
+        transportOwner = &op;
+    } else if (transportOwner == &op) {
+        transportOwner = nullptr;
+    }
+    blockedDirections |= directions;
+}
+
+bool SessionReactor::quiescent() const {
+    if (transportOwner) return false;
+    for (ReactorOperation* owner : laneOwner) {
+        if (owner) return false;
+    }
+    return true;
+}
+
+void SessionReactor::loop() {
+    std::unique_lock<std::mutex> lock(mutex);
+    while (!stopping) {
+        active.splice(active.end(), submitted);
+        pauseRequested = pausePending;
+
+        // Pause demandée et plus aucun appel interrompu : rendre la session
+        if (pausePending && quiescent()) {
+            libssh2_session_set_blocking(sshSession, 1);
+            paused = true;
+            changed.notify_all();
+            changed.wait(lock, [this] { return !pausePending || stopping; });
+            paused = false;
+            if (stopping) break;
+            libssh2_session_set_blocking(sshSession, 0);
+            continue;
+        }
+
+        if (active.empty()) {
+            changed.wait(lock, [this] { return stopping || pausePending || !submitted.empty(); });
+            continue;
+        }
+        lock.unlock();
+
+        // Un tour : chaque opération avance jusqu'à devoir attendre le socket
+        bool progressed = false;
+        uint64_t receivedBefore = received.load();
+        blockedDirections = 0;
+        std::vector<ReactorOperation*> completed;
+
+        for (auto it = active.begin(); it != active.end();) {
+            ReactorOperation* op = *it;
+            ReactorOperation::Status status = op->step(*this);
+            if (status == ReactorOperation::Status::Done ||
+                status == ReactorOperation::Status::Failed) {
+                for (ReactorOperation*& owner : laneOwner) {
+                    if (owner == op) owner = nullptr;
+                }
+                if (transportOwner == op) transportOwner = nullptr;
+                op->failed = status == ReactorOperation::Status::Failed;
+                completed.push_back(op);
+                it = active.erase(it);
+                progressed = true;
+                continue;
+            }
+            if (status == ReactorOperation::Status::Progressed) {
+                progressed = true;
+            }
+            ++it;
+        }
+
+        bool drained = pauseRequested && quiescent();
+        if (!progressed && !drained && received.load() == receivedBefore && !active.empty()) {
+            waiter.wait(blockedDirections, 100);
+        }
+
+        lock.lock();
+        for (ReactorOperation* op : completed) {
+            op->finished = true;
+        }
+        if (!completed.empty()) {
+            changed.notify_all();
+        }
+    }
+
+    // Arrêt : les opérations restantes échouent
+    active.splice(active.end(), submitted);
+    for (ReactorOperation* op : active) {
+        op->error = "Session closed";
+        op->failed = true;
+        op->finished = true;
+    }
+    active.clear();
+    changed.notify_all();
+}
+
+// MARK: - ExecOperation
+
+ExecOperation::ExecOperation(const std::string& command, size_t bufferSize)
+    : command(command), buffer(BufferPool::shared().acquire(bufferSize)) {}
+
+ReactorOperation::Status ExecOperation::step(SessionReactor& reactor) {
+    bool progressed = false;
+    auto waiting = [&progressed] { return progressed ? Status::Progressed : Status::Blocked; };
+
+    while (true) {
+        switch (state) {
+        case State::Open:
+            channel = reactor.call(*this, ReactorLane::ChannelOpen, [&] {
+                return libssh2_channel_open_session(reactor.session());
+            });
+            if (!channel) {
+                if (wouldBlock) return waiting();
+                error = "Failed to open SSH channel";
+                return Status::Failed;
+            }
+            state = State::Exec;
+            break;
+
+        case State::Exec: {
+            int rc = reactor.call(*this, ReactorLane::None, [&] {
+                return libssh2_channel_exec(channel, command.c_str());
+            });
+            if (rc == LIBSSH2_ERROR_EAGAIN) return waiting();
+            if (rc != 0) {
+                error = "Failed to execute command: " + command;
+                ok = false;
+                state = State::Free;
+                break;
+            }
+            state = State::Read;
+            break;
+        }
+
+        case State::Read: {
+            if (cancel && cancel->load()) {
+                error = "Command cancelled";
+                ok = false;
+                state = State::Signal;
+                break;
+            }
+
+            // stdout et stderr lus en alternance
+            bool gotData = false;
+
+            if (!stdoutEof) {
+                ssize_t nread = reactor.call(*this, ReactorLane::None, [&] {
+                    return libssh2_channel_read(channel, buffer.data(), buffer.size());
+                });
+                if (nread > 0) {
+                    if (!onStdout) {
+                        output.append(buffer.data(), nread);
+                    } else if (!onStdout(buffer.data(), nread)) {
+                        state = State::Signal;
+                        break;
+                    }
+                    gotData = true;
+                } else if (nread == 0) {
+                    stdoutEof = true;
+                } else if (nread != LIBSSH2_ERROR_EAGAIN) {
+                    error = "Read error on SSH channel";
+                    ok = false;
+                    state = State::Close;
+                    break;
+                }
+            }
+
+            if (!stderrEof) {
+                ssize_t nread = reactor.call(*this, ReactorLane::None, [&] {
+                    return libssh2_channel_read_stderr(channel, buffer.data(), buffer.size());
+                });
+                if (nread > 0) {
+                    if (!onStderr) {
+                        errorOutput.append(buffer.data(), nread);
+                    } else if (!onStderr(buffer.data(), nread)) {
+                        state = State::Signal;
+                        break;
+                    }
+                    gotData = true;
+                } else if (nread == 0) {
+                    stderrEof = true;
+                } else if (nread != LIBSSH2_ERROR_EAGAIN) {
+                    error = "Read error on SSH channel";
+                    ok = false;
+                    state = State::Close;
+                    break;
+                }
+            }
+
+            if (stdoutEof && stderrEof) {
+                state = State::Close;
+            } else if (!gotData) {
+                return waiting();
+            }
+            break;
+        }
+
+        case State::Signal: {
+            // Sans effet si le serveur ignore les signaux : la fermeture suffit
+            int rc = reactor.call(*this, ReactorLane::None, [&] {
+                return libssh2_channel_signal(channel, "TERM");
+            });
+            if (rc == LIBSSH2_ERROR_EAGAIN) return waiting();
+            state = State::Close;
+            break;
+        }
+
+        case State::Close: {
+            int rc = reactor.call(*this, ReactorLane::None, [&] {
+                return libssh2_channel_close(channel);
+            });
+            if (rc == LIBSSH2_ERROR_EAGAIN) return waiting();
+            exitStatus = libssh2_channel_get_exit_status(channel);
+            state = State::Free;
+            break;
+        }
+
+        case State::Free: {
+            int rc = reactor.call(*this, ReactorLane::None, [&] {
+                return libssh2_channel_free(channel);
+            });
+            if (rc == LIBSSH2_ERROR_EAGAIN) return waiting();
+            channel = nullptr;
+            state = State::Finished;
+            break;
+        }
+
+        case State::Finished:
+            return ok ? Status::Done : Status::Failed;
+        }
+        progressed = true;
+    }
+}
+
+// MARK: - ShellOperation
+
+ShellOperation::ShellOperation(SessionReactor& reactor, LIBSSH2_CHANNEL* channel,
+                               Output onOutput, Closed onClosed)
+    : owner(reactor), channel(channel), onOutput(std::move(onOutput)),
+      onClosed(std::move(onClosed)), buffer(BufferPool::shared().acquire(BufferPool::packetSize)) {}
+
+void ShellOperation::write(const char* data, size_t length) {
+    {
+        std::lock_guard<std::mutex> lock(inputMutex);
+        input.append(data, length);
+    }
+    owner.wake();
+}
+
+void ShellOperation::resize(unsigned newColumns, unsigned newRows) {
+    columns = newColumns;
+    rows = newRows;
+    resizePending = true;
+    owner.wake();
+}
+
+void ShellOperation::close() {
+    closing = true;
+    owner.wake();
+}
+
+ReactorOperation::Status ShellOperation::step(SessionReactor& reactor) {
+    bool progressed = false;
+    auto waiting = [&progressed] { return progressed ? Status::Progressed : Status::Blocked; };
+
+    while (true) {
+        switch (state) {
+        case State::Pump: {
+            if (closing) {
+                state = State::Close;
+                break;
+            }
+
+            if (resizePending.exchange(false)) {
+                int rc = reactor.call(*this, ReactorLane::None, [&] {
+                    return libssh2_channel_request_pty_size(channel, columns.load(), rows.load());
+                });
+                if (rc == LIBSSH2_ERROR_EAGAIN) {
+                    resizePending = true;
+                    return waiting();
+                }
+            }
+
+            // Entrée d'abord : une touche part au premier tour
+            bool gotData = false;
+            if (sent == sending.size()) {
+                sending.clear();
+                sent = 0;
+                std::lock_guard<std::mutex> lock(inputMutex);
+                sending.swap(input);
+            }
+            if (sent < sending.size()) {
+                ssize_t written = reactor.call(*this, ReactorLane::None, [&] {
+                    return libssh2_channel_write(channel, sending.data() + sent,
+                                                 sending.size() - sent);
+                });
+                if (written > 0) {
+                    sent += written;
+                    gotData = true;
+                } else if (written != LIBSSH2_ERROR_EAGAIN) {
+                    error = "Write error on SSH channel";
+                    ok = false;
+                    state = State::Close;
+                    break;
+                }
+            }
+
+            // Le pseudo-terminal mêle déjà stderr à stdout ; stderr est tout
+            // de même vidé pour ne pas bloquer la fenêtre du canal
+            bool eof = false;
+            for (int stream = 0; stream < 2 && ok; ++stream) {
+                ssize_t nread = reactor.call(*this, ReactorLane::None, [&] {
+                    return libssh2_channel_read_ex(channel, stream ? SSH_EXTENDED_DATA_STDERR : 0,
+                                                   buffer.data(), buffer.size());
+                });
+                if (nread > 0) {
+                    onOutput(buffer.data(), nread);
+                    gotData = true;
+                } else if (nread == 0) {
+                    eof = eof || stream == 0;
+                } else if (nread != LIBSSH2_ERROR_EAGAIN) {
+                    error = "Read error on SSH channel";
+                    ok = false;
+                }
+            }
+
+            if (!ok || eof) {
+                state = State::Close;
+            } else if (!gotData) {
+                return waiting();
+            }
+            break;
+        }
+
+        case State::Close: {
+            int rc = reactor.call(*this, ReactorLane::None, [&] {
+                return libssh2_channel_close(channel);
+            });
+            if (rc == LIBSSH2_ERROR_EAGAIN) return waiting();
+            exitStatus = libssh2_channel_get_exit_status(channel);
+            state = State::Free;
+            break;
+        }
+
+        case State::Free: {
+            int rc = reactor.call(*this, ReactorLane::None, [&] {
+                return libssh2_channel_free(channel);
+            });
+            if (rc == LIBSSH2_ERROR_EAGAIN) return waiting();
+            channel = nullptr;
+            open = false;
+            if (onClosed) onClosed(exitStatus);
+            state = State::Finished;
+            break;
+        }
+
+        case State::Finished:
+            return ok ? Status::Done : Status::Failed;
+        }
+        progressed = true;
+    }
+}
+
+// MARK: - SftpListOperation
+
+SftpListOperation::SftpListOperation(LIBSSH2_SFTP* sftp, const std::string& path, Visitor visitor)
+    : sftp(sftp), path(path), visitor(std::move(visitor)) {}
+
+ReactorOperation::Status SftpListOperation::step(SessionReactor& reactor) {
+    bool progressed = false;
+    auto waiting = [&progressed] { return progressed ? Status::Progressed : Status::Blocked; };
+
+    while (true) {
+        switch (state) {
+        case State::Open:
+            handle = reactor.call(*this, ReactorLane::SftpOpen, [&] {
+                return libssh2_sftp_opendir(sftp, path.c_str());
+            });
+            if (!handle) {
+                if (wouldBlock) return waiting();
+                error = "Failed to open directory: " + path;
+                return Status::Failed;
+            }
+            state = State::Read;
+            break;
+
+        case State::Read: {
+            char name[512];
+            LIBSSH2_SFTP_ATTRIBUTES attrs;
+            int rc = reactor.call(*this, ReactorLane::SftpReaddir, [&] {
+                return libssh2_sftp_readdir(handle, name, sizeof(name), &attrs);
+            });
+            if (rc == LIBSSH2_ERROR_EAGAIN) return waiting();
+            if (rc > 0) {
+                if (!visitor(name, attrs)) state = State::Close;
+            } else {
+                if (rc < 0) {
+                    error = "Failed to read directory: " + path;
+                    ok = false;
+                }
+                state = State::Close;
+            }
+            break;
+        }
+
+        case State::Close: {
+            int rc = reactor.call(*this, ReactorLane::SftpClose, [&] {
+                return libssh2_sftp_closedir(handle);
+            });
+            if (rc == LIBSSH2_ERROR_EAGAIN) return waiting();
+            handle = nullptr;
+            state = State::Finished;
+            break;
+        }
+
+        case State::Finished:
+            return ok ? Status::Done : Status::Failed;
+        }
+        progressed = true;
+    }
+}
+
+// MARK: - SftpDownloadOperation
+
+SftpDownloadOperation::SftpDownloadOperation(LIBSSH2_SFTP* sftp, const std::string& remotePath,
+                                             int fd, size_t bufferSize, Progress progress)
+    : sftp(sftp), remotePath(remotePath), fd(fd),
+      buffer(BufferPool::shared().acquire(bufferSize)), writer(fd),
+      progress(std::move(progress)) {}
+
+ReactorOperation::Status SftpDownloadOperation::step(SessionReactor& reactor) {
+    bool progressed = false;
+    auto waiting = [&progressed] { return progressed ? Status::Progressed : Status::Blocked; };
+
+    while (true) {
+        switch (state) {
+        case State::Open:
+            handle = reactor.call(*this, ReactorLane::SftpOpen, [&] {
+                return libssh2_sftp_open(sftp, remotePath.c_str(), LIBSSH2_FXF_READ, 0);
+            });
+            if (!handle) {
+                if (wouldBlock) return waiting();
+                error = "Cannot open remote file: " + remotePath;
+                return Status::Failed;
+            }
+            state = State::Stat;
+            break;
+
+        case State::Stat: {
+            LIBSSH2_SFTP_ATTRIBUTES attrs;
+            int rc = reactor.call(*this, ReactorLane::SftpFstat, [&] {
+                return libssh2_sftp_fstat(handle, &attrs);
+            });
+            if (rc == LIBSSH2_ERROR_EAGAIN) return waiting();
+            if (rc == 0 && (attrs.flags & LIBSSH2_SFTP_ATTR_SIZE)) {
+                totalSize = attrs.filesize;
+                LocalFileWriter::prepare(fd, totalSize, uncached);
+            }
+            state = State::Read;
+            break;
+        }
+
+        case State::Read: {
+            // Aucun appel en cours ici : la voie reste libre pendant l'attente
+            if (owed > 0 && !throttle->tryConsume(owed)) return waiting();
+            owed = 0;
+            ssize_t nread = reactor.call(*this, ReactorLane::SftpRead, [&] {
+                return libssh2_sftp_read(handle, buffer.data(), buffer.size());
+            });
+            if (nread == LIBSSH2_ERROR_EAGAIN) return waiting();
+            if (nread <= 0) {
+                if (nread < 0) {
+                    error = "Read error during download at offset " + std::to_string(transferred);
+                    ok = false;
+                }
+                if (!writer.finish() && ok) {
+                    error = "Write error during download";
+                    ok = false;
+                }
+                state = State::Close;
+                break;
+            }
+
+            if (!writer.write(transferred, buffer.data(), nread)) {
+                error = "Write error during download";
+                ok = false;
+                state = State::Close;
+                break;
+            }
+            transferred += nread;
+            if (throttle) owed += nread;
+            if (progress) {
+                progress(transferred, totalSize);
+            }
+            break;
+        }
+
+        case State::Close: {
+            int rc = reactor.call(*this, ReactorLane::SftpClose, [&] {
+                return libssh2_sftp_close(handle);
+            });
+            if (rc == LIBSSH2_ERROR_EAGAIN) return waiting();
+            handle = nullptr;
+            state = State::Finished;
+            break;
+        }
+
+        case State::Finished:
+            return ok ? Status::Done : Status::Failed;
+        }
+        progressed = true;
+    }
+}
+
+// MARK: - SftpUploadOperation
+
+SftpUploadOperation::SftpUploadOperation(LIBSSH2_SFTP* sftp, const std::string& remotePath, int fd,
+                                         uint64_t totalSize, size_t bufferSize, Progress progress)
+    : sftp(sftp), remotePath(remotePath), fd(fd), totalSize(totalSize), window(bufferSize),
+      reader(fd), progress(std::move(progress)) {
+    if (!reader.isMapped()) buffer = BufferPool::shared().acquire(window);
+}
+
+// Lecture anticipée : le tampon commence toujours au premier octet non acquitté
+bool SftpUploadOperation::fill() {
+    size_t capacity = buffer.size();
+    if (!eof && head >= capacity / 2) {
+        memmove(buffer.data(), buffer.data() + head, tail - head);
+        tail -= head;
+        head = 0;
+    }
+    while (!eof && capacity - tail >= capacity / 4) {
+        ssize_t nread = reader.read(acked + tail - head, buffer.data() + tail, capacity - tail);
+        if (nread < 0) {
+            error = "Read error on local file at offset " + std::to_string(acked + (tail - head));
+            return false;
+        }
+        if (nread == 0) {
+            eof = true;
+            break;
+        }
+        tail += nread;
+    }
+    return true;
+}
+
+ReactorOperation::Status SftpUploadOperation::step(SessionReactor& reactor) {
+    bool progressed = false;
+    auto waiting = [&progressed] { return progressed ? Status::Progressed : Status::Blocked; };
+
+    while (true) {
+        switch (state) {
+        case State::Open:
+            handle = reactor.call(*this, ReactorLane::SftpOpen, [&] {
+                return libssh2_sftp_open(sftp, remotePath.c_str(),
+                                         LIBSSH2_FXF_WRITE | LIBSSH2_FXF_CREAT | LIBSSH2_FXF_TRUNC,
+                                         LIBSSH2_SFTP_S_IRUSR | LIBSSH2_SFTP_S_IWUSR |
+                                         LIBSSH2_SFTP_S_IRGRP | LIBSSH2_SFTP_S_IROTH);
+            });
+            if (!handle) {
+                if (wouldBlock) return waiting();
+                error = "Cannot create remote file: " + remotePath;
+                return Status::Failed;
+            }
+            state = State::Write;
+            break;
+
+        case State::Write: {
+            const char* data;
+            size_t length;
+            if (reader.isMapped()) {
+                uint64_t left = acked < reader.size() ? reader.size() - acked : 0;
+                length = (size_t)std::min<uint64_t>(window, left);
+                data = left ? reader.view(acked, length) : nullptr;
+                if (left && !data) {
+                    error = "Local file shrank during upload at offset " + std::to_string(acked);
+                    ok = false;
+                    state = State::Close;
+                    break;
+                }
+            } else {
+                if (!fill()) {
+                    ok = false;
+                    state = State::Close;
+                    break;
+                }
+                data = buffer.data() + head;
+                length = tail - head;
+            }
+            if (length == 0) {
+                state = State::Close;
+                break;
+            }
+            if (owed > 0 && !throttle->tryConsume(owed)) return waiting();
+            owed = 0;
+            ssize_t written = reactor.call(*this, ReactorLane::SftpWrite, [&] {
+                return libssh2_sftp_write(handle, data, length);
+            });
+            if (written == LIBSSH2_ERROR_EAGAIN) return waiting();
+            if (written < 0) {
+                error = "Write error during upload at offset " + std::to_string(acked) +
+                        " (SFTP status " + std::to_string(libssh2_sftp_last_error(sftp)) + ")";
+                ok = false;
+                state = State::Close;
+                break;
+            }
+            if (!reader.isMapped()) head += written;
+            acked += written;
+            reader.release(acked);
+            if (throttle) owed += written;
+            if (progress) {
+                progress(acked, totalSize);
+            }
+            break;
+        }
+
+        case State::Close: {
+            int rc = reactor.call(*this, ReactorLane::SftpClose, [&] {
+                return libssh2_sftp_close(handle);
+            });
+            if (rc == LIBSSH2_ERROR_EAGAIN) return waiting();
+            if (rc != 0 && ok) {
+                error = "Failed to close remote file: " + remotePath;
+                ok = false;
+            }
+            handle = nullptr;
+            state = State::Finished;
+            break;
+        }
+
+        case State::Finished:
+            return ok ? Status::Done : Status::Failed;
+        }
+        progressed = true;
+    }
+}
+
+} // namespace SCPClient
@@ -0,0 +1,342 @@
+//
+//  SessionReactor.h
+//  SCP Client for macOS
+//
+//  Boucle d'événements non bloquante : un thread pilote toutes les opérations
+//  (handles SFTP, canaux exec) d'une session libssh2 sur son unique socket
+//
+
+#ifndef SessionReactor_h
+#define SessionReactor_h
+
+#include <libssh2.h>
+#include <libssh2_sftp.h>
+#include "TransferScheduler.h"
+#include "LocalFileReader.h"
+#include "LocalFileWriter.h"
+#include "BufferPool.h"
+#include <atomic>
+#include <condition_variable>
+#include <functional>
+#include <list>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <type_traits>
+#include <vector>
+
+namespace SCPClient {
+
+class SessionReactor;
+
+// Opération pilotée par le réacteur : step() avance autant que possible sans
+// bloquer, puis rend la main (Blocked) en attendant le socket
+class ReactorOperation {
+public:
+    enum class Status { Blocked, Progressed, Done, Failed };
+
+    virtual ~ReactorOperation() = default;
+    virtual Status step(SessionReactor& reactor) = 0;
+
+    std::string error;
+
+protected:
+    // Vrai si le dernier appel passé par SessionReactor::call a rendu EAGAIN
+    bool wouldBlock = false;
+
+private:
+    friend class SessionReactor;
+    bool finished = false;
+    bool failed = false;
+};
+
+// Fonctions libssh2 dont l'état non bloquant est partagé par la session ou
+// par l'instance SFTP : une seule opération à la fois peut être au milieu
+// d'un appel interrompu par EAGAIN
+enum class ReactorLane {
+    None,
+    ChannelOpen,
+    SftpOpen,
+    SftpClose,
+    SftpRead,
+    SftpWrite,
+    SftpReaddir,
+    SftpFstat,
+    Count
+};
+
+// Attente du socket : epoll sur Linux, kqueue sur macOS, plus un tube de
+// réveil pour les soumissions venant d'autres threads
+class SocketWaiter {
+public:
+    explicit SocketWaiter(int sock);
+    ~SocketWaiter();
+
+    // directions : LIBSSH2_SESSION_BLOCK_INBOUND / OUTBOUND
+    void wait(int directions, int timeoutMs);
+    void wake();
+
+private:
+    void drainWake();
+
+    int sock;
+    int pollFd = -1;
+    int wakePipe[2] = {-1, -1};
+};
+
+class SessionReactor {
+public:
+    // La session doit déjà être authentifiée ; elle passe en mode non bloquant
+    SessionReactor(LIBSSH2_SESSION* session, int sock);
+    ~SessionReactor();
+
+    // Arrête le thread (opérations en cours en échec) et rend la session en
+    // mode bloquant ; à appeler avant de libérer la session
+    void stop();
+
+    LIBSSH2_SESSION* session() const { return sshSession; }
+
+    // Soumet une opération et attend sa fin (depuis n'importe quel thread,
+    // sauf celui du réacteur ou un appelant qui l'a suspendu)
+    bool run(ReactorOperation& op);
+    // Opération de longue durée : start() la soumet sans attendre, wait()
+    // attend sa fin (mêmes restrictions que run)
+    void start(ReactorOperation& op);
+    bool wait(ReactorOperation& op);
+    // Réveille la boucle : une opération en cours a du nouveau à envoyer
+    void wake();
+
+    // Suspend le réacteur : la session repasse en mode bloquant pour
+    // l'appelant jusqu'à resume()
+    void pause();
+    void resume();
+
+    // Appel libssh2 depuis step() : retourne EAGAIN (ou nullptr) sans appeler
+    // si une autre opération occupe la même voie ou le transport
+    template <typename F>
+    auto call(ReactorOperation& op, ReactorLane lane, F&& fn) -> decltype(fn()) {
+        using Result = decltype(fn());
+        if (!mayCall(op, lane)) {
+            op.wouldBlock = true;
+            if constexpr (std::is_pointer<Result>::value) {
+                return nullptr;
+            } else {
+                return LIBSSH2_ERROR_EAGAIN;
+            }
+        }
+        Result result = fn();
+        bool again;
+        if constexpr (std::is_pointer<Result>::value) {
+            again = !result && libssh2_session_last_errno(sshSession) == LIBSSH2_ERROR_EAGAIN;
+        } else {
+            again = result == LIBSSH2_ERROR_EAGAIN;
+        }
+        afterCall(op, lane, again);
+        return result;
+    }
+
+private:
+    bool mayCall(ReactorOperation& op, ReactorLane lane) const;
+    void afterCall(ReactorOperation& op, ReactorLane lane, bool again);
+    bool quiescent() const;
+    void loop();
+
+    LIBSSH2_SESSION* sshSession;
+    SocketWaiter waiter;
+
+    // État du thread du réacteur
+    std::list<ReactorOperation*> active;
+    ReactorOperation* laneOwner[(int)ReactorLane::Count] = {};
+    ReactorOperation* transportOwner = nullptr;
+    int blockedDirections = 0;
+    bool pauseRequested = false;
+    std::atomic<uint64_t> received{0};   // octets lus sur le socket
+
+    // Partagé avec les autres threads
+    std::mutex mutex;
+    std::condition_variable changed;
+    std::list<ReactorOperation*> submitted;
+    bool pausePending = false;
+    bool paused = false;
+    bool stopping = false;
+    std::mutex pauseMutex;   // un seul appelant bloquant à la fois
+    std::thread thread;
+};
+
+// Les opérations referment toujours leurs ressources dans step() : après un
+// arrêt du réacteur, les handles restants sont libérés avec la session.
+
+// Commande exec : stdout et stderr lus au fil de l'eau, sans interblocage
+// quand la fenêtre stderr se remplit
+class ExecOperation : public ReactorOperation {
+public:
+    using Sink = std::function<bool(const char* data, size_t length)>;
+
+    // `bufferSize` : plus gros morceau lu d'un coup
+    explicit ExecOperation(const std::string& command,
+                           size_t bufferSize = BufferPool::packetSize);
+
+    Status step(SessionReactor& reactor) override;
+
+    // Sorties : accumulées dans output/errorOutput sauf si un sink est fourni ;
+    // un sink qui retourne false termine la commande (SIGTERM) et ferme le
+    // canal sans attendre la fin
+    Sink onStdout;
+    Sink onStderr;
+    std::string output;
+    std::string errorOutput;
+    int exitStatus = -1;
+    // Levé par un autre thread : SIGTERM à la commande, puis fermeture (échec)
+    const std::atomic<bool>* cancel = nullptr;
+
+private:
+    enum class State { Open, Exec, Read, Signal, Close, Free, Finished };
+
+    std::string command;
+    State state = State::Open;
+    LIBSSH2_CHANNEL* channel = nullptr;
+    BufferPool::Buffer buffer;
+    bool stdoutEof = false;
+    bool stderrEof = false;
+    bool ok = true;
+};
+
+// Shell interactif sur un canal déjà ouvert (pseudo-terminal et shell
+// demandés) : l'entrée est mise en file depuis n'importe quel thread et
+// envoyée au tour suivant du réacteur, la sortie passée au fil de l'eau à
+// onOutput depuis le thread du réacteur. onClosed reçoit le code de retour
+// quand le shell se termine ou que close() a fermé le canal.
+class ShellOperation : public ReactorOperation {
+public:
+    using Output = std::function<void(const char* data, size_t length)>;
+    using Closed = std::function<void(int exitStatus)>;
+
+    ShellOperation(SessionReactor& reactor, LIBSSH2_CHANNEL* channel,
+                   Output onOutput, Closed onClosed);
+
+    Status step(SessionReactor& reactor) override;
+
+    void write(const char* data, size_t length);
+    void resize(unsigned columns, unsigned rows);
+    // Ferme le canal (le shell reçoit SIGHUP) ; fin à attendre avec wait()
+    void close();
+    bool isOpen() const { return open; }
+
+private:
+    enum class State { Pump, Close, Free, Finished };
+
+    SessionReactor& owner;
+    LIBSSH2_CHANNEL* channel;
+    Output onOutput;
+    Closed onClosed;
+    State state = State::Pump;
+    BufferPool::Buffer buffer;
+
+    std::mutex inputMutex;
+    std::string input;       // en file, sous inputMutex
+    std::string sending;     // en cours d'envoi (thread du réacteur)
+    size_t sent = 0;
+    std::atomic<unsigned> columns{0};
+    std::atomic<unsigned> rows{0};
+    std::atomic<bool> resizePending{false};
+    std::atomic<bool> closing{false};
+    std::atomic<bool> open{true};
+    int exitStatus = -1;
+    bool ok = true;
+};
+
+// Lecture d'un répertoire SFTP ; chaque entrée est passée au visiteur, qui
+// retourne false pour arrêter la lecture
+class SftpListOperation : public ReactorOperation {
+public:
+    using Visitor = std::function<bool(const char* name, const LIBSSH2_SFTP_ATTRIBUTES& attrs)>;
+
+    SftpListOperation(LIBSSH2_SFTP* sftp, const std::string& path, Visitor visitor);
+
+    Status step(SessionReactor& reactor) override;
+
+private:
+    enum class State { Open, Read, Close, Finished };
+
+    LIBSSH2_SFTP* sftp;
+    std::string path;
+    Visitor visitor;
+    State state = State::Open;
+    LIBSSH2_SFTP_HANDLE* handle = nullptr;
+    bool ok = true;
+};
+
+// Téléchargement SFTP vers un descripteur local ; le tampon large laisse
+// libssh2 garder plusieurs READ en vol
+class SftpDownloadOperation : public ReactorOperation {
+public:
+    using Progress = std::function<void(uint64_t transferred, uint64_t total)>;
+
+    SftpDownloadOperation(LIBSSH2_SFTP* sftp, const std::string& remotePath, int fd,
+                          size_t bufferSize, Progress progress);
+
+    Status step(SessionReactor& reactor) override;
+
+    // Limitation de débit : au-delà, l'opération rend la main sans lire
+    std::shared_ptr<TransferScheduler::Transfer> throttle;
+    // Gros fichier écrit hors cache de pages (LocalFileWriter::prepare)
+    bool uncached = false;
+
+private:
+    enum class State { Open, Stat, Read, Close, Finished };
+
+    LIBSSH2_SFTP* sftp;
+    std::string remotePath;
+    int fd;
+    BufferPool::Buffer buffer;
+    LocalFileWriter writer;
+    Progress progress;
+    State state = State::Open;
+    LIBSSH2_SFTP_HANDLE* handle = nullptr;
+    uint64_t totalSize = 0;
+    uint64_t transferred = 0;
+    uint64_t owed = 0;   // octets pas encore décomptés par throttle
+    bool ok = true;
+};
+
+// Upload SFTP depuis un descripteur local, écritures acquittées de façon
+// asynchrone comme dans le chemin bloquant ; un gros fichier est envoyé
+// directement depuis sa projection en mémoire
+class SftpUploadOperation : public ReactorOperation {
+public:
+    using Progress = std::function<void(uint64_t transferred, uint64_t total)>;
+
+    SftpUploadOperation(LIBSSH2_SFTP* sftp, const std::string& remotePath, int fd,
+                        uint64_t totalSize, size_t bufferSize, Progress progress);
+
+    Status step(SessionReactor& reactor) override;
+
+    // Limitation de débit : au-delà, l'opération rend la main sans écrire
+    std::shared_ptr<TransferScheduler::Transfer> throttle;
+
+private:
+    enum class State { Open, Write, Close, Finished };
+
+    bool fill();
+
+    LIBSSH2_SFTP* sftp;
+    std::string remotePath;
+    int fd;
+    uint64_t totalSize;
+    size_t window;
+    LocalFileReader reader;
+    BufferPool::Buffer buffer;
+    Progress progress;
+    State state = State::Open;
+    LIBSSH2_SFTP_HANDLE* handle = nullptr;
+    size_t head = 0;
+    size_t tail = 0;
+    uint64_t acked = 0;
+    uint64_t owed = 0;
+    bool eof = false;
+    bool ok = true;
+};
+
+} // namespace SCPClient
+
+#endif /* SessionReactor_h */
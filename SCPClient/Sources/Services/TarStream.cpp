@@ -0,0 +1,302 @@
+//
+//  TarStream.cpp
+//  SCP Client for macOS
+//
+//  Implémentation de l'écriture et de la lecture tar en flux
+//
+
+#include "TarStream.h"
+#include <algorithm>
+#include <cstring>
+
+namespace SCPClient {
+
+// Champs de l'en-tête ustar (offsets POSIX)
+static const size_t nameOffset = 0, nameLength = 100;
+static const size_t modeOffset = 100;
+static const size_t uidOffset = 108;
+static const size_t gidOffset = 116;
+static const size_t sizeOffset = 124, sizeLength = 12;
+static const size_t mtimeOffset = 136, mtimeLength = 12;
+static const size_t checksumOffset = 148;
+static const size_t typeOffset = 156;
+static const size_t magicOffset = 257;
+static const size_t prefixOffset = 345, prefixLength = 155;
+
+static const uint64_t maxOctal11 = 077777777777ull;
+
+static void putOctal(char* field, size_t length, uint64_t value) {
+    // length - 1 chiffres suivis d'un NUL
+    field[length - 1] = '\0';
+    for (size_t i = length - 1; i > 0; --i) {
+        field[i - 1] = (char)('0' + (value & 7));
+        value >>= 3;
+    }
+}
+
+static uint64_t getNumber(const char* field, size_t length) {
+    // Extension GNU : base 256 si le bit de poids fort est posé
+    if ((unsigned char)field[0] & 0x80) {
+        uint64_t value = (unsigned char)field[0] & 0x7f;
+        for (size_t i = 1; i < length; ++i) {
+            value = (value << 8) | (unsigned char)field[i];
+        }
+        return value;
+    }
+    uint64_t value = 0;
+    for (size_t i = 0; i < length; ++i) {
+        char c = field[i];
+        if (c == ' ' && value == 0) continue;
+        if (c < '0' || c > '7') break;
+        value = (value << 3) | (uint64_t)(c - '0');
+    }
+    return value;
+}
+
+static std::string getString(const char* field, size_t length) {
+    return std::string(field, strnlen(field, length));
+}
+
+static unsigned checksum(const char* header) {
+    unsigned sum = 0;
+    for (size_t i = 0; i < TarWriter::blockSize; ++i) {
+        bool inChecksum = i >= checksumOffset && i < checksumOffset + 8;
+        sum += inChecksum ? ' ' : (unsigned char)header[i];
+    }
+    return sum;
+}
+
+// Enregistrement pax "<longueur> <clé>=<valeur>\n", longueur incluse
+static std::string paxRecord(const std::string& key, const std::string& value) {
+    size_t body = key.size() + value.size() + 3;   // espace, '=', '\n'
+    size_t length = body + 1;
+    while (std::to_string(length).size() + body != length) ++length;
+    return std::to_string(length) + " " + key + "=" + value + "\n";
+}
+
+static std::string rawHeader(const std::string& name, uint64_t size, uint32_t mode,
+                             int64_t mtime, char type) {
+    std::string header(TarWriter::blockSize, '\0');
+    char* h = &header[0];
+
+    memcpy(h + nameOffset, name.data(), std::min(name.size(), nameLength));
+    putOctal(h + modeOffset, 8, mode & 07777);
+    putOctal(h + uidOffset, 8, 0);
+    putOctal(h + gidOffset, 8, 0);
+    putOctal(h + sizeOffset, sizeLength, std::min(size, maxOctal11));
+    putOctal(h + mtimeOffset, mtimeLength, (uint64_t)std::max<int64_t>(0, std::min<int64_t>(mtime, maxOctal11)));
+    h[typeOffset] = type;
+    memcpy(h + magicOffset, "ustar\0" "00", 8);
+
+    putOctal(h + checksumOffset, 7, checksum(h));
+    h[checksumOffset + 7] = ' ';
+    return header;
+}
+
+// MARK: - TarWriter
+
+std::string TarWriter::header(const TarEntry& entry) {
+    std::string name = entry.name;
+    if (entry.type == '5' && (name.empty() || name.back() != '/')) {
+        name += '/';
+    }
+
+    std::string pax;
+    if (name.size() > nameLength) pax += paxRecord("path", name);
+    if (entry.size > maxOctal11) pax += paxRecord("size", std::to_string(entry.size));
+
+    std::string result;
+    if (!pax.empty()) {
+        result = rawHeader("PaxHeader", pax.size(), 0644, entry.mtime, 'x');
+        result += pax;
+        result.append(padding(pax.size()), '\0');
+    }
+    result += rawHeader(name, entry.size, entry.mode, entry.mtime, entry.type);
+    return result;
+}
+
+size_t TarWriter::padding(uint64_t size) {
+    return (size_t)((blockSize - size % blockSize) % blockSize);
+}
+
+std::string TarWriter::trailer() {
+    return std::string(2 * blockSize, '\0');
+}
+
+// MARK: - TarReader
+
+TarReader::TarReader(EntryStart onStart, EntryData onData, EntryEnd onEnd)
+    : onStart(std::move(onStart)), onData(std::move(onData)), onEnd(std::move(onEnd)) {
+    block.reserve(TarWriter::blockSize);
+}
+
+bool TarReader::feed(const char* data, size_t length) {
+    while (length > 0) {
+        switch (state) {
+        case State::Header: {
+            size_t take = std::min(length, TarWriter::blockSize - block.size());
+            block.append(data, take);
+            data += take;
+            length -= take;
+            if (block.size() == TarWriter::blockSize) {
+                bool ok = parseHeader();
+                block.clear();
+                if (!ok) return false;
+            }
+            break;
+        }
+
+        case State::Data: {
+            size_t take = (size_t)std::min<uint64_t>(length, remaining);
+            if (!skipping && !onData(data, take)) {
+                error = "Transfer cancelled";
+                return false;
+            }
+            data += take;
+            length -= take;
+            remaining -= take;
+            if (remaining == 0) {
+                if (!onEnd()) {
+                    error = "Transfer cancelled";
+                    return false;
+                }
+                state = paddingLeft ? State::Padding : State::Header;
+            }
+            break;
+        }
+
+        case State::Extended: {
+            size_t take = (size_t)std::min<uint64_t>(length, remaining);
+            extended.append(data, take);
+            data += take;
+            length -= take;
+            remaining -= take;
+            if (remaining == 0) {
+                if (extendedType == 'x') {
+                    parsePax(extended);
+                } else if (extendedType == 'L') {
+                    nextName = std::string(extended.c_str());
+                }
+                state = paddingLeft ? State::Padding : State::Header;
+            }
+            break;
+        }
+
+        case State::Padding: {
+            size_t take = (size_t)std::min<uint64_t>(length, paddingLeft);
+            data += take;
+            length -= take;
+            paddingLeft -= take;
+            if (paddingLeft == 0) state = State::Header;
+            break;
+        }
+
+        case State::Done:
+            // Blocs de remplissage après la fin de l'archive
+            return true;
+        }
+    }
+    return true;
+}
+
+bool TarReader::parseHeader() {
+    const char* h = block.data();
+
+    // Bloc nul : fin d'archive
+    if (std::all_of(block.begin(), block.end(), [](char c) { return c == '\0'; })) {
+        state = State::Done;
+        return true;
+    }
+
+    if (getNumber(h + checksumOffset, 8) != checksum(h)) {
+        error = "Corrupt tar header";
+        return false;
+    }
+
+    char type = h[typeOffset];
+    uint64_t size = getNumber(h + sizeOffset, sizeLength);
+
+    // En-têtes étendus : s'appliquent à l'entrée suivante
+    if (type == 'x' || type == 'L' || type == 'g' || type == 'K') {
+        extendedType = type;
+        extended.clear();
+        remaining = size;
+        paddingLeft = TarWriter::padding(size);
+        state = size ? State::Extended : State::Header;
+        if (type == 'g' || type == 'K') extendedType = 0;
+        return true;
+    }
+
+    TarEntry entry;
+    if (!nextName.empty()) {
+        entry.name = nextName;
+    } else {
+        entry.name = getString(h + nameOffset, nameLength);
+        if (memcmp(h + magicOffset, "ustar", 5) == 0) {
+            std::string prefix = getString(h + prefixOffset, prefixLength);
+            if (!prefix.empty()) entry.name = prefix + "/" + entry.name;
+        }
+    }
+    entry.size = hasNextSize ? nextSize : size;
+    entry.mode = (uint32_t)getNumber(h + modeOffset, 8);
+    entry.mtime = (int64_t)getNumber(h + mtimeOffset, mtimeLength);
+    entry.type = type == '\0' ? '0' : type;
+
+    nextName.clear();
+    hasNextSize = false;
+
+    // Normaliser : "./a/b/" -> "a/b"
+    while (entry.name.compare(0, 2, "./") == 0) entry.name.erase(0, 2);
+    while (!entry.name.empty() && entry.name.back() == '/') entry.name.pop_back();
+    if (entry.name == ".") entry.name.clear();
+
+    if (!onStart(entry)) {
+        error = "Transfer cancelled";
+        return false;
+    }
+
+    // Liens, répertoires et fichiers spéciaux n'ont pas de contenu ; celui
+    // des types inconnus est sauté
+    bool regular = entry.type == '0' || entry.type == '7';
+    uint64_t dataSize = strchr("123456", entry.type) ? 0 : entry.size;
+    skipping = !regular;
+    remaining = dataSize;
+    paddingLeft = TarWriter::padding(dataSize);
+
+    if (dataSize == 0) {
+        if (!onEnd()) {
+            error = "Transfer cancelled";
+            return false;
+        }
+        state = State::Header;
+    } else {
+        state = State::Data;
+    }
+    return true;
+}
+
+void TarReader::parsePax(const std::string& records) {
+    size_t pos = 0;
+    while (pos < records.size()) {
+        size_t space = records.find(' ', pos);
+        if (space == std::string::npos) break;
+        size_t length = strtoull(records.c_str() + pos, nullptr, 10);
+        if (length == 0 || pos + length > records.size()) break;
+
+        std::string record = records.substr(space + 1, pos + length - space - 2);
+        size_t equals = record.find('=');
+        if (equals != std::string::npos) {
+            std::string key = record.substr(0, equals);
+            std::string value = record.substr(equals + 1);
+            if (key == "path") {
+                nextName = value;
+            } else if (key == "size") {
+                nextSize = strtoull(value.c_str(), nullptr, 10);
+                hasNextSize = true;
+            }
+        }
+        pos += length;
+    }
+}
+
+} // namespace SCPClient
@@ -0,0 +1,82 @@
+//
+//  TarStream.h
+//  SCP Client for macOS
+//
+//  Archive tar (ustar + en-têtes pax) construite et lue à la volée, pour
+//  transférer des lots de petits fichiers sur un seul canal exec
+//
+
+#ifndef TarStream_h
+#define TarStream_h
+
+#include <cstdint>
+#include <functional>
+#include <string>
+
+namespace SCPClient {
+
+struct TarEntry {
+    std::string name;       // chemin relatif, sans "./" ni "/" final
+    uint64_t size = 0;
+    uint32_t mode = 0644;
+    int64_t mtime = 0;
+    char type = '0';        // '0' fichier, '5' répertoire, '2' lien, ...
+};
+
+// Construction : header() puis `size` octets de contenu, puis padding()
+class TarWriter {
+public:
+    static const size_t blockSize = 512;
+
+    // Un en-tête pax précède l'en-tête ustar si le nom ou la taille ne
+    // tiennent pas dans les champs fixes
+    static std::string header(const TarEntry& entry);
+    static size_t padding(uint64_t size);
+    static std::string trailer();
+};
+
+// Lecture incrémentale : feed() accepte des morceaux de taille quelconque,
+// tels qu'ils arrivent du canal
+class TarReader {
+public:
+    using EntryStart = std::function<bool(const TarEntry& entry)>;
+    using EntryData = std::function<bool(const char* data, size_t length)>;
+    using EntryEnd = std::function<bool()>;
+
+    TarReader(EntryStart onStart, EntryData onData, EntryEnd onEnd);
+
+    // false en cas d'archive invalide ou d'arrêt demandé par un callback
+    bool feed(const char* data, size_t length);
+    bool finished() const { return state == State::Done; }
+
+    std::string error;
+
+private:
+    enum class State { Header, Data, Padding, Extended, Done };
+
+    bool parseHeader();
+    void parsePax(const std::string& records);
+
+    EntryStart onStart;
+    EntryData onData;
+    EntryEnd onEnd;
+
+    State state = State::Header;
+    std::string block;         // en-tête en cours d'assemblage
+    std::string extended;      // contenu pax ou nom long GNU
+    char extendedType = 0;
+    uint64_t remaining = 0;
+    uint64_t paddingLeft = 0;
+    bool skipping = false;     // contenu d'une entrée ignorée
+
+    // Valeurs reportées sur l'entrée suivante
+    std::string nextName;
+    uint64_t nextSize = 0;
+    bool hasNextSize = false;
+
+    TarEntry current;
+};
+
+} // namespace SCPClient
+
+#endif /* TarStream_h */
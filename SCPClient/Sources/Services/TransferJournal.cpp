@@ -0,0 +1,181 @@
+//
+//  TransferJournal.cpp
+//  SCP Client for macOS
+//
+//  Implémentation du journal de reprise
+//
+
+#include "TransferJournal.h"
+#include "BufferPool.h"
+#include <openssl/evp.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <algorithm>
+#include <cerrno>
+#include <cstdio>
+#include <sstream>
+
+namespace SCPClient {
+
+TransferJournal::TransferJournal(uint64_t sourceSize, int64_t sourceMtime)
+    : sourceSize(sourceSize), sourceMtime(sourceMtime) {
+}
+
+std::string TransferJournal::pathFor(const std::string& destination) {
+    return destination + ".scpresume";
+}
+
+bool TransferJournal::parse(const std::string& text) {
+    std::istringstream in(text);
+    std::string line;
+    if (!std::getline(in, line) || line != "scp-resume 1") return false;
+
+    bool sourceSeen = false;
+    ranges.clear();
+    while (std::getline(in, line)) {
+        unsigned long long a, b;
+        long long mtime;
+        if (sscanf(line.c_str(), "source %llu %lld", &a, &mtime) == 2) {
+            sourceSize = a;
+            sourceMtime = mtime;
+            sourceSeen = true;
+        } else if (sscanf(line.c_str(), "range %llu %llu", &a, &b) == 2) {
+            if (a >= b || b > sourceSize) return false;
+            add(a, b);
+        } else if (!line.empty()) {
+            return false;
+        }
+    }
+    return sourceSeen;
+}
+
+std::string TransferJournal::serialize() const {
+    std::string text = "scp-resume 1\n";
+    text += "source " + std::to_string(sourceSize) + " " + std::to_string(sourceMtime) + "\n";
+    for (const JournalRange& range : ranges) {
+        text += "range " + std::to_string(range.start) + " " + std::to_string(range.end) + "\n";
+    }
+    return text;
+}
+
+bool TransferJournal::load(const std::string& path) {
+    int fd = open(path.c_str(), O_RDONLY);
+    if (fd < 0) return false;
+
+    std::string text;
+    BufferPool::Buffer buffer = BufferPool::shared().acquire(BufferPool::packetSize);
+    ssize_t nread;
+    while ((nread = read(fd, buffer.data(), buffer.size())) > 0) {
+        text.append(buffer.data(), nread);
+    }
+    close(fd);
+    return nread == 0 && parse(text);
+}
+
+bool TransferJournal::save(const std::string& path) const {
+    std::string temporary = path + ".tmp";
+    int fd = open(temporary.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    if (fd < 0) return false;
+
+    std::string text = serialize();
+    const char* data = text.data();
+    size_t left = text.size();
+    while (left > 0) {
+        ssize_t written = write(fd, data, left);
+        if (written < 0) {
+            if (errno == EINTR) continue;
+            close(fd);
+            unlink(temporary.c_str());
+            return false;
+        }
+        data += written;
+        left -= written;
+    }
+    close(fd);
+    return rename(temporary.c_str(), path.c_str()) == 0;
+}
+
+bool TransferJournal::sameSource(uint64_t size, int64_t mtime) const {
+    return sourceSize == size && sourceMtime == mtime;
+}
+
+void TransferJournal::add(uint64_t start, uint64_t end) {
+    if (start >= end) return;
+
+    // Première plage qui touche ou suit `start`
+    auto it = std::lower_bound(ranges.begin(), ranges.end(), start,
+                               [](const JournalRange& range, uint64_t value) { return range.end < value; });
+    auto last = it;
+    while (last != ranges.end() && last->start <= end) {
+        start = std::min(start, last->start);
+        end = std::max(end, last->end);
+        ++last;
+    }
+    it = ranges.erase(it, last);
+    ranges.insert(it, {start, end});
+}
+
+void TransferJournal::clip(uint64_t destinationSize) {
+    while (!ranges.empty() && ranges.back().start >= destinationSize) {
+        ranges.pop_back();
+    }
+    if (!ranges.empty() && ranges.back().end > destinationSize) {
+        ranges.back().end = destinationSize;
+    }
+}
+
+uint64_t TransferJournal::completed() const {
+    uint64_t total = 0;
+    for (const JournalRange& range : ranges) total += range.end - range.start;
+    return total;
+}
+
+std::vector<JournalRange> TransferJournal::missing() const {
+    std::vector<JournalRange> gaps;
+    uint64_t pos = 0;
+    for (const JournalRange& range : ranges) {
+        if (range.start > pos) gaps.push_back({pos, range.start});
+        pos = std::max(pos, range.end);
+    }
+    if (pos < sourceSize) gaps.push_back({pos, sourceSize});
+    return gaps;
+}
+
+bool sha256Range(int fd, uint64_t start, uint64_t length, std::string& hex) {
+    EVP_MD_CTX* context = EVP_MD_CTX_new();
+    if (!context || EVP_DigestInit_ex(context, EVP_sha256(), nullptr) != 1) {
+        EVP_MD_CTX_free(context);
+        return false;
+    }
+
+    BufferPool::Buffer buffer = BufferPool::shared().acquire(1024 * 1024);
+    uint64_t pos = start;
+    uint64_t end = start + length;
+    bool ok = true;
+    while (pos < end) {
+        size_t want = (size_t)std::min<uint64_t>(buffer.size(), end - pos);
+        ssize_t nread = pread(fd, buffer.data(), want, (off_t)pos);
+        if (nread < 0 && errno == EINTR) continue;
+        if (nread <= 0) {
+            ok = false;
+            break;
+        }
+        EVP_DigestUpdate(context, buffer.data(), nread);
+        pos += nread;
+    }
+
+    unsigned char digest[EVP_MAX_MD_SIZE];
+    unsigned int digestLength = 0;
+    ok = EVP_DigestFinal_ex(context, digest, &digestLength) == 1 && ok;
+    EVP_MD_CTX_free(context);
+
+    static const char digits[] = "0123456789abcdef";
+    hex.clear();
+    for (unsigned i = 0; i < digestLength; ++i) {
+        hex += digits[digest[i] >> 4];
+        hex += digits[digest[i] & 15];
+    }
+    return ok;
+}
+
+} // namespace SCPClient
@@ -0,0 +1,64 @@
+//
+//  TransferJournal.h
+//  SCP Client for macOS
+//
+//  Journal de reprise d'un transfert : identité de la source et plages déjà
+//  écrites dans la destination, conservé à côté de celle-ci
+//
+
+#ifndef TransferJournal_h
+#define TransferJournal_h
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace SCPClient {
+
+// Plage [start, end) présente dans la destination
+struct JournalRange {
+    uint64_t start;
+    uint64_t end;
+};
+
+// Format texte :
+//   scp-resume 1
+//   source <taille> <mtime>
+//   range <début> <fin>      (une ligne par plage)
+class TransferJournal {
+public:
+    TransferJournal() = default;
+    TransferJournal(uint64_t sourceSize, int64_t sourceMtime);
+
+    // Chemin du journal associé à une destination
+    static std::string pathFor(const std::string& destination);
+
+    bool parse(const std::string& text);
+    std::string serialize() const;
+
+    // Journal local : écrit dans un fichier temporaire puis renommé
+    bool load(const std::string& path);
+    bool save(const std::string& path) const;
+
+    bool sameSource(uint64_t size, int64_t mtime) const;
+
+    // Ajoute une plage (fusionnée avec ses voisines)
+    void add(uint64_t start, uint64_t end);
+    // Oublie ce qui dépasse la taille réelle de la destination
+    void clip(uint64_t destinationSize);
+
+    uint64_t completed() const;
+    // Plages restant à transférer dans [0, sourceSize)
+    std::vector<JournalRange> missing() const;
+
+    uint64_t sourceSize = 0;
+    int64_t sourceMtime = 0;
+    std::vector<JournalRange> ranges;   // triées et disjointes
+};
+
+// SHA-256 (hexadécimal) de [start, start + length) d'un fichier local
+bool sha256Range(int fd, uint64_t start, uint64_t length, std::string& hex);
+
+} // namespace SCPClient
+
+#endif /* TransferJournal_h */
@@ -0,0 +1,202 @@
+//
+//  TransferScheduler.cpp
+//  SCP Client for macOS
+//
+//  Implémentation de la limitation de débit
+//
+
+#include "TransferScheduler.h"
+#include <algorithm>
+
+namespace SCPClient {
+
+// Poids de partage par priorité
+static double priorityWeight(TransferPriority priority) {
+    switch (priority) {
+    case TransferPriority::Interactive: return 8;
+    case TransferPriority::Normal:      return 4;
+    case TransferPriority::Bulk:        return 1;
+    }
+    return 4;
+}
+
+// Rafale admise : 1/8 de seconde, au moins 32 Ko
+static double burstFor(double rate) {
+    return std::max(rate / 8, 32768.0);
+}
+
+void TransferScheduler::Bucket::setRate(double bytesPerSecond, Clock::time_point now) {
+    refill(now);
+    if (rate <= 0) tokens = burstFor(bytesPerSecond);
+    rate = bytesPerSecond;
+    tokens = std::min(tokens, burstFor(rate));
+    updated = now;
+}
+
+void TransferScheduler::Bucket::refill(Clock::time_point now) {
+    if (rate > 0) {
+        double elapsed = std::chrono::duration<double>(now - updated).count();
+        tokens = std::min(burstFor(rate), tokens + rate * elapsed);
+    }
+    updated = now;
+}
+
+TransferScheduler::Clock::duration TransferScheduler::Bucket::deficit() const {
+    if (rate <= 0 || tokens >= 0) return Clock::duration::zero();
+    return std::chrono::duration_cast<Clock::duration>(std::chrono::duration<double>(-tokens / rate));
+}
+
+TransferScheduler& TransferScheduler::shared() {
+    static TransferScheduler scheduler;
+    return scheduler;
+}
+
+void TransferScheduler::setGlobalLimit(uint64_t bytesPerSecond) {
+    std::lock_guard<std::mutex> lock(mutex);
+    global.setRate((double)bytesPerSecond, Clock::now());
+    updateLimited();
+    changed.notify_all();
+}
+
+void TransferScheduler::setHostLimit(const std::string& host, uint64_t bytesPerSecond) {
+    std::lock_guard<std::mutex> lock(mutex);
+    if (bytesPerSecond == 0) {
+        hosts.erase(host);
+    } else {
+        hosts[host].setRate((double)bytesPerSecond, Clock::now());
+    }
+    updateLimited();
+    changed.notify_all();
+}
+
+uint64_t TransferScheduler::getGlobalLimit() const {
+    std::lock_guard<std::mutex> lock(mutex);
+    return (uint64_t)global.rate;
+}
+
+void TransferScheduler::updateLimited() {
+    limited = global.limited() || !hosts.empty();
+}
+
+std::shared_ptr<TransferScheduler::Transfer> TransferScheduler::begin(const std::string& host,
+                                                                      TransferPriority priority,
+                                                                      uint64_t limit) {
+    std::shared_ptr<Transfer> transfer(new Transfer());
+    transfer->scheduler = this;
+    transfer->host = host;
+    transfer->weight = priorityWeight(priority);
+
+    std::lock_guard<std::mutex> lock(mutex);
+    transfer->id = nextId++;
+    transfer->lastGrant = Clock::now();
+    transfer->own.updated = transfer->lastGrant;
+    if (limit > 0) transfer->own.setRate((double)limit, transfer->lastGrant);
+    // Un nouveau transfert part du temps virtuel courant, sans crédit passé
+    transfer->lastFinish = virtualTime;
+    transfers.push_back(transfer.get());
+    return transfer;
+}
+
+// Délai accordé à un transfert en retard entre deux de ses blocs
+static const std::chrono::milliseconds turnGrace(20);
+
+// Sous verrou
+bool TransferScheduler::grant(Transfer& transfer, uint64_t bytes, Clock::duration& retry) {
+    Clock::time_point now = Clock::now();
+    retry = std::chrono::milliseconds(50);
+
+    transfer.own.refill(now);
+    if (transfer.own.tokens < 0) {
+        dequeue(transfer);
+        retry = transfer.own.deficit();
+        return false;
+    }
+
+    auto found = hosts.find(transfer.host);
+    Bucket* host = found == hosts.end() ? nullptr : &found->second;
+    if (global.limited() || host) {
+        global.refill(now);
+        if (host) host->refill(now);
+
+        if (!transfer.queued) {
+            transfer.tag = std::max(virtualTime, transfer.lastFinish);
+            transfer.queued = true;
+        }
+
+        Clock::duration wait = std::max(global.deficit(), host ? host->deficit() : Clock::duration::zero());
+        if (wait > Clock::duration::zero()) {
+            retry = wait;
+            return false;
+        }
+
+        // Un transfert plus en retard partage un seau avec celui-ci : son tour
+        for (Transfer* other : transfers) {
+            if (other == &transfer) continue;
+            bool shares = global.limited() || (host && other->host == transfer.host);
+            if (!shares) continue;
+            double otherTag = other->queued ? other->tag : std::max(virtualTime, other->lastFinish);
+            bool earlier = otherTag < transfer.tag ||
+                           (otherTag == transfer.tag && other->id < transfer.id);
+            if (!earlier) continue;
+            if (other->queued) return false;
+            Clock::duration idle = now - other->lastGrant;
+            if (idle < turnGrace) {
+                retry = turnGrace - idle;
+                return false;
+            }
+        }
+
+        transfer.queued = false;
+        virtualTime = transfer.tag;
+        transfer.lastFinish = transfer.tag + (double)bytes / transfer.weight;
+        if (global.limited()) global.tokens -= (double)bytes;
+        if (host) host->tokens -= (double)bytes;
+        changed.notify_all();
+    } else {
+        // Limites levées pendant l'attente
+        dequeue(transfer);
+    }
+
+    transfer.lastGrant = now;
+    if (transfer.own.limited()) transfer.own.tokens -= (double)bytes;
+    return true;
+}
+
+// Sous verrou : le transfert ne prend plus son tour sur les seaux partagés
+void TransferScheduler::dequeue(Transfer& transfer) {
+    if (transfer.queued) {
+        transfer.queued = false;
+        changed.notify_all();
+    }
+}
+
+void TransferScheduler::forget(Transfer& transfer) {
+    std::lock_guard<std::mutex> lock(mutex);
+    dequeue(transfer);
+    transfers.erase(std::find(transfers.begin(), transfers.end(), &transfer));
+    changed.notify_all();
+}
+
+TransferScheduler::Transfer::~Transfer() {
+    scheduler->forget(*this);
+}
+
+bool TransferScheduler::Transfer::tryConsume(uint64_t bytes) {
+    std::lock_guard<std::mutex> lock(scheduler->mutex);
+    if (!scheduler->limited && !own.limited()) return true;
+    Clock::duration retry;
+    return scheduler->grant(*this, bytes, retry);
+}
+
+void TransferScheduler::Transfer::consume(uint64_t bytes) {
+    std::unique_lock<std::mutex> lock(scheduler->mutex);
+    if (!scheduler->limited && !own.limited()) return;
+
+    Clock::duration retry;
+    while (!scheduler->grant(*this, bytes, retry)) {
+        // Réveillé plus tôt si un autre transfert passe ou si les limites changent
+        scheduler->changed.wait_for(lock, std::min<Clock::duration>(retry, std::chrono::milliseconds(100)));
+    }
+}
+
+} // namespace SCPClient
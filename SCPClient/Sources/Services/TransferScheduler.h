@@ -0,0 +1,107 @@
+//
+//  TransferScheduler.h
+//  SCP Client for macOS
+//
+//  Limitation de débit des transferts : seaux à jetons global, par hôte et
+//  par transfert, partage pondéré par priorité entre transferts actifs
+//
+
+#ifndef TransferScheduler_h
+#define TransferScheduler_h
+
+#include "SCPSession.h"
+#include <chrono>
+#include <condition_variable>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace SCPClient {
+
+// Les octets sont décomptés après leur passage : un transfert peut dépasser
+// son seau d'un bloc, puis attend que le seau redevienne positif. Sur un
+// seau partagé (global, hôte), les transferts passent par ordre d'étiquette
+// de départ (start-time fair queuing) : chaque bloc avance l'étiquette de
+// taille / poids, un transfert interactif avance donc huit fois moins vite
+// qu'un transfert de fond. Un transfert en retard qui vient de passer est
+// attendu un court instant (il est entre deux blocs) avant de céder sa place.
+class TransferScheduler {
+public:
+    class Transfer;
+
+    static TransferScheduler& shared();
+
+    // Octets par seconde, 0 : illimité
+    void setGlobalLimit(uint64_t bytesPerSecond);
+    void setHostLimit(const std::string& host, uint64_t bytesPerSecond);
+    uint64_t getGlobalLimit() const;
+
+    // Transfert actif vers `host` ; `limit` : débit propre (0 : aucun)
+    std::shared_ptr<Transfer> begin(const std::string& host, TransferPriority priority,
+                                    uint64_t limit);
+
+private:
+    friend class Transfer;
+    using Clock = std::chrono::steady_clock;
+
+    struct Bucket {
+        double rate = 0;        // octets par seconde, 0 : illimité
+        double tokens = 0;
+        Clock::time_point updated;
+
+        bool limited() const { return rate > 0; }
+        void setRate(double bytesPerSecond, Clock::time_point now);
+        void refill(Clock::time_point now);
+        // Attente avant que le seau redevienne positif
+        Clock::duration deficit() const;
+    };
+
+    TransferScheduler() = default;
+
+    bool grant(Transfer& transfer, uint64_t bytes, Clock::duration& retry);
+    void dequeue(Transfer& transfer);
+    void forget(Transfer& transfer);
+    void updateLimited();
+
+    mutable std::mutex mutex;
+    std::condition_variable changed;
+    Bucket global;
+    std::unordered_map<std::string, Bucket> hosts;
+    bool limited = false;             // global ou au moins un hôte
+
+    std::vector<Transfer*> transfers;  // transferts actifs
+    double virtualTime = 0;
+    uint64_t nextId = 0;
+};
+
+class TransferScheduler::Transfer {
+public:
+    ~Transfer();
+
+    // `bytes` viennent de passer : vrai si le transfert peut continuer (ils
+    // sont alors décomptés), faux s'il doit attendre son tour (réacteur)
+    bool tryConsume(uint64_t bytes);
+    // Attend son tour puis décompte
+    void consume(uint64_t bytes);
+
+private:
+    friend class TransferScheduler;
+    Transfer() = default;
+
+    TransferScheduler* scheduler = nullptr;
+    std::string host;
+    double weight = 1;
+    uint64_t id = 0;
+    Bucket own;
+
+    bool queued = false;              // en attente d'un seau partagé
+    double tag = 0;
+    double lastFinish = 0;
+    Clock::time_point lastGrant;
+};
+
+} // namespace SCPClient
+
+#endif /* TransferScheduler_h */
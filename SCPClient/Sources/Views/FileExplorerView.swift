@@ -137,6 +137,8 @@ struct NavigationBar: View {
 struct FileListView: View {
     @EnvironmentObject var connectionService: ConnectionService
     @Binding var selectedFiles: Set<UUID>
+    @State private var pendingTreeRemoval: RemoteFile?
+    @State private var operationError: String?
 
     var body: some View {
         Table(connectionService.remoteFiles, selection: $selectedFiles) {
@@ -183,6 +185,12 @@ struct FileListView: View {
                     }
                 }
 
+                Button("Dupliquer") {
+                    Task {
+                        await duplicate(file)
+                    }
+                }
+
                 Divider()
 
                 Button("Supprimer", role: .destructive) {
@@ -190,6 +198,20 @@ struct FileListView: View {
                         try? await deleteFile(file)
                     }
                 }
+
+                if file.isDirectory {
+                    Button("Supprimer avec son contenu…", role: .destructive) {
+                        pendingTreeRemoval = file
+                    }
+                }
+            } else if items.count > 1 {
+                let files = connectionService.remoteFiles.filter { items.contains($0.id) }
+
+                Button("Supprimer \(files.count) éléments", role: .destructive) {
+                    Task {
+                        await deleteItems(files)
+                    }
+                }
             }
         } primaryAction: { items in
             if let fileId = items.first,
@@ -200,6 +222,89 @@ struct FileListView: View {
                 }
             }
         }
+        .confirmationDialog(
+            "Supprimer « \(pendingTreeRemoval?.name ?? "") » et tout son contenu ?",
+            isPresented: Binding(get: { pendingTreeRemoval != nil },
+                                 set: { if !$0 { pendingTreeRemoval = nil } }),
+            titleVisibility: .visible,
+            presenting: pendingTreeRemoval
+        ) { file in
+            Button("Supprimer", role: .destructive) {
+                Task {
+                    await removeTree(file)
+                }
+            }
+            Button("Annuler", role: .cancel) {}
+        } message: { _ in
+            Text("Les fichiers et sous-dossiers seront supprimés sur le serveur. Cette action est irréversible.")
+        }
+        .alert(
+            "Opération impossible",
+            isPresented: Binding(get: { operationError != nil },
+                                 set: { if !$0 { operationError = nil } })
+        ) {
+            Button("OK") {}
+        } message: {
+            Text(operationError ?? "")
+        }
+    }
+
+    // Les chemins en échec sont listés (les premiers seulement si le lot
+    // est grand), les autres sont supprimés
+    private func deleteItems(_ files: [RemoteFile]) async {
+        do {
+            let failures = try await connectionService.deleteItems(files)
+            guard !failures.isEmpty else { return }
+            let shown = failures.sorted { $0.key < $1.key }.prefix(10)
+            var message = "\(failures.count) élément(s) sur \(files.count) non supprimé(s) :\n"
+            message += shown.map { "\($0.key) : \($0.value)" }.joined(separator: "\n")
+            if failures.count > shown.count {
+                message += "\n… et \(failures.count - shown.count) autre(s)"
+            }
+            operationError = message
+        } catch {
+            operationError = error.localizedDescription
+        }
+    }
+
+    private func removeTree(_ file: RemoteFile) async {
+        do {
+            try await connectionService.removeTree(at: file.path)
+        } catch {
+            operationError = error.localizedDescription
+        }
+    }
+
+    private func duplicate(_ file: RemoteFile) async {
+        do {
+            // Liste à jour : le nom de la copie ne doit pas déjà exister
+            try await connectionService.loadDirectory(connectionService.currentDirectory)
+            try await connectionService.copyItem(at: file.path, to: duplicatePath(for: file))
+        } catch {
+            operationError = error.localizedDescription
+        }
+    }
+
+    // « nom copie.ext », puis « nom copie 2.ext »… : premier nom libre dans
+    // le dossier, suffixe placé avant l'extension des fichiers
+    private func duplicatePath(for file: RemoteFile) -> String {
+        let name = file.name as NSString
+        var base = file.name
+        var suffix = ""
+        if !file.isDirectory, !name.pathExtension.isEmpty, !name.deletingPathExtension.isEmpty {
+            base = name.deletingPathExtension
+            suffix = "." + name.pathExtension
+        }
+
+        let taken = Set(connectionService.remoteFiles.map(\.name))
+        var number = 1
+        var candidate = base + " copie" + suffix
+        while taken.contains(candidate) {
+            number += 1
+            candidate = base + " copie \(number)" + suffix
+        }
+        return ((file.path as NSString).deletingLastPathComponent as NSString)
+            .appendingPathComponent(candidate)
     }
 
     private func downloadFile(_ file: RemoteFile) {
@@ -11,8 +11,7 @@ struct TerminalView: View {
     @EnvironmentObject var connectionService: ConnectionService
 
     @State private var commandInput = ""
-    @State private var commandHistory: [TerminalEntry] = []
-    @State private var isExecuting = false
+    @State private var terminalSize = (columns: 80, rows: 24)
     @FocusState private var isInputFocused: Bool
 
     var body: some View {
@@ -32,6 +31,13 @@ struct TerminalView: View {
                         .foregroundColor(.secondary)
                 }
 
+                Button(action: interrupt) {
+                    Image(systemName: "stop.circle")
+                }
+                .buttonStyle(.borderless)
+                .disabled(!connectionService.isShellOpen)
+                .help("Interrompre la commande (Ctrl-C)")
+
                 Button(action: clearHistory) {
                     Image(systemName: "trash")
                 }
@@ -43,55 +49,24 @@ struct TerminalView: View {
 
             Divider()
 
-            // Historique des commandes
-            ScrollViewReader { proxy in
-                ScrollView {
-                    VStack(alignment: .leading, spacing: 8) {
-                        ForEach(commandHistory) { entry in
-                            VStack(alignment: .leading, spacing: 4) {
-                                // Commande
-                                HStack(spacing: 6) {
-                                    Text("$")
-                                        .foregroundColor(.green)
-                                        .fontWeight(.bold)
-                                    Text(entry.command)
-                                        .foregroundColor(.primary)
-                                }
-                                .font(.system(.body, design: .monospaced))
-
-                                // Output
-                                if !entry.output.isEmpty {
-                                    Text(entry.output)
-                                        .font(.system(.body, design: .monospaced))
-                                        .foregroundColor(entry.isError ? .red : .secondary)
-                                        .textSelection(.enabled)
-                                        .padding(.leading, 20)
-                                }
-                            }
-                            .padding(.vertical, 4)
-                            .id(entry.id)
-                        }
-
-                        if isExecuting {
-                            HStack(spacing: 6) {
-                                ProgressView()
-                                    .scaleEffect(0.7)
-                                Text("Exécution en cours...")
-                                    .font(.system(.caption, design: .monospaced))
-                                    .foregroundColor(.secondary)
-                            }
-                        }
+            // Sortie du shell
+            GeometryReader { geometry in
+                ScrollViewReader { proxy in
+                    ScrollView {
+                        Text(connectionService.shellTranscript.text)
+                            .font(.system(.body, design: .monospaced))
+                            .foregroundColor(.secondary)
+                            .textSelection(.enabled)
+                            .frame(maxWidth: .infinity, alignment: .leading)
+                            .padding()
+                            .id("transcript")
                     }
-                    .padding()
-                    .frame(maxWidth: .infinity, alignment: .leading)
-                }
-                .onChange(of: commandHistory.count) { _ in
-                    if let lastEntry = commandHistory.last {
-                        withAnimation {
-                            proxy.scrollTo(lastEntry.id, anchor: .bottom)
-                        }
+                    .onChange(of: connectionService.shellTranscript.text.utf8.count) { _ in
+                        proxy.scrollTo("transcript", anchor: .bottom)
                     }
                 }
+                .onAppear { resize(to: geometry.size) }
+                .onChange(of: geometry.size) { size in resize(to: size) }
             }
 
             Divider()
@@ -107,7 +82,7 @@ struct TerminalView: View {
                     .textFieldStyle(.plain)
                     .font(.system(.body, design: .monospaced))
                     .focused($isInputFocused)
-                    .disabled(isExecuting || !connectionService.isConnected)
+                    .disabled(!connectionService.isConnected)
                     .onSubmit {
                         executeCommand()
                     }
@@ -116,7 +91,7 @@ struct TerminalView: View {
                     Image(systemName: "return")
                 }
                 .keyboardShortcut(.return, modifiers: [])
-                .disabled(commandInput.isEmpty || isExecuting || !connectionService.isConnected)
+                .disabled(commandInput.isEmpty || !connectionService.isConnected)
             }
             .padding()
             .background(Color(nsColor: .controlBackgroundColor))
@@ -124,14 +99,19 @@ struct TerminalView: View {
         .onAppear {
             isInputFocused = true
             // Ajouter un message de bienvenue
-            if commandHistory.isEmpty {
-                commandHistory.append(TerminalEntry(
-                    command: "# Terminal SSH connecté",
-                    output: "Tapez vos commandes ci-dessous. Exemples:\n- ls -la\n- pwd\n- reboot\n- unzip fichier.zip\n- tar -xzf archive.tar.gz",
-                    isError: false
-                ))
+            if connectionService.shellTranscript.text.isEmpty {
+                connectionService.shellTranscript.append("# Terminal SSH connecté\nTapez vos commandes ci-dessous. Exemples:\n- ls -la\n- pwd\n- reboot\n- unzip fichier.zip\n- tar -xzf archive.tar.gz\n\n")
             }
+            Task { await openShell() }
         }
+        // Pas de fermeture en quittant la vue : le shell appartient à
+        // ConnectionService et garde son état jusqu'à la déconnexion
+    }
+
+    // Un seul shell pour toutes les commandes : `cd` et les variables
+    // restent d'une commande à l'autre
+    private func openShell() async {
+        await connectionService.openShell(columns: terminalSize.columns, rows: terminalSize.rows)
     }
 
     private func executeCommand() {
@@ -139,41 +119,62 @@ struct TerminalView: View {
 
         let command = commandInput
         commandInput = ""
-        isExecuting = true
-
-        // Ajouter la commande à l'historique
-        commandHistory.append(TerminalEntry(command: command, output: "", isError: false))
 
+        // Le shell n'a pas d'écho : la commande est recopiée ici
+        connectionService.shellTranscript.append(command + "\n")
         Task {
-            do {
-                let output = try await connectionService.executeCommand(command)
-
-                await MainActor.run {
-                    if let index = commandHistory.firstIndex(where: { $0.command == command && $0.output.isEmpty }) {
-                        commandHistory[index].output = output.isEmpty ? "(commande exécutée avec succès)" : output
-                    }
-                    isExecuting = false
-                }
-            } catch {
-                await MainActor.run {
-                    if let index = commandHistory.firstIndex(where: { $0.command == command && $0.output.isEmpty }) {
-                        commandHistory[index].output = "Erreur: \(error.localizedDescription)"
-                        commandHistory[index].isError = true
-                    }
-                    isExecuting = false
-                }
+            await openShell()
+            if !connectionService.sendToShell(command + "\n") {
+                connectionService.shellTranscript.append("Erreur: shell fermé\n")
             }
         }
     }
 
+    private func interrupt() {
+        connectionService.sendToShell("\u{03}")
+    }
+
+    private func resize(to size: CGSize) {
+        // Cellule approximative de la police à chasse fixe du corps de texte
+        let columns = max(Int(size.width / 7.8), 20)
+        let rows = max(Int(size.height / 17), 5)
+        guard columns != terminalSize.columns || rows != terminalSize.rows else { return }
+        terminalSize = (columns, rows)
+        if connectionService.isShellOpen {
+            connectionService.resizeShell(columns: columns, rows: rows)
+        }
+    }
+
     private func clearHistory() {
-        commandHistory.removeAll()
+        connectionService.shellTranscript = TerminalTranscript()
     }
 }
 
-struct TerminalEntry: Identifiable {
-    let id = UUID()
-    let command: String
-    var output: String
-    var isError: Bool
+// Sortie du terminal, bornée : au-delà de maxLength caractères, le début est
+// abandonné. Les retours chariot et séquences d'échappement ANSI qu'un
+// programme envoie malgré TERM=dumb sont retirés.
+struct TerminalTranscript {
+    static let maxLength = 256 * 1024
+
+    private(set) var text = ""
+
+    mutating func append(_ chunk: String) {
+        text += TerminalTranscript.sanitize(chunk)
+        // Compte en octets d'abord : le compte en caractères parcourt le texte
+        guard text.utf8.count > TerminalTranscript.maxLength else { return }
+        let excess = text.count - TerminalTranscript.maxLength
+        if excess > 0 {
+            text = "…" + text.dropFirst(excess + 1)
+        }
+    }
+
+    private static func sanitize(_ chunk: String) -> String {
+        guard chunk.contains(where: { $0 == "\r" || $0 == "\u{1B}" || $0 == "\u{07}" }) else {
+            return chunk
+        }
+        return chunk
+            .replacingOccurrences(of: "\u{1B}\\[[0-9;?]*[ -/]*[@-~]", with: "", options: .regularExpression)
+            .replacingOccurrences(of: "\u{1B}\\][^\u{07}]*\u{07}", with: "", options: .regularExpression)
+            .replacingOccurrences(of: "[\r\u{07}]", with: "", options: .regularExpression)
+    }
 }
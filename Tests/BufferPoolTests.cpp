@@ -0,0 +1,115 @@
+//
+//  BufferPoolTests.cpp
+//  SCP Client for macOS
+//
+//  Capacités alignées sur la page, recyclage des tampons rendus, limite de
+//  mémoire au repos
+//
+
+#include "BufferPool.h"
+#include "TestSupport.h"
+#include <cstdint>
+#include <cstring>
+#include <unistd.h>
+#include <utility>
+
+using namespace SCPClient;
+
+static const size_t page = (size_t)sysconf(_SC_PAGESIZE);
+
+static bool aligned(const char* bytes) {
+    return (uintptr_t)bytes % page == 0;
+}
+
+static void testAlignment(BufferPool& pool) {
+    for (size_t size : {(size_t)0, (size_t)1, page - 1, page + 1, BufferPool::packetSize, (size_t)1000000}) {
+        BufferPool::Buffer buffer = pool.acquire(size);
+        CHECK(buffer);
+        CHECK(buffer.size() == size);
+        CHECK(aligned(buffer.data()));
+        // Toute la taille demandée est utilisable
+        memset(buffer.data(), 0x5a, size);
+    }
+}
+
+static void testRecycling(BufferPool& pool) {
+    pool.trim();
+    CHECK(pool.idleBytes() == 0);
+
+    char* first;
+    {
+        BufferPool::Buffer buffer = pool.acquire(page + 1);
+        first = buffer.data();
+    }
+    // Arrondi à la puissance de deux supérieure
+    CHECK(pool.idleBytes() == 2 * page);
+
+    // Même classe de capacité : même tampon, sans allocation
+    {
+        BufferPool::Buffer buffer = pool.acquire(2 * page);
+        CHECK(buffer.data() == first);
+        CHECK(pool.idleBytes() == 0);
+    }
+    // Autre classe : nouveau tampon, le premier reste au repos
+    {
+        BufferPool::Buffer buffer = pool.acquire(page);
+        CHECK(buffer.data() != first);
+        CHECK(pool.idleBytes() == 2 * page);
+    }
+    CHECK(pool.idleBytes() == 3 * page);
+
+    // Déplacement : un seul retour au pool
+    {
+        BufferPool::Buffer source = pool.acquire(4 * page);
+        BufferPool::Buffer target = std::move(source);
+        CHECK(!source);
+        CHECK(target);
+        BufferPool::Buffer other = pool.acquire(4 * page);
+        other = std::move(target);   // `other` rendu ici
+        CHECK(pool.idleBytes() == 7 * page);
+    }
+    CHECK(pool.idleBytes() == 11 * page);
+
+    pool.trim();
+    CHECK(pool.idleBytes() == 0);
+}
+
+static void testIdleLimit(BufferPool& pool) {
+    pool.trim();
+    pool.setIdleLimit(4 * page);
+    {
+        BufferPool::Buffer a = pool.acquire(4 * page);
+        BufferPool::Buffer b = pool.acquire(4 * page);
+        BufferPool::Buffer c = pool.acquire(page);
+    }
+    // Au-delà de la limite, les tampons rendus sont libérés
+    CHECK(pool.idleBytes() <= 4 * page);
+    CHECK(pool.idleBytes() > 0);
+
+    // Abaisser la limite libère les plus grands d'abord
+    pool.trim();
+    pool.setIdleLimit(8 * page);
+    {
+        BufferPool::Buffer a = pool.acquire(4 * page);
+        BufferPool::Buffer b = pool.acquire(page);
+    }
+    CHECK(pool.idleBytes() == 5 * page);
+    pool.setIdleLimit(2 * page);
+    CHECK(pool.idleBytes() == page);
+
+    // Limite nulle : aucun recyclage
+    pool.setIdleLimit(0);
+    CHECK(pool.idleBytes() == 0);
+    pool.acquire(page);
+    CHECK(pool.idleBytes() == 0);
+
+    pool.setIdleLimit(64 * 1024 * 1024);
+}
+
+int main() {
+    BufferPool& pool = BufferPool::shared();
+    testAlignment(pool);
+    testRecycling(pool);
+    testIdleLimit(pool);
+    return SCPClientTests::finish("BufferPool");
+}
@@ -0,0 +1,193 @@
+//
+//  DeltaSyncTests.cpp
+//  SCP Client for macOS
+//
+//  Adler-32 comparé à zlib, signatures, et reconstruction du fichier à partir
+//  des instructions du DeltaEncoder
+//
+
+#include "DeltaSync.h"
+#include "TestSupport.h"
+#include <zlib.h>
+#include <cstring>
+#include <fcntl.h>
+
+using namespace SCPClient;
+using SCPClientTests::randomBytes;
+using SCPClientTests::TemporaryFile;
+
+static void testAdler32() {
+    std::string data = randomBytes(200000, 3);
+    const unsigned char* bytes = (const unsigned char*)data.data();
+    // Autour des segments de 16 octets et du NMAX de zlib (5552)
+    for (size_t length : {0, 1, 15, 16, 17, 255, 5551, 5552, 5553, 11104, 65536, 199999}) {
+        for (size_t offset : {0, 1, 3}) {
+            uint32_t expected = (uint32_t)::adler32(1, bytes + offset, (uInt)length);
+            CHECK(SCPClient::adler32(bytes + offset, length) == expected);
+        }
+    }
+    // Octets à 0xff : sommes maximales
+    std::string ones(100000, '\xff');
+    CHECK(SCPClient::adler32((const unsigned char*)ones.data(), ones.size()) ==
+          (uint32_t)::adler32(1, (const unsigned char*)ones.data(), (uInt)ones.size()));
+}
+
+static void testBlockSize() {
+    CHECK(deltaBlockSize(0) == 2048);
+    CHECK(deltaBlockSize(1024 * 1024) == 2048);
+    CHECK(deltaBlockSize(64ull * 1024 * 1024) == 8192);
+    CHECK(deltaBlockSize(1ull << 40) == 128 * 1024);
+}
+
+static std::vector<BlockSignature> signatures(const std::string& old, size_t blockSize) {
+    std::vector<BlockSignature> blocks;
+    for (size_t offset = 0; offset < old.size(); offset += blockSize) {
+        size_t length = std::min(blockSize, old.size() - offset);
+        BlockSignature block;
+        block.weak = SCPClient::adler32((const unsigned char*)old.data() + offset, length);
+        strongChecksum((const unsigned char*)old.data() + offset, length, block.strong);
+        blocks.push_back(block);
+    }
+    return blocks;
+}
+
+static uint64_t bigEndian(const std::string& data, size_t& pos, int bytes) {
+    uint64_t value = 0;
+    for (int i = 0; i < bytes; ++i) value = (value << 8) | (unsigned char)data[pos++];
+    return value;
+}
+
+// Même interprétation que deltaPatchScript
+static bool applyDelta(const std::string& old, const std::string& delta, std::string& result) {
+    size_t pos = 0;
+    result.clear();
+    while (pos < delta.size()) {
+        char op = delta[pos++];
+        if (op == 'E') return pos == delta.size();
+        if (op == 'C') {
+            uint64_t offset = bigEndian(delta, pos, 8);
+            uint64_t length = bigEndian(delta, pos, 4);
+            if (offset + length > old.size()) return false;
+            result.append(old, (size_t)offset, (size_t)length);
+        } else if (op == 'D') {
+            uint64_t length = bigEndian(delta, pos, 4);
+            if (pos + length > delta.size()) return false;
+            result.append(delta, pos, (size_t)length);
+            pos += (size_t)length;
+        } else {
+            return false;
+        }
+    }
+    return false;
+}
+
+static bool encode(const std::string& old, const std::string& current, size_t blockSize,
+                   std::string& delta, uint64_t& matched) {
+    TemporaryFile file;
+    int fd = open(file.path.c_str(), O_RDWR | O_TRUNC);
+    if (fd < 0 || write(fd, current.data(), current.size()) != (ssize_t)current.size()) {
+        if (fd >= 0) close(fd);
+        return false;
+    }
+    lseek(fd, 0, SEEK_SET);
+
+    std::vector<BlockSignature> blocks = signatures(old, blockSize);
+    DeltaEncoder encoder(fd, current.size(), blockSize, blocks, old.size());
+    delta.clear();
+    bool eof = false;
+    bool ok = true;
+    while (ok && !eof) {
+        ok = encoder.produce(delta, 64 * 1024, eof);
+    }
+    close(fd);
+    matched = encoder.matchedBytes;
+    CHECK(encoder.matchedBytes + encoder.literalBytes == current.size());
+    return ok;
+}
+
+static void testReconstruction() {
+    const size_t blockSize = 2048;
+    std::string old = randomBytes(300 * 1024 + 123, 4);
+
+    struct Case {
+        const char* name;
+        std::string current;
+        bool mostlyMatched;
+    };
+    std::string edited = old;
+    edited.replace(50000, 10, "modifie!!!");
+    std::string inserted = old;
+    inserted.insert(100001, "insertion au milieu d'un bloc");
+    std::string removed = old;
+    removed.erase(70000, 5000);
+    std::string appended = old + randomBytes(4000, 5);
+    std::string truncated = old.substr(0, 150000);
+    std::vector<Case> cases = {
+        {"identique", old, true},
+        {"modifié", edited, true},
+        {"insertion", inserted, true},
+        {"suppression", removed, true},
+        {"ajout", appended, true},
+        {"tronqué", truncated, true},
+        {"vide", "", false},
+        {"différent", randomBytes(old.size(), 6), false},
+    };
+
+    for (const Case& test : cases) {
+        std::string delta, result;
+        uint64_t matched = 0;
+        bool encoded = encode(old, test.current, blockSize, delta, matched);
+        CHECK(encoded);
+        CHECK(applyDelta(old, delta, result));
+        if (result != test.current) fprintf(stderr, "cas %s : fichier reconstruit différent\n", test.name);
+        CHECK(result == test.current);
+        if (test.mostlyMatched) CHECK(matched + 2 * blockSize + 64 >= test.current.size() - 5000);
+        else CHECK(matched == 0);
+    }
+}
+
+static void testSignatureParser() {
+    const size_t blockSize = 2048;
+    std::string old = randomBytes(5000, 7);
+    std::vector<BlockSignature> blocks = signatures(old, blockSize);
+
+    std::string text = "sig 5000\n";
+    for (const BlockSignature& block : blocks) {
+        char line[64];
+        int length = snprintf(line, sizeof(line), "%08x ", block.weak);
+        for (int i = 0; i < 16; ++i) length += snprintf(line + length, sizeof(line) - length, "%02x", block.strong[i]);
+        text += std::string(line, length) + "\n";
+    }
+
+    SignatureParser parser;
+    for (char c : text) CHECK(parser.feed(&c, 1));
+    CHECK(parser.exists);
+    CHECK(parser.remoteSize == 5000);
+    CHECK(parser.complete(blockSize));
+    CHECK(parser.blocks.size() == blocks.size());
+    for (size_t i = 0; i < blocks.size() && i < parser.blocks.size(); ++i) {
+        CHECK(parser.blocks[i].weak == blocks[i].weak);
+        CHECK(memcmp(parser.blocks[i].strong, blocks[i].strong, 16) == 0);
+    }
+
+    SignatureParser missing;
+    CHECK(missing.feed("none\n", 5));
+    CHECK(!missing.exists);
+    CHECK(missing.complete(blockSize));
+
+    SignatureParser cut;
+    CHECK(cut.feed(text.data(), text.size() - 20));
+    CHECK(!cut.complete(blockSize));
+
+    SignatureParser garbage;
+    CHECK(!garbage.feed("sig 10\nzz\n", 10));
+    CHECK(!garbage.complete(blockSize));
+}
+
+int main() {
+    testAdler32();
+    testBlockSize();
+    testReconstruction();
+    testSignatureParser();
+    return SCPClientTests::finish("DeltaSync");
+}
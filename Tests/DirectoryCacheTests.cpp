@@ -0,0 +1,142 @@
+//
+//  DirectoryCacheTests.cpp
+//  SCP Client for macOS
+//
+//  Cache des listages : fraîcheur, revalidation par date, invalidation et
+//  éviction
+//
+
+#include "DirectoryCache.h"
+#include "TestSupport.h"
+#include <thread>
+
+using namespace SCPClient;
+
+static DirectoryListing listingOf(const std::string& path, size_t count) {
+    DirectoryListing listing(path);
+    for (size_t i = 0; i < count; ++i) {
+        listing.append("f" + std::to_string(i), i, 0100644, false, 1000);
+    }
+    return listing;
+}
+
+static DirectoryCache::Lookup find(DirectoryCache& cache, const std::string& path,
+                                   size_t* size = nullptr, int64_t* mtime = nullptr) {
+    DirectoryListing listing;
+    int64_t found = -1;
+    DirectoryCache::Lookup result = cache.lookup(path, listing, found);
+    if (size) *size = listing.size();
+    if (mtime) *mtime = found;
+    return result;
+}
+
+static void testDisabled() {
+    DirectoryCache cache;
+    CHECK(!cache.enabled());
+    cache.store("/a", listingOf("/a", 3), 1000, cache.generation());
+    CHECK(find(cache, "/a") == DirectoryCache::Lookup::Miss);
+}
+
+static void testFreshAndNormalized() {
+    DirectoryCache cache;
+    cache.configure(std::chrono::seconds(60), 16, 1000);
+    CHECK(cache.enabled());
+    cache.store("/a/b/", listingOf("/a/b", 3), 1000, cache.generation());
+
+    size_t size = 0;
+    CHECK(find(cache, "/a/b", &size) == DirectoryCache::Lookup::Fresh);
+    CHECK(size == 3);
+    CHECK(find(cache, "/a/b//") == DirectoryCache::Lookup::Fresh);
+    CHECK(DirectoryCache::normalize("/") == "/");
+    CHECK(DirectoryCache::normalize("/x///") == "/x");
+}
+
+static void testGeneration() {
+    DirectoryCache cache;
+    cache.configure(std::chrono::seconds(60), 16, 1000);
+    uint64_t started = cache.generation();
+    cache.invalidate("/ailleurs");
+    // Listage commencé avant l'invalidation : pas gardé
+    cache.store("/a", listingOf("/a", 1), 1000, started);
+    CHECK(find(cache, "/a") == DirectoryCache::Lookup::Miss);
+}
+
+static void testInvalidation() {
+    DirectoryCache cache;
+    cache.configure(std::chrono::seconds(60), 16, 1000);
+    for (const char* path : {"/", "/a", "/a/b", "/a/b/c", "/ab"}) {
+        cache.store(path, listingOf(path, 1), 1000, cache.generation());
+    }
+
+    cache.invalidateParent("/a/b/fichier");
+    CHECK(find(cache, "/a/b") == DirectoryCache::Lookup::Miss);
+    CHECK(find(cache, "/a/b/c") == DirectoryCache::Lookup::Fresh);
+
+    cache.invalidateParent("/top");
+    CHECK(find(cache, "/") == DirectoryCache::Lookup::Miss);
+
+    cache.invalidateTree("/a");
+    CHECK(find(cache, "/a") == DirectoryCache::Lookup::Miss);
+    CHECK(find(cache, "/a/b/c") == DirectoryCache::Lookup::Miss);
+    CHECK(find(cache, "/ab") == DirectoryCache::Lookup::Fresh);   // simple préfixe
+
+    cache.clear();
+    CHECK(find(cache, "/ab") == DirectoryCache::Lookup::Miss);
+}
+
+static void testEviction() {
+    DirectoryCache cache;
+    cache.configure(std::chrono::seconds(60), 2, 10);
+    cache.store("/1", listingOf("/1", 1), 1000, cache.generation());
+    cache.store("/2", listingOf("/2", 1), 1000, cache.generation());
+    CHECK(find(cache, "/1") == DirectoryCache::Lookup::Fresh);   // devient le plus récent
+    cache.store("/3", listingOf("/3", 1), 1000, cache.generation());
+    CHECK(find(cache, "/2") == DirectoryCache::Lookup::Miss);
+    CHECK(find(cache, "/1") == DirectoryCache::Lookup::Fresh);
+
+    // Le moins récemment consulté part d'abord ; puis trop d'entrées au
+    // total, ou un listage à lui seul trop grand
+    cache.store("/gros", listingOf("/gros", 9), 1000, cache.generation());
+    CHECK(find(cache, "/gros") == DirectoryCache::Lookup::Fresh);
+    CHECK(find(cache, "/3") == DirectoryCache::Lookup::Miss);
+    CHECK(find(cache, "/1") == DirectoryCache::Lookup::Fresh);
+    cache.store("/4", listingOf("/4", 2), 1000, cache.generation());
+    CHECK(find(cache, "/4") == DirectoryCache::Lookup::Fresh);
+    CHECK(find(cache, "/gros") == DirectoryCache::Lookup::Miss);
+    cache.store("/enorme", listingOf("/enorme", 11), 1000, cache.generation());
+    CHECK(find(cache, "/enorme") == DirectoryCache::Lookup::Miss);
+}
+
+static void testRevalidation() {
+    DirectoryCache cache;
+    cache.configure(std::chrono::seconds(1), 16, 1000);
+    cache.store("/ancien", listingOf("/ancien", 2), 1000, cache.generation());
+    cache.store("/inconnu", listingOf("/inconnu", 2), -1, cache.generation());
+    int64_t future = (int64_t)time(nullptr) + 3600;
+    cache.store("/recent", listingOf("/recent", 2), future, cache.generation());
+
+    std::this_thread::sleep_for(std::chrono::milliseconds(1100));
+    size_t size = 0;
+    int64_t mtime = 0;
+    CHECK(find(cache, "/ancien", &size, &mtime) == DirectoryCache::Lookup::Expired);
+    CHECK(size == 2);
+    CHECK(mtime == 1000);
+
+    CHECK(!cache.revalidate("/ancien", 1001));       // le répertoire a changé
+    CHECK(cache.revalidate("/ancien", 1000));
+    CHECK(find(cache, "/ancien") == DirectoryCache::Lookup::Fresh);
+
+    CHECK(!cache.revalidate("/inconnu", -1));        // date inconnue au listage
+    CHECK(!cache.revalidate("/recent", future));     // date pas antérieure au listage
+    CHECK(!cache.revalidate("/absent", 1000));
+}
+
+int main() {
+    testDisabled();
+    testFreshAndNormalized();
+    testGeneration();
+    testInvalidation();
+    testEviction();
+    testRevalidation();
+    return SCPClientTests::finish("DirectoryCache");
+}
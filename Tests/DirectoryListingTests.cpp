@@ -0,0 +1,117 @@
+//
+//  DirectoryListingTests.cpp
+//  SCP Client for macOS
+//
+//  Listage compact : chemins, tri stable et filtre
+//
+
+#include "DirectoryListing.h"
+#include "TestSupport.h"
+
+using namespace SCPClient;
+
+static std::string names(const DirectoryListing& listing) {
+    std::string result;
+    for (size_t i = 0; i < listing.size(); ++i) {
+        if (i) result += ",";
+        result += std::string(listing.name(i));
+    }
+    return result;
+}
+
+static DirectoryListing sample() {
+    DirectoryListing listing("/srv/data/");
+    listing.append("b.txt", 30, 0100644, false, 300);
+    listing.append("docs", 4096, 040755, true, 100);
+    listing.append("a.txt", 10, 0100600, false, 300);
+    listing.append("z", 4096, 040700, true, 200);
+    listing.append("c.txt", 30, 0100644, false, 50);
+    return listing;
+}
+
+static void testEntries() {
+    DirectoryListing listing = sample();
+    CHECK(listing.size() == 5);
+    CHECK(listing.parentPath() == "/srv/data/");
+    CHECK(listing.path(0) == "/srv/data/b.txt");
+
+    DirectoryListing root("/");
+    root.append("etc", 0, 040755, true, 0);
+    CHECK(root.path(0) == "/etc");
+    DirectoryListing plain("home");
+    plain.append("u", 0, 040755, true, 0);
+    CHECK(plain.path(0) == "home/u");
+
+    // RemoteFile réutilisé d'une entrée à l'autre
+    RemoteFile file;
+    listing.entry(1, file);
+    CHECK(file.name == "docs");
+    CHECK(file.path == "/srv/data/docs");
+    CHECK(file.isDirectory);
+    CHECK(file.permissions == 040755);
+    listing.entry(2, file);
+    CHECK(file.name == "a.txt");
+    CHECK(file.size == 10);
+    CHECK(!file.isDirectory);
+    CHECK(file.modificationTime == 300);
+
+    std::vector<RemoteFile> files = listing.toFiles();
+    CHECK(files.size() == 5);
+    CHECK(files[4].path == "/srv/data/c.txt");
+
+    RemoteFile copy;
+    copy.name = "e";
+    copy.size = 7;
+    copy.permissions = 0100644;
+    copy.isDirectory = false;
+    copy.modificationTime = 9;
+    listing.append(copy);
+    CHECK(listing.size() == 6);
+    CHECK(listing.fileSize(5) == 7);
+
+    listing.reset("/autre");
+    CHECK(listing.empty());
+    CHECK(listing.parentPath() == "/autre");
+}
+
+static void testSort() {
+    DirectoryListing listing = sample();
+    listing.sort(DirectoryListing::SortKey::Name);
+    CHECK(names(listing) == "a.txt,b.txt,c.txt,docs,z");
+    CHECK(listing.fileSize(0) == 10);
+    CHECK(listing.path(3) == "/srv/data/docs");
+
+    listing.sort(DirectoryListing::SortKey::Name, true, true);
+    CHECK(names(listing) == "z,docs,c.txt,b.txt,a.txt");
+
+    // Stable : à taille égale, l'ordre précédent (noms décroissants) reste
+    listing.sort(DirectoryListing::SortKey::Size);
+    CHECK(names(listing) == "a.txt,c.txt,b.txt,z,docs");
+
+    listing = sample();
+    listing.sort(DirectoryListing::SortKey::ModificationTime, true);
+    CHECK(names(listing) == "b.txt,a.txt,z,docs,c.txt");
+    CHECK(listing.modificationTime(0) == 300);
+    CHECK(listing.isDirectory(2));
+    CHECK(listing.permissions(2) == 040700);
+}
+
+static void testFilter() {
+    DirectoryListing listing = sample();
+    listing.filter([](const DirectoryListing& entries, size_t index) {
+        return !entries.isDirectory(index) && entries.fileSize(index) >= 30;
+    });
+    CHECK(names(listing) == "b.txt,c.txt");
+    CHECK(listing.path(1) == "/srv/data/c.txt");
+    CHECK(listing.modificationTime(1) == 50);
+
+    listing.filter([](const DirectoryListing&, size_t) { return false; });
+    CHECK(listing.empty());
+}
+
+int main() {
+    testEntries();
+    testSort();
+    testFilter();
+    return SCPClientTests::finish("DirectoryListing");
+}
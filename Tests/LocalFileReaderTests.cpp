@@ -0,0 +1,125 @@
+//
+//  LocalFileReaderTests.cpp
+//  SCP Client for macOS
+//
+//  Lecture par pread sous le seuil, projection au-delà, fichier raccourci
+//  pendant la lecture
+//
+
+#include "LocalFileReader.h"
+#include "TestSupport.h"
+#include <fcntl.h>
+#include <unistd.h>
+#include <algorithm>
+#include <cstring>
+
+using namespace SCPClient;
+
+static bool writeFile(const std::string& path, const std::string& data) {
+    FILE* file = fopen(path.c_str(), "wb");
+    if (!file) return false;
+    bool ok = fwrite(data.data(), 1, data.size(), file) == data.size();
+    return fclose(file) == 0 && ok;
+}
+
+// Relit tout le fichier par slice(), en ne consommant qu'une partie de
+// chaque bloc comme une écriture partielle
+static std::string readBySlices(LocalFileReader& reader, size_t blockSize) {
+    std::string result;
+    uint64_t offset = 0;
+    while (true) {
+        const char* bytes = nullptr;
+        ssize_t length = reader.slice(offset, blockSize, bytes);
+        if (length <= 0) {
+            CHECK(length == 0);
+            break;
+        }
+        size_t used = std::max<size_t>(1, (size_t)length * 2 / 3);
+        result.append(bytes, used);
+        offset += used;
+        reader.release(offset);
+    }
+    return result;
+}
+
+static void testSmallFile() {
+    SCPClientTests::TemporaryFile file;
+    std::string data = SCPClientTests::randomBytes(1000000, 21);
+    CHECK(writeFile(file.path, data));
+    int fd = open(file.path.c_str(), O_RDONLY);
+    CHECK(fd >= 0);
+    {
+        LocalFileReader reader(fd);
+        CHECK(!reader.isMapped());
+        CHECK(reader.size() == data.size());
+        CHECK(readBySlices(reader, 65536) == data);
+
+        char buffer[100];
+        CHECK(reader.read(500000, buffer, sizeof(buffer)) == (ssize_t)sizeof(buffer));
+        CHECK(memcmp(buffer, data.data() + 500000, sizeof(buffer)) == 0);
+        CHECK(reader.read(data.size(), buffer, sizeof(buffer)) == 0);
+
+        // Pas de projection : view() ne rend rien
+        size_t length = 100;
+        CHECK(reader.view(0, length) == nullptr);
+        CHECK(length == 0);
+    }
+    close(fd);
+}
+
+static void testMappedFile() {
+    SCPClientTests::TemporaryFile file;
+    std::string data = SCPClientTests::randomBytes(LocalFileReader::mapThreshold + 12345, 22);
+    CHECK(writeFile(file.path, data));
+    int fd = open(file.path.c_str(), O_RDONLY);
+    CHECK(fd >= 0);
+    {
+        LocalFileReader reader(fd);
+        CHECK(reader.isMapped());
+        CHECK(reader.size() == data.size());
+
+        // Bornée à la fin du fichier
+        size_t length = 1 << 20;
+        const char* bytes = reader.view(data.size() - 100, length);
+        CHECK(bytes != nullptr && length == 100);
+        CHECK(bytes && memcmp(bytes, data.data() + data.size() - 100, 100) == 0);
+        length = 100;
+        CHECK(reader.view(data.size(), length) == nullptr);
+
+        // Pages rendues au fil de la lecture : relues depuis le fichier
+        CHECK(readBySlices(reader, 1 << 20) == data);
+    }
+    close(fd);
+}
+
+// Raccourci par un autre processus : la lecture s'arrête au lieu de SIGBUS
+static void testShrunkFile() {
+    SCPClientTests::TemporaryFile file;
+    std::string data = SCPClientTests::randomBytes(LocalFileReader::mapThreshold + 4096, 23);
+    CHECK(writeFile(file.path, data));
+    int fd = open(file.path.c_str(), O_RDONLY);
+    CHECK(fd >= 0);
+    {
+        LocalFileReader reader(fd);
+        CHECK(reader.isMapped());
+        const char* bytes = nullptr;
+        CHECK(reader.slice(0, 4096, bytes) == 4096);
+        CHECK(bytes && memcmp(bytes, data.data(), 4096) == 0);
+
+        CHECK(truncate(file.path.c_str(), 8 * 1024 * 1024) == 0);
+        CHECK(reader.slice(10 * 1024 * 1024, 4096, bytes) == -1);
+        size_t length = 4096;
+        CHECK(reader.view(10 * 1024 * 1024, length) == nullptr);
+        // Plus aucune lecture de la projection, même en deçà de la nouvelle fin
+        length = 4096;
+        CHECK(reader.view(0, length) == nullptr);
+    }
+    close(fd);
+}
+
+int main() {
+    testSmallFile();
+    testMappedFile();
+    testShrunkFile();
+    return SCPClientTests::finish("LocalFileReader");
+}
@@ -0,0 +1,113 @@
+//
+//  LocalFileWriterTests.cpp
+//  SCP Client for macOS
+//
+//  Écritures entrelacées de plusieurs flux, blocs nuls laissés en trous,
+//  taille finale sur un trou de fin
+//
+
+#include "LocalFileWriter.h"
+#include "TestSupport.h"
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <algorithm>
+#include <utility>
+#include <vector>
+
+using namespace SCPClient;
+using SCPClientTests::randomBytes;
+using SCPClientTests::TemporaryFile;
+
+static std::string readAll(int fd, uint64_t size) {
+    std::string data(size, '\0');
+    size_t done = 0;
+    while (done < size) {
+        ssize_t count = pread(fd, &data[done], size - done, (off_t)done);
+        if (count <= 0) break;
+        done += (size_t)count;
+    }
+    data.resize(done);
+    return data;
+}
+
+// Plages signalées fusionnées : tout [0, size) une seule fois
+static bool coversExactly(std::vector<std::pair<uint64_t, uint64_t>> ranges, uint64_t size) {
+    std::sort(ranges.begin(), ranges.end());
+    uint64_t end = 0;
+    for (const auto& range : ranges) {
+        if (range.first != end) return false;
+        end = range.first + range.second;
+    }
+    return end == size;
+}
+
+static void testInterleaved() {
+    const size_t block = LocalFileWriter::blockSize;
+    // Données, zone nulle de plusieurs tranches, données, fin nulle
+    std::string content = randomBytes(block + 1000, 8) +
+                          std::string(3 * LocalFileWriter::holeSize + 500, '\0') +
+                          randomBytes(2 * block + 77, 9) +
+                          std::string(block + LocalFileWriter::holeSize, '\0');
+    uint64_t half = content.size() / 2;
+
+    TemporaryFile file;
+    int fd = open(file.path.c_str(), O_RDWR | O_TRUNC);
+    CHECK(fd >= 0);
+    if (fd < 0) return;
+    LocalFileWriter::prepare(fd, content.size(), false);
+
+    std::vector<std::pair<uint64_t, uint64_t>> flushed;
+    {
+        LocalFileWriter writer(fd, 2, [&](uint64_t offset, uint64_t length) {
+            flushed.emplace_back(offset, length);
+        });
+        // Deux flux contigus entrelacés, morceaux de tailles irrégulières
+        uint64_t first = 0, second = half;
+        size_t sizes[] = {1, 4095, 32768, 100000, 7};
+        for (size_t i = 0; first < half || second < content.size(); ++i) {
+            size_t size = sizes[i % 5];
+            if (first < half) {
+                size_t count = (size_t)std::min<uint64_t>(size, half - first);
+                CHECK(writer.write(first, content.data() + first, count));
+                first += count;
+            }
+            if (second < content.size()) {
+                size_t count = (size_t)std::min<uint64_t>(size * 3, content.size() - second);
+                CHECK(writer.write(second, content.data() + second, count));
+                second += count;
+            }
+        }
+        CHECK(writer.finish());
+    }
+
+    struct stat info;
+    CHECK(fstat(fd, &info) == 0);
+    CHECK((uint64_t)info.st_size == content.size());
+    CHECK(readAll(fd, content.size()) == content);
+    CHECK(coversExactly(flushed, content.size()));
+    close(fd);
+}
+
+static void testZeroOnly() {
+    TemporaryFile file;
+    int fd = open(file.path.c_str(), O_RDWR | O_TRUNC);
+    CHECK(fd >= 0);
+    if (fd < 0) return;
+
+    std::string zeros(LocalFileWriter::holeSize * 4, '\0');
+    LocalFileWriter writer(fd);
+    CHECK(writer.write(0, zeros.data(), zeros.size()));
+    CHECK(writer.finish());
+
+    struct stat info;
+    CHECK(fstat(fd, &info) == 0);
+    CHECK((uint64_t)info.st_size == zeros.size());
+    CHECK(readAll(fd, zeros.size()) == zeros);
+    close(fd);
+}
+
+int main() {
+    testInterleaved();
+    testZeroOnly();
+    return SCPClientTests::finish("LocalFileWriter");
+}
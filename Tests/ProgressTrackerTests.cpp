@@ -0,0 +1,122 @@
+//
+//  ProgressTrackerTests.cpp
+//  SCP Client for macOS
+//
+//  Publications à cadence limitée, fin publiée une seule fois, dernière
+//  valeur rattrapée par flush(), instantanés et débit
+//
+
+#include "ProgressTracker.h"
+#include "TestSupport.h"
+#include <atomic>
+#include <thread>
+#include <vector>
+
+using namespace SCPClient;
+
+static void testInterval(ProgressTracker& tracker) {
+    tracker.setPublishRate(std::chrono::hours(1), 0);
+    auto transfer = tracker.begin("hôte", "/a", true);
+    std::vector<uint64_t> published;
+    ProgressCallback callback = transfer->wrap([&](uint64_t done, uint64_t) { published.push_back(done); });
+
+    // Première valeur publiée, les suivantes attendent l'intervalle
+    for (uint64_t done = 0; done < 1000; done += 100) callback(done, 1000);
+    CHECK(published.size() == 1 && published[0] == 0);
+
+    // La fin toujours, une seule fois
+    callback(1000, 1000);
+    callback(1000, 1000);
+    CHECK(published.size() == 2 && published[1] == 1000);
+
+    transfer->flush([&](uint64_t done, uint64_t) { published.push_back(done); });
+    CHECK(published.size() == 2);
+    tracker.end(transfer);
+}
+
+static void testMinBytes(ProgressTracker& tracker) {
+    tracker.setPublishRate(std::chrono::milliseconds(0), 1000);
+    auto transfer = tracker.begin("hôte", "/b", false);
+    std::vector<uint64_t> published;
+    ProgressCallback callback = transfer->wrap([&](uint64_t done, uint64_t) { published.push_back(done); });
+
+    // Taille inconnue : publication tous les 1000 octets au moins
+    for (uint64_t done = 0; done <= 5050; done += 50) callback(done, 0);
+    CHECK(published.size() == 6);
+    for (size_t i = 1; i < published.size(); ++i) {
+        CHECK(published[i] - published[i - 1] >= 1000);
+    }
+
+    // Dernière valeur non publiée : rattrapée par flush(), une fois
+    std::vector<uint64_t> flushed;
+    transfer->flush([&](uint64_t done, uint64_t) { flushed.push_back(done); });
+    transfer->flush([&](uint64_t done, uint64_t) { flushed.push_back(done); });
+    CHECK(flushed.size() == 1 && flushed[0] == 5050);
+    tracker.end(transfer);
+}
+
+// Transfert réparti : plusieurs threads atteignent la fin en même temps
+static void testConcurrentEnd(ProgressTracker& tracker) {
+    tracker.setPublishRate(std::chrono::hours(1), 0);
+    auto transfer = tracker.begin("hôte", "/c", true);
+    std::atomic<int> finals(0);
+    ProgressCallback callback = transfer->wrap([&](uint64_t done, uint64_t size) {
+        if (done == size) ++finals;
+    });
+    callback(0, 4096);
+    std::vector<std::thread> threads;
+    for (int i = 0; i < 8; ++i) {
+        threads.emplace_back([&]() {
+            for (int j = 0; j < 1000; ++j) callback(4096, 4096);
+        });
+    }
+    for (std::thread& thread : threads) thread.join();
+    CHECK(finals == 1);
+    tracker.end(transfer);
+}
+
+static void testSnapshot(ProgressTracker& tracker) {
+    tracker.setPublishRate(std::chrono::hours(1), 0);
+    auto first = tracker.begin("un", "/d", true);
+    auto second = tracker.begin("deux", "/e", false);
+    ProgressCallback callback = first->wrap(nullptr);
+
+    callback(0, 4 * 1024 * 1024);
+    std::this_thread::sleep_for(std::chrono::milliseconds(250));
+    callback(1024 * 1024, 4 * 1024 * 1024);
+
+    std::vector<TransferSnapshot> snapshots = tracker.snapshot();
+    CHECK(snapshots.size() == 2);
+    if (snapshots.size() == 2) {
+        // Dans l'ordre de leur début
+        CHECK(snapshots[0].id < snapshots[1].id);
+        CHECK(snapshots[0].host == "un" && snapshots[0].path == "/d" && snapshots[0].upload);
+        CHECK(snapshots[1].host == "deux" && !snapshots[1].upload);
+        CHECK(snapshots[0].transferred == 1024 * 1024);
+        CHECK(snapshots[0].total == 4 * 1024 * 1024);
+        CHECK(snapshots[0].elapsedSeconds >= 0.2);
+        // Environ 4 Mo/s, 3 Mo restants
+        CHECK(snapshots[0].bytesPerSecond > 1024 * 1024);
+        CHECK(snapshots[0].bytesPerSecond < 8 * 1024 * 1024);
+        CHECK(snapshots[0].secondsRemaining > 0 && snapshots[0].secondsRemaining < 3);
+        // Aucun octet : débit et temps restant inconnus
+        CHECK(snapshots[1].bytesPerSecond == 0);
+        CHECK(snapshots[1].secondsRemaining == -1);
+    }
+
+    tracker.end(first);
+    snapshots = tracker.snapshot();
+    CHECK(snapshots.size() == 1 && snapshots[0].path == "/e");
+    tracker.end(second);
+    CHECK(tracker.snapshot().empty());
+}
+
+int main() {
+    ProgressTracker& tracker = ProgressTracker::shared();
+    testInterval(tracker);
+    testMinBytes(tracker);
+    testConcurrentEnd(tracker);
+    testSnapshot(tracker);
+    tracker.setPublishRate(std::chrono::milliseconds(100), 64 * 1024);
+    return SCPClientTests::finish("ProgressTracker");
+}
@@ -0,0 +1,148 @@
+//
+//  RemoteListingTests.cpp
+//  SCP Client for macOS
+//
+//  Analyse des sorties `find -printf` et `ls -la`, reçues par morceaux
+//
+
+#include "RemoteListing.h"
+#include "TestSupport.h"
+#include <sys/stat.h>
+#include <ctime>
+#include <vector>
+
+using namespace SCPClient;
+
+static std::vector<RemoteFile> parse(const std::string& output, size_t chunk, uint64_t* count = nullptr) {
+    std::vector<RemoteFile> files;
+    ListingParser parser("/base", [&](const RemoteFile& file) { files.push_back(file); });
+    for (size_t offset = 0; offset < output.size(); offset += chunk) {
+        parser.feed(output.data() + offset, std::min(chunk, output.size() - offset));
+    }
+    parser.finish();
+    if (count) *count = parser.count();
+    return files;
+}
+
+static std::string field(const std::string& type, const std::string& mode, const std::string& size,
+                         const std::string& mtime, const std::string& name) {
+    return type + '\0' + mode + '\0' + size + '\0' + mtime + '\0' + name + '\0';
+}
+
+static void testFind() {
+    std::string output = field("d", "755", "4096", "1700000000.5000000000", ".") +
+                         field("f", "644", "12", "1700000001.0000000000", "a b.txt") +
+                         field("d", "2775", "4096", "1700000002.1", "sous dossier") +
+                         field("l", "777", "7", "1700000003.0", "lien") +
+                         field("f", "600", "0", "-86400.25", "avant 1970") +
+                         field("f", "644", "18446744073709551615", "1", "ligne\nsuivante") +
+                         field("s", "755", "0", "5", "socket");
+
+    for (size_t chunk : {(size_t)1, (size_t)3, (size_t)64, output.size()}) {
+        uint64_t count = 0;
+        std::vector<RemoteFile> files = parse(output, chunk, &count);
+        CHECK(files.size() == 6);
+        CHECK(count == 6);
+        if (files.size() != 6) continue;
+
+        CHECK(files[0].name == "a b.txt");
+        CHECK(files[0].path == "/base/a b.txt");
+        CHECK(files[0].size == 12);
+        CHECK(files[0].permissions == (S_IFREG | 0644));
+        CHECK(!files[0].isDirectory);
+        CHECK(files[0].modificationTime == 1700000001);
+
+        CHECK(files[1].isDirectory);
+        CHECK(files[1].permissions == (S_IFDIR | 02775));
+        CHECK(files[1].modificationTime == 1700000002);
+
+        CHECK(files[2].permissions == (S_IFLNK | 0777));
+        CHECK(files[3].modificationTime == -86400);
+        CHECK(files[4].name == "ligne\nsuivante");
+        CHECK(files[4].size == UINT64_MAX);
+        CHECK(files[5].permissions == (S_IFSOCK | 0755));
+    }
+}
+
+static void testLsEpoch() {
+    std::string output =
+        "\n@s\n"
+        "total 12\n"
+        "drwxr-xr-x  3 root root  4096 1792191593 .\n"
+        "drwxr-xr-x 10 root root  4096 1792191000 ..\n"
+        "-rw-r--r--  1 root root     5 981173106 a b\n"
+        "-rwsr-x--T  1 u    staff 1234 1700000000 setuid\n"
+        "lrwxrwxrwx  1 root root     5 1700000001 lnk -> cible avec -> flèche\n"
+        "crw-rw-rw-  1 root root  1,   3 1700000002 null\n"
+        "drwxr-x---  2 root root  4096 1700000003 sous dossier";
+
+    for (size_t chunk : {(size_t)1, (size_t)5, output.size()}) {
+        std::vector<RemoteFile> files = parse(output, chunk);
+        CHECK(files.size() == 5);
+        if (files.size() != 5) continue;
+
+        CHECK(files[0].name == "a b");
+        CHECK(files[0].path == "/base/a b");
+        CHECK(files[0].size == 5);
+        CHECK(files[0].modificationTime == 981173106);
+
+        CHECK(files[1].permissions == (S_IFREG | S_ISUID | 0750 | S_ISVTX));
+        CHECK(files[1].size == 1234);
+
+        CHECK(files[2].name == "lnk");
+        CHECK(files[2].permissions == (S_IFLNK | 0777));
+
+        CHECK(files[3].name == "null");
+        CHECK(files[3].permissions == (S_IFCHR | 0666));
+        CHECK(files[3].modificationTime == 1700000002);
+
+        // Dernière ligne sans retour à la ligne
+        CHECK(files[4].name == "sous dossier");
+        CHECK(files[4].isDirectory);
+        CHECK(files[4].modificationTime == 1700000003);
+    }
+}
+
+static int64_t localTime(int year, int month, int day, int hour, int minute) {
+    struct tm date = {};
+    date.tm_year = year - 1900;
+    date.tm_mon = month - 1;
+    date.tm_mday = day;
+    date.tm_hour = hour;
+    date.tm_min = minute;
+    date.tm_isdst = -1;
+    return (int64_t)mktime(&date);
+}
+
+static void testLsLocaleDates() {
+    time_t now = time(nullptr);
+    // Un mois plus tôt, à l'heure près : "HH:MM" de l'année de la date
+    time_t recent = now - 30 * 86400;
+    struct tm then;
+    localtime_r(&recent, &then);
+    static const char* months[] = {"Jan", "Feb", "Mar", "Apr", "May", "Jun",
+                                   "Jul", "Aug", "Sep", "Oct", "Nov", "Dec"};
+    char line[128];
+    snprintf(line, sizeof(line), "-rw-r--r-- 1 root root 10 %s %2d %02d:%02d recent\n",
+             months[then.tm_mon], then.tm_mday, then.tm_hour, then.tm_min);
+
+    std::string output = "\ntotal 8\n"
+                         "-rw-r--r-- 1 root root 3 Feb  3  2001 ancien\n" +
+                         std::string(line) +
+                         "-rw-r--r-- 1 root root 3 Foo  3  2001 illisible\n";
+    std::vector<RemoteFile> files = parse(output, 2);
+    CHECK(files.size() == 3);
+    if (files.size() != 3) return;
+
+    CHECK(files[0].modificationTime == localTime(2001, 2, 3, 0, 0));
+    CHECK(files[1].modificationTime == localTime(then.tm_year + 1900, then.tm_mon + 1, then.tm_mday,
+                                                  then.tm_hour, then.tm_min));
+    CHECK(files[2].modificationTime == 0);
+}
+
+int main() {
+    testFind();
+    testLsEpoch();
+    testLsLocaleDates();
+    return SCPClientTests::finish("RemoteListing");
+}
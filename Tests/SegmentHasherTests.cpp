@@ -0,0 +1,66 @@
+//
+//  SegmentHasherTests.cpp
+//  SCP Client for macOS
+//
+//  Empreintes par segments, identiques quel que soit le nombre de threads
+//
+
+#include "SegmentHasher.h"
+#include "TransferJournal.h"
+#include "TestSupport.h"
+#include <fcntl.h>
+
+using namespace SCPClient;
+using SCPClientTests::randomBytes;
+using SCPClientTests::TemporaryFile;
+
+static void testSegments() {
+    const uint64_t segment = SegmentHasher::segmentSize;
+    std::string content = randomBytes(2 * segment + 123, 10);
+
+    TemporaryFile file;
+    int fd = open(file.path.c_str(), O_RDWR | O_TRUNC);
+    CHECK(fd >= 0);
+    if (fd < 0) return;
+    CHECK(write(fd, content.data(), content.size()) == (ssize_t)content.size());
+
+    CHECK(SegmentHasher::segmentCount(0) == 0);
+    CHECK(SegmentHasher::segmentCount(segment) == 1);
+    CHECK(SegmentHasher::segmentCount(content.size()) == 3);
+
+    std::vector<std::string> expected;
+    for (uint64_t start = 0; start < content.size(); start += segment) {
+        std::string hex;
+        CHECK(sha256Range(fd, start, std::min<uint64_t>(segment, content.size() - start), hex));
+        expected.push_back(hex);
+    }
+
+    for (unsigned threads : {1u, 2u, 0u}) {
+        SegmentHasher hasher(fd, content.size(), threads);
+        CHECK(hasher.digests() == expected);
+    }
+
+    // Fichier plus court que la taille annoncée : aucune empreinte
+    SegmentHasher truncated(fd, content.size() + segment, 2);
+    CHECK(truncated.digests().empty());
+
+    // Détruit sans attendre les empreintes
+    { SegmentHasher abandoned(fd, content.size(), 2); }
+    close(fd);
+}
+
+static void testEmpty() {
+    TemporaryFile file;
+    int fd = open(file.path.c_str(), O_RDONLY);
+    CHECK(fd >= 0);
+    if (fd < 0) return;
+    SegmentHasher hasher(fd, 0);
+    CHECK(hasher.digests().empty());
+    close(fd);
+}
+
+int main() {
+    testSegments();
+    testEmpty();
+    return SCPClientTests::finish("SegmentHasher");
+}
@@ -0,0 +1,185 @@
+//
+//  SessionPoolTests.cpp
+//  SCP Client for macOS
+//
+//  Clés du pool (empreinte du secret), réutilisation, limite par hôte,
+//  keepalive et éviction des sessions inactives
+//
+
+#include "SessionPool.h"
+#include "TestSupport.h"
+#include <atomic>
+#include <set>
+#include <thread>
+
+using namespace SCPClient;
+
+static void testKeys() {
+    SessionCredentials credentials;
+    credentials.host = "example.org";
+    credentials.username = "u";
+    credentials.password = "secret";
+    SessionKey key = SessionKey::from(credentials, ProtocolType::SFTP);
+    CHECK(key.hostKey() == "example.org:22");
+    CHECK(key.secretDigest.size() == 32);
+    CHECK(key.secretDigest.find("secret") == std::string::npos);
+
+    SessionCredentials other = credentials;
+    other.password = "autre";
+    SessionKey otherKey = SessionKey::from(other, ProtocolType::SFTP);
+    CHECK(key < otherKey || otherKey < key);
+    CHECK(otherKey.hostKey() == key.hostKey());
+
+    // Longueurs préfixées : déplacer un caractère d'un champ à l'autre change la clé
+    SessionCredentials split = credentials;
+    split.password = "secre";
+    split.passphrase = "t";
+    CHECK(SessionKey::from(split, ProtocolType::SFTP).secretDigest != key.secretDigest);
+
+    // Le chemin de clé ne compte que pour l'authentification par clé
+    SessionCredentials path = credentials;
+    path.privateKeyPath = "/ailleurs";
+    SessionKey pathKey = SessionKey::from(path, ProtocolType::SFTP);
+    CHECK(!(key < pathKey) && !(pathKey < key));
+
+    SessionKey scpKey = SessionKey::from(credentials, ProtocolType::SCP);
+    CHECK(key < scpKey || scpKey < key);
+}
+
+static void testReuse(const SessionCredentials& credentials) {
+    SessionPool pool;
+    std::string error;
+    SCPSession* first = nullptr;
+    {
+        SessionPool::Lease lease = pool.acquire(credentials, ProtocolType::SFTP, &error);
+        CHECK(lease);
+        if (!lease) return;
+        first = lease.get();
+        CHECK(lease->isConnected());
+    }
+    CHECK(pool.idleCount() == 1);
+
+    SessionPool::Lease again = pool.acquire(credentials, ProtocolType::SFTP, &error);
+    CHECK(again.get() == first);
+    CHECK(pool.idleCount() == 0);
+
+    // Un mauvais mot de passe n'obtient pas la session authentifiée
+    again.reset();
+    SessionCredentials wrong = credentials;
+    wrong.password += "-faux";
+    CHECK(!pool.acquire(wrong, ProtocolType::SFTP, &error));
+    CHECK(!error.empty());
+    CHECK(pool.idleCount() == 1);
+}
+
+static void testHostLimit(const SessionCredentials& credentials) {
+    SessionPool pool;
+    pool.setMaxSessionsPerHost(2);
+    pool.setAcquireTimeout(1);
+    std::string error;
+
+    SessionPool::Lease a = pool.acquire(credentials, ProtocolType::SFTP, &error);
+    SessionPool::Lease b = pool.acquire(credentials, ProtocolType::SFTP, &error);
+    CHECK(a && b);
+    CHECK(!pool.acquire(credentials, ProtocolType::SFTP, &error, false));
+    CHECK(error.find("Too many sessions") == 0);
+
+    // Attente bornée, puis une place rendue pendant l'attente
+    std::thread releaser([&]() {
+        std::this_thread::sleep_for(std::chrono::milliseconds(200));
+        b.reset();
+    });
+    SessionPool::Lease c = pool.acquire(credentials, ProtocolType::SFTP, &error);
+    releaser.join();
+    CHECK(c);
+    CHECK(pool.idleCount() == 0);
+
+    // Autre clé du même hôte : la session inactive la plus ancienne est évincée
+    c.reset();
+    CHECK(pool.idleCount() == 1);
+    SessionPool::Lease scp = pool.acquire(credentials, ProtocolType::SCP, &error, false);
+    CHECK(scp);
+    CHECK(pool.idleCount() == 0);
+}
+
+static void testMaintenance(const SessionCredentials& credentials) {
+    SessionPool pool;
+    std::string error;
+    pool.acquire(credentials, ProtocolType::SFTP, &error).reset();
+    CHECK(pool.idleCount() == 1);
+
+    // Keepalive réussi : la session reste
+    pool.maintain();
+    CHECK(pool.idleCount() == 1);
+
+    // Un acquire pendant les keepalives reprend une session contrôlée, sans
+    // nouvelle connexion
+    std::set<SCPSession*> known;
+    {
+        std::vector<SessionPool::Lease> leases;
+        for (int i = 0; i < 6; ++i) {
+            leases.push_back(pool.acquire(credentials, ProtocolType::SFTP, &error));
+            known.insert(leases.back().get());
+        }
+    }
+    CHECK(pool.idleCount() == 6);
+    std::atomic<bool> done(false);
+    std::thread maintainer([&]() {
+        pool.maintain();
+        done = true;
+    });
+    while (!done && pool.idleCount() != 0) std::this_thread::yield();
+    SessionPool::Lease during = pool.acquire(credentials, ProtocolType::SFTP, &error);
+    maintainer.join();
+    CHECK(known.count(during.get()) == 1);
+    during.reset();
+    CHECK(pool.idleCount() == 6);
+
+    // Trop ancienne : fermée
+    pool.setIdleTimeout(0);
+    std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    pool.maintain();
+    CHECK(pool.idleCount() == 0);
+}
+
+// La session principale (empruntée en gardant ses identifiants) ouvre des
+// sessions annexes ; une session de travail ne le peut pas
+static void testSideLease(const SessionCredentials& credentials) {
+    SessionPool& pool = SessionPool::shared();
+    std::string error;
+    SCPClientTests::TemporaryFile local;
+    {
+        FILE* file = fopen(local.path.c_str(), "wb");
+        std::string data = SCPClientTests::randomBytes(1 << 20, 11);
+        CHECK(file && fwrite(data.data(), 1, data.size(), file) == data.size());
+        if (file) fclose(file);
+    }
+    std::string remote = "/tmp/scpclient-test-side-" + std::to_string(getpid());
+
+    SessionPool::Lease main = pool.acquire(credentials, ProtocolType::SFTP, &error, true, true);
+    CHECK(main);
+    if (!main) return;
+    bool striped = main->uploadFileStriped(local.path, remote, 2);
+    if (!striped) fprintf(stderr, "bandes : %s\n", main->getLastError().c_str());
+    CHECK(striped);
+    CHECK(main->deleteFile(remote));
+    main.reset();
+
+    SessionPool::Lease worker = pool.acquire(credentials, ProtocolType::SFTP, &error);
+    CHECK(worker);
+    if (!worker) return;
+    CHECK(!worker->uploadFileStriped(local.path, remote, 2));
+    CHECK(worker->getLastError().find("Credentials no longer available") != std::string::npos);
+}
+
+int main() {
+    testKeys();
+
+    SessionCredentials credentials;
+    if (!SCPClientTests::testServer(credentials)) return SCPClientTests::skip("SessionPool");
+    testReuse(credentials);
+    testHostLimit(credentials);
+    testMaintenance(credentials);
+    testSideLease(credentials);
+    return SCPClientTests::finish("SessionPool");
+}
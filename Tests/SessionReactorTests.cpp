@@ -0,0 +1,139 @@
+//
+//  SessionReactorTests.cpp
+//  SCP Client for macOS
+//
+//  Attente du socket et réveil ; commandes et listages concurrents sur une
+//  seule session pilotée par le réacteur
+//
+
+#include "SessionReactor.h"
+#include "DirectoryListing.h"
+#include "SCPSession.h"
+#include "TestSupport.h"
+#include <sys/socket.h>
+#include <atomic>
+#include <thread>
+#include <vector>
+
+using namespace SCPClient;
+
+using Clock = std::chrono::steady_clock;
+
+static double millisecondsSince(Clock::time_point start) {
+    return std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+}
+
+static void testWaiter() {
+    int pair[2];
+    CHECK(socketpair(AF_UNIX, SOCK_STREAM, 0, pair) == 0);
+    {
+        SocketWaiter waiter(pair[0]);
+
+        // Rien à lire : délai écoulé
+        Clock::time_point start = Clock::now();
+        waiter.wait(LIBSSH2_SESSION_BLOCK_INBOUND, 50);
+        double elapsed = millisecondsSince(start);
+        CHECK(elapsed >= 40);
+        CHECK(elapsed < 1000);
+
+        // Données arrivées : retour immédiat
+        CHECK(write(pair[1], "x", 1) == 1);
+        start = Clock::now();
+        waiter.wait(LIBSSH2_SESSION_BLOCK_INBOUND, 5000);
+        CHECK(millisecondsSince(start) < 1000);
+        char byte;
+        CHECK(read(pair[0], &byte, 1) == 1);
+
+        // Socket inscriptible
+        start = Clock::now();
+        waiter.wait(LIBSSH2_SESSION_BLOCK_OUTBOUND, 5000);
+        CHECK(millisecondsSince(start) < 1000);
+
+        // Réveil depuis un autre thread, puis réveil en attente consommé
+        std::thread waker([&]() {
+            std::this_thread::sleep_for(std::chrono::milliseconds(50));
+            waiter.wake();
+        });
+        start = Clock::now();
+        waiter.wait(LIBSSH2_SESSION_BLOCK_INBOUND, 5000);
+        waker.join();
+        CHECK(millisecondsSince(start) < 1000);
+
+        waiter.wake();
+        waiter.wait(LIBSSH2_SESSION_BLOCK_INBOUND, 5000);
+        start = Clock::now();
+        waiter.wait(LIBSSH2_SESSION_BLOCK_INBOUND, 50);
+        CHECK(millisecondsSince(start) >= 40);
+    }
+    close(pair[0]);
+    close(pair[1]);
+}
+
+// stdout et stderr volumineux à la fois : aucun interblocage de fenêtre
+static void testConcurrent(SCPSession& session) {
+    const std::string command =
+        "head -c 400000 /dev/zero | tr '\\0' o; head -c 300000 /dev/zero | tr '\\0' e >&2; exit 4";
+    std::atomic<int> failed(0);
+    std::vector<std::thread> threads;
+    for (int i = 0; i < 4; ++i) {
+        threads.emplace_back([&]() {
+            size_t out = 0, err = 0;
+            bool clean = true;
+            int status = -1;
+            bool ok = session.executeCommand(command, [&](const char* data, size_t length, bool isStderr) {
+                for (size_t j = 0; j < length; ++j) clean = clean && data[j] == (isStderr ? 'e' : 'o');
+                (isStderr ? err : out) += length;
+                return true;
+            }, &status);
+            if (!ok || status != 4 || out != 400000 || err != 300000 || !clean) ++failed;
+        });
+    }
+    threads.emplace_back([&]() {
+        for (int i = 0; i < 5; ++i) {
+            DirectoryListing listing;
+            if (!session.listDirectory("/", listing) || listing.empty()) ++failed;
+        }
+    });
+    for (std::thread& thread : threads) thread.join();
+    CHECK(failed == 0);
+}
+
+static void testCancel(SCPSession& session) {
+    std::atomic<bool> cancel(false);
+    CommandOptions options;
+    options.cancel = &cancel;
+    std::thread canceller([&]() {
+        std::this_thread::sleep_for(std::chrono::milliseconds(200));
+        cancel = true;
+    });
+    Clock::time_point start = Clock::now();
+    bool ok = session.executeCommand("sleep 30", [](const char*, size_t, bool) { return true; },
+                                     nullptr, options);
+    canceller.join();
+    CHECK(!ok);
+    CHECK(millisecondsSince(start) < 5000);
+
+    // La session reste utilisable
+    int status = -1;
+    CHECK(session.executeCommand("true", [](const char*, size_t, bool) { return true; }, &status));
+    CHECK(status == 0);
+}
+
+int main() {
+    testWaiter();
+
+    SessionCredentials credentials;
+    if (!SCPClientTests::testServer(credentials)) return SCPClientTests::skip("SessionReactor");
+    SCPSession session;
+    session.setProtocol(ProtocolType::SFTP);
+    session.setNonBlocking(true);
+    bool connected = session.connect(credentials);
+    if (!connected) fprintf(stderr, "connexion : %s\n", session.getLastError().c_str());
+    CHECK(connected);
+    if (connected) {
+        CHECK(session.isNonBlocking());
+        testConcurrent(session);
+        testCancel(session);
+    }
+    return SCPClientTests::finish("SessionReactor");
+}
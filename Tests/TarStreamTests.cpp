@@ -0,0 +1,100 @@
+//
+//  TarStreamTests.cpp
+//  SCP Client for macOS
+//
+//  Aller-retour TarWriter -> TarReader, lu par morceaux de toutes tailles
+//
+
+#include "TarStream.h"
+#include "TestSupport.h"
+#include <vector>
+
+using namespace SCPClient;
+using SCPClientTests::randomBytes;
+
+struct ReadEntry {
+    TarEntry entry;
+    std::string data;
+    bool ended = false;
+};
+
+static std::string archive(const std::vector<std::pair<TarEntry, std::string>>& entries) {
+    std::string out;
+    for (const auto& item : entries) {
+        out += TarWriter::header(item.first);
+        out += item.second;
+        out.append(TarWriter::padding(item.second.size()), '\0');
+    }
+    return out + TarWriter::trailer();
+}
+
+static bool readArchive(const std::string& data, size_t chunk, std::vector<ReadEntry>& read) {
+    read.clear();
+    TarReader reader([&](const TarEntry& entry) {
+        read.push_back({entry, "", false});
+        return true;
+    }, [&](const char* bytes, size_t length) {
+        read.back().data.append(bytes, length);
+        return true;
+    }, [&]() {
+        read.back().ended = true;
+        return true;
+    });
+    for (size_t offset = 0; offset < data.size(); offset += chunk) {
+        if (!reader.feed(data.data() + offset, std::min(chunk, data.size() - offset))) return false;
+    }
+    return reader.finished();
+}
+
+static void testRoundTrip() {
+    std::string longName = "dossier/" + std::string(150, 'n') + "/fichier.bin";
+    std::vector<std::pair<TarEntry, std::string>> entries;
+    entries.push_back({{"dossier", 0, 0755, 1700000000, '5'}, ""});
+    entries.push_back({{"dossier/vide.txt", 0, 0600, 1700000001, '0'}, ""});
+    entries.push_back({{"dossier/a b.txt", 5, 0644, 1700000002, '0'}, "hello"});
+    std::string big = randomBytes(3 * TarWriter::blockSize + 17, 1);
+    entries.push_back({{longName, big.size(), 0640, 1700000003, '0'}, big});
+    std::string exact = randomBytes(TarWriter::blockSize, 2);
+    entries.push_back({{"dossier/bloc", exact.size(), 0644, 1700000004, '0'}, exact});
+    std::string data = archive(entries);
+    CHECK(data.size() % TarWriter::blockSize == 0);
+
+    for (size_t chunk : {(size_t)1, (size_t)7, (size_t)511, (size_t)512, (size_t)4096, data.size()}) {
+        std::vector<ReadEntry> read;
+        CHECK(readArchive(data, chunk, read));
+        CHECK(read.size() == entries.size());
+        for (size_t i = 0; i < read.size() && i < entries.size(); ++i) {
+            const TarEntry& expected = entries[i].first;
+            CHECK(read[i].entry.name == expected.name);
+            CHECK(read[i].entry.type == expected.type);
+            CHECK(read[i].entry.size == expected.size);
+            CHECK(read[i].entry.mode == expected.mode);
+            CHECK(read[i].entry.mtime == expected.mtime);
+            CHECK(read[i].data == entries[i].second);
+        }
+    }
+}
+
+static void testCorruptHeader() {
+    std::string data = archive({{{"f", 3, 0644, 0, '0'}, "abc"}});
+    data[0] ^= 1;   // somme de contrôle fausse
+    std::vector<ReadEntry> read;
+    CHECK(!readArchive(data, data.size(), read));
+    CHECK(read.empty());
+}
+
+static void testCancel() {
+    std::string data = archive({{{"f", 3, 0644, 0, '0'}, "abc"}, {{"g", 1, 0644, 0, '0'}, "x"}});
+    TarReader reader([](const TarEntry&) { return true; },
+                     [](const char*, size_t) { return false; },
+                     []() { return true; });
+    CHECK(!reader.feed(data.data(), data.size()));
+    CHECK(reader.error == "Transfer cancelled");
+}
+
+int main() {
+    testRoundTrip();
+    testCorruptHeader();
+    testCancel();
+    return SCPClientTests::finish("TarStream");
+}
@@ -0,0 +1,93 @@
+//
+//  TestSupport.h
+//  SCP Client for macOS
+//
+//  Vérifications minimales des tests des composants, serveur SSH de test
+//
+
+#ifndef TestSupport_h
+#define TestSupport_h
+
+#include "SCPSession.h"
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+#include <unistd.h>
+
+namespace SCPClientTests {
+
+inline int& failures() {
+    static int count = 0;
+    return count;
+}
+
+// Fichier temporaire supprimé à la destruction
+struct TemporaryFile {
+    std::string path;
+
+    TemporaryFile() {
+        char name[] = "/tmp/scpclient-test-XXXXXX";
+        int fd = mkstemp(name);
+        if (fd >= 0) close(fd);
+        path = name;
+    }
+    ~TemporaryFile() { unlink(path.c_str()); }
+};
+
+// Contenu pseudo-aléatoire reproductible
+inline std::string randomBytes(size_t length, unsigned seed) {
+    std::string data(length, '\0');
+    uint32_t state = seed * 2654435761u + 1;
+    for (size_t i = 0; i < length; ++i) {
+        state = state * 1664525u + 1013904223u;
+        data[i] = (char)(state >> 24);
+    }
+    return data;
+}
+
+// Code de sortie d'un test ignoré (SKIP_RETURN_CODE de ctest)
+const int skipped = 77;
+
+// Serveur de test : SCPCLIENT_TEST_HOST, _PORT (22), _USER, _PASSWORD ;
+// faux si aucun hôte n'est donné
+inline bool testServer(SCPClient::SessionCredentials& credentials) {
+    const char* host = getenv("SCPCLIENT_TEST_HOST");
+    if (!host || !*host) return false;
+    const char* port = getenv("SCPCLIENT_TEST_PORT");
+    const char* user = getenv("SCPCLIENT_TEST_USER");
+    const char* password = getenv("SCPCLIENT_TEST_PASSWORD");
+    credentials.host = host;
+    credentials.port = port ? atoi(port) : 22;
+    credentials.username = user ? user : "";
+    credentials.password = password ? password : "";
+    return true;
+}
+
+inline int finish(const char* suite) {
+    if (failures() == 0) {
+        printf("%s : OK\n", suite);
+        return 0;
+    }
+    printf("%s : %d échec(s)\n", suite, failures());
+    return 1;
+}
+
+// Sans serveur de test : ignoré, sauf échec des tests hors réseau
+inline int skip(const char* suite) {
+    if (failures() != 0) return finish(suite);
+    printf("%s : SCPCLIENT_TEST_HOST absent, tests réseau ignorés\n", suite);
+    return skipped;
+}
+
+} // namespace SCPClientTests
+
+#define CHECK(condition)                                                          \
+    do {                                                                          \
+        if (!(condition)) {                                                       \
+            fprintf(stderr, "%s:%d: échec : %s\n", __FILE__, __LINE__, #condition); \
+            ++SCPClientTests::failures();                                         \
+        }                                                                         \
+    } while (0)
+
+#endif /* TestSupport_h */
@@ -0,0 +1,114 @@
+//
+//  TransferJournalTests.cpp
+//  SCP Client for macOS
+//
+//  Plages du journal de reprise, format texte et SHA-256 de plages locales
+//
+
+#include "TransferJournal.h"
+#include "TestSupport.h"
+#include <fcntl.h>
+
+using namespace SCPClient;
+using SCPClientTests::TemporaryFile;
+
+static bool sameRanges(const std::vector<JournalRange>& ranges,
+                       std::initializer_list<std::pair<uint64_t, uint64_t>> expected) {
+    if (ranges.size() != expected.size()) return false;
+    size_t i = 0;
+    for (const auto& range : expected) {
+        if (ranges[i].start != range.first || ranges[i].end != range.second) return false;
+        ++i;
+    }
+    return true;
+}
+
+static void testRanges() {
+    TransferJournal journal(1000, 1700000000);
+    journal.add(100, 200);
+    journal.add(300, 400);
+    journal.add(200, 250);     // contiguë : fusionnée
+    journal.add(350, 500);     // chevauchante
+    journal.add(0, 10);
+    CHECK(sameRanges(journal.ranges, {{0, 10}, {100, 250}, {300, 500}}));
+    CHECK(journal.completed() == 10 + 150 + 200);
+    CHECK(sameRanges(journal.missing(), {{10, 100}, {250, 300}, {500, 1000}}));
+
+    journal.add(5, 600);       // recouvre tout
+    CHECK(sameRanges(journal.ranges, {{0, 600}}));
+
+    journal.clip(400);
+    CHECK(sameRanges(journal.ranges, {{0, 400}}));
+    journal.add(500, 700);
+    journal.clip(450);         // plage entièrement au-delà : oubliée
+    CHECK(sameRanges(journal.ranges, {{0, 400}}));
+
+    TransferJournal empty(0, 0);
+    CHECK(empty.missing().empty());
+    CHECK(empty.completed() == 0);
+}
+
+static void testFormat() {
+    TransferJournal journal(1 << 20, -5);
+    journal.add(0, 4096);
+    journal.add(8192, 16384);
+
+    TransferJournal parsed;
+    CHECK(parsed.parse(journal.serialize()));
+    CHECK(parsed.sourceSize == journal.sourceSize);
+    CHECK(parsed.sourceMtime == -5);
+    CHECK(sameRanges(parsed.ranges, {{0, 4096}, {8192, 16384}}));
+    CHECK(parsed.sameSource(1 << 20, -5));
+    CHECK(!parsed.sameSource(1 << 20, -4));
+    CHECK(!parsed.sameSource(1, -5));
+
+    TransferJournal rejected;
+    CHECK(!rejected.parse(""));
+    CHECK(!rejected.parse("scp-resume 2\nsource 10 0\n"));
+    CHECK(!rejected.parse("scp-resume 1\n"));                                  // sans source
+    CHECK(!rejected.parse("scp-resume 1\nsource 10 0\nrange 5 20\n"));        // hors fichier
+    CHECK(!rejected.parse("scp-resume 1\nsource 10 0\nrange 5 5\n"));         // vide
+    CHECK(!rejected.parse("scp-resume 1\nsource 10 0\nautre chose\n"));
+
+    CHECK(TransferJournal::pathFor("/a/b.iso") == "/a/b.iso.scpresume");
+}
+
+static void testSaveLoad() {
+    TemporaryFile file;
+    TransferJournal journal(100, 42);
+    journal.add(10, 20);
+    CHECK(journal.save(file.path));
+
+    TransferJournal loaded;
+    CHECK(loaded.load(file.path));
+    CHECK(loaded.sameSource(100, 42));
+    CHECK(sameRanges(loaded.ranges, {{10, 20}}));
+
+    TransferJournal missing;
+    CHECK(!missing.load(file.path + ".absent"));
+}
+
+static void testSha256Range() {
+    TemporaryFile file;
+    int fd = open(file.path.c_str(), O_RDWR | O_TRUNC);
+    CHECK(fd >= 0);
+    if (fd < 0) return;
+    const std::string content = "xxabcyy";
+    CHECK(write(fd, content.data(), content.size()) == (ssize_t)content.size());
+
+    std::string hex;
+    CHECK(sha256Range(fd, 2, 3, hex));
+    CHECK(hex == "ba7816bf8f01cfea414140de5dae2223b00361a396177a9cb410ff61f20015ad");
+    CHECK(sha256Range(fd, 0, 0, hex));
+    CHECK(hex == "e3b0c44298fc1c149afbf4c8996fb92427ae41e4649b934ca495991b7852b855");
+    CHECK(!sha256Range(fd, 5, 10, hex));   // au-delà de la fin
+    close(fd);
+}
+
+int main() {
+    testRanges();
+    testFormat();
+    testSaveLoad();
+    testSha256Range();
+    return SCPClientTests::finish("TransferJournal");
+}
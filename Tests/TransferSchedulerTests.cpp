@@ -0,0 +1,96 @@
+//
+//  TransferSchedulerTests.cpp
+//  SCP Client for macOS
+//
+//  Seaux à jetons : débit propre d'un transfert, partage pondéré d'un seau
+//  d'hôte entre priorités
+//
+
+#include "TransferScheduler.h"
+#include "TestSupport.h"
+#include <atomic>
+#include <thread>
+
+using namespace SCPClient;
+
+using Clock = std::chrono::steady_clock;
+
+static double secondsSince(Clock::time_point start) {
+    return std::chrono::duration<double>(Clock::now() - start).count();
+}
+
+static void testUnlimited() {
+    auto transfer = TransferScheduler::shared().begin("illimite", TransferPriority::Normal, 0);
+    Clock::time_point start = Clock::now();
+    for (int i = 0; i < 1000; ++i) transfer->consume(1024 * 1024);
+    CHECK(transfer->tryConsume(1ull << 40));
+    CHECK(secondsSince(start) < 0.5);
+}
+
+static void testOwnLimit() {
+    const double rate = 4 * 1024 * 1024;
+    const uint64_t block = 64 * 1024;
+    const uint64_t total = 2 * 1024 * 1024;
+    auto transfer = TransferScheduler::shared().begin("propre", TransferPriority::Normal, (uint64_t)rate);
+
+    Clock::time_point start = Clock::now();
+    for (uint64_t done = 0; done < total; done += block) transfer->consume(block);
+    double elapsed = secondsSince(start);
+
+    // Rafale initiale de 1/8 s, puis un bloc d'avance au plus
+    double expected = (total - rate / 8 - block) / rate;
+    if (elapsed < 0.9 * expected || elapsed > expected + 1) {
+        fprintf(stderr, "débit propre : %.3f s pour %.3f s attendues\n", elapsed, expected);
+    }
+    CHECK(elapsed >= 0.9 * expected);
+    CHECK(elapsed <= expected + 1);
+
+    // Seau vidé : le réacteur doit attendre
+    transfer->consume(rate);
+    CHECK(!transfer->tryConsume(block));
+}
+
+static void testWeightedShare() {
+    const uint64_t block = 16 * 1024;
+    TransferScheduler& scheduler = TransferScheduler::shared();
+    scheduler.setHostLimit("partage", 2 * 1024 * 1024);
+
+    std::atomic<bool> stop(false);
+    std::atomic<uint64_t> interactive(0), bulk(0);
+    auto run = [&](TransferPriority priority, std::atomic<uint64_t>& bytes) {
+        auto transfer = scheduler.begin("partage", priority, 0);
+        while (!stop) {
+            transfer->consume(block);
+            bytes += block;
+        }
+    };
+
+    Clock::time_point start = Clock::now();
+    std::thread first(run, TransferPriority::Interactive, std::ref(interactive));
+    std::thread second(run, TransferPriority::Bulk, std::ref(bulk));
+    std::this_thread::sleep_for(std::chrono::seconds(1));
+    stop = true;
+    first.join();
+    second.join();
+    double elapsed = secondsSince(start);
+    scheduler.setHostLimit("partage", 0);
+
+    // Rafale de 256 Ko puis 2 Mo/s, réparties à 8 contre 1
+    double ceiling = 2 * 1024 * 1024 * elapsed + 256 * 1024 + 2 * block;
+    uint64_t sum = interactive + bulk;
+    if (interactive < 3 * bulk) {
+        fprintf(stderr, "partage : interactif %llu, fond %llu\n",
+                (unsigned long long)interactive, (unsigned long long)bulk);
+    }
+    CHECK((double)sum <= ceiling);
+    CHECK((double)sum >= 0.7 * 2 * 1024 * 1024 * elapsed);
+    CHECK(bulk > 0);
+    CHECK(interactive >= 3 * bulk);
+}
+
+int main() {
+    testUnlimited();
+    testOwnLimit();
+    testWeightedShare();
+    return SCPClientTests::finish("TransferScheduler");
+}